@@ -89,6 +89,11 @@ local JValueNativeFuncs = retrieveNativeFunctions('JValue',
 
       shallowCopy = {'handle', 'handle'},
       deepCopy = {'handle', 'handle'},
+
+      filterFlt = {'handle', 'handle, cstring, cstring, float'},
+      filterStr = {'handle', 'handle, cstring, cstring, cstring'},
+      project = {'handle', 'handle, cstring'},
+      groupBy = {'handle', 'handle, cstring'},
     }
   )
 
@@ -96,6 +101,7 @@ local JArrayNativeFuncs = retrieveNativeFunctions('JArray',
     {
       object = {'handle'},
       objectWithSize = {'handle', 'uint32_t'},
+      sortBy = {'handle', 'handle, cstring, bool'},
       --getInt = {'int32_t', 'handle, index, int32_t'},
       --getFlt = {'float', 'handle, index, float'},
       --setInt = {'void', 'handle, index, int32_t'},
@@ -121,6 +127,23 @@ local JFormMapNativeFuncs = retrieveNativeFunctions('JFormMap',
       allValues = {'handle', 'handle'},
     }
   )
+
+local JTransactionNativeFuncs = retrieveNativeFunctions('JTransaction',
+    {
+      create = {'int32_t'},
+      setInt = {'bool', 'int32_t, handle, cstring, int32_t'},
+      setFlt = {'bool', 'int32_t, handle, cstring, float'},
+      setStr = {'bool', 'int32_t, handle, cstring, cstring'},
+      setObj = {'bool', 'int32_t, handle, cstring, handle'},
+      addInt = {'bool', 'int32_t, handle, int32_t'},
+      addFlt = {'bool', 'int32_t, handle, float'},
+      addStr = {'bool', 'int32_t, handle, cstring'},
+      addObj = {'bool', 'int32_t, handle, handle'},
+      removeKey = {'bool', 'int32_t, handle, cstring'},
+      commit = {'int32_t', 'int32_t'},
+      cancel = {'bool', 'int32_t'},
+    }
+  )
 ----------------------------------------
 
 -- Tables
@@ -297,6 +320,23 @@ function JValue.solvePath(optr, path)
   return returnLuaValue(jclib.JValue_solvePath(jc_context, optr.___id, path))
 end
 
+-- returns a new JArray of the values whose value at the path compares to the value (a number or a string)
+-- comparison is one of '==', '!=', '<', '<=', '>', '>='. Example: JValue.filter(records, '.level', '>', 10)
+function JValue.filter(optr, path, comparison, value)
+  local filter = type(value) == 'string' and JValueNativeFuncs.filterStr or JValueNativeFuncs.filterFlt
+  return wrapJCHandle(filter(jc_context, optr.___id, path, comparison, value))
+end
+
+-- returns a new JArray of the values at the path of each value
+function JValue.project(optr, path)
+  return wrapJCHandle(JValueNativeFuncs.project(jc_context, optr.___id, path))
+end
+
+-- returns a new JMap of {key: JArray of the values having that key at the path}
+function JValue.groupBy(optr, path)
+  return wrapJCHandle(JValueNativeFuncs.groupBy(jc_context, optr.___id, path))
+end
+
 -- JArray
 do
   -- converts 1-based positive indexes to 0-based, doesn't change negative ones
@@ -318,6 +358,12 @@ do
     return object
   end
 
+  -- sorts the array by the values at the comma-separated paths: JArray.sortBy(records, '.level, .name')
+  function JArray.sortBy(optr, paths, descending)
+    JArrayNativeFuncs.sortBy(jc_context, optr.___id, paths, descending or false)
+    return optr
+  end
+
   function JArray.insert(optr, value, idx)
     jclib.JArray_insert(optr.___id, returnJCValue(value), convertIndex(idx or -1))
   end
@@ -438,6 +484,52 @@ do
     return wrapJCHandle(JFormMapNativeFuncs.allValues(jc_context, optr.___id))
   end
 end
+---------------------------------------
+-- Transactions: JMap/JArray changes applied at once, one lock per container
+local JTransaction = {}
+do
+  -- picks Int, Flt, Str or Obj native function variant by the Lua value type
+  local function typeSuffix(value)
+    local tp = type(value)
+    if tp == 'number' then
+      return 'Flt', value
+    elseif tp == 'string' then
+      return 'Str', value
+    elseif tp == 'boolean' then
+      return 'Int', value and 1 or 0
+    elseif ffi.istype(CArray, value) or ffi.istype(CMap, value) or ffi.istype(CFormMap, value) then
+      return 'Obj', value.___id
+    end
+    error('JTransaction: unsupported value type ' .. tp)
+  end
+
+  function JTransaction.create()
+    return JTransactionNativeFuncs.create(jc_context)
+  end
+
+  function JTransaction.set(tx, map, key, value)
+    local suffix, v = typeSuffix(value)
+    return JTransactionNativeFuncs['set' .. suffix](jc_context, tx, map.___id, key, v)
+  end
+
+  function JTransaction.add(tx, array, value)
+    local suffix, v = typeSuffix(value)
+    return JTransactionNativeFuncs['add' .. suffix](jc_context, tx, array.___id, v)
+  end
+
+  function JTransaction.removeKey(tx, map, key)
+    return JTransactionNativeFuncs.removeKey(jc_context, tx, map.___id, key)
+  end
+
+  -- returns the number of the applied operations, -1 if there is no such transaction
+  function JTransaction.commit(tx)
+    return JTransactionNativeFuncs.commit(jc_context, tx)
+  end
+
+  function JTransaction.cancel(tx)
+    return JTransactionNativeFuncs.cancel(jc_context, tx)
+  end
+end
 --------------------------------------- 
 
 -- Associate CTypes with metatables
@@ -465,6 +557,7 @@ return {
       JArray = JArray,
       JMap = JMap,
       JFormMap = JFormMap,
+      JTransaction = JTransaction,
       JDB = wrapJCHandle(jclib.JDB_instance(JConstants.Context)),
 
       Form = CForm,
@@ -20,5 +20,6 @@ namespace tes_api_3 {
 #include "api_3/tes_string.h"
 #include "api_3/tes_form_db.h"
 #include "api_3/tes_lua.h"
+#include "api_3/tes_transaction.h"
 
 #include "api_3/tests.hpp"
@@ -13,6 +13,7 @@
 #include <boost/optional.hpp>
 
 #include <shlobj.h>
+#include <crtdbg.h>
 
 #include "gtest.h"
 #include "util/util.h"
@@ -28,8 +29,11 @@
 #include "collections/collections.h"
 
 #include "collections/json_serialization.h"
+#include "collections/binary_serialization.h"
 #include "collections/copying.h"
 #include "collections/access.h"
+#include "collections/path_compiler.h"
+#include "collections/query.h"
 
 #include "collections/bind_traits.h"
 #include "collections/tests.h"
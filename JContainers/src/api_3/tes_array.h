@@ -178,6 +178,7 @@ NEGATIVE_IDX_COMMENT);
         static void replaceItemAtIndex(tes_context& ctx, ref obj, Index index, T val) {
             doReadOp(obj, index, [=](uint32_t idx) {
                 obj->_array[idx] = item(val);
+                obj->u_changed(item((SInt32)idx));
             });
         }
         REGISTERF(replaceItemAtIndex<SInt32>, "setInt", "* index value", "Replaces existing value at the @index of the array with the new @value.\n"
@@ -213,6 +214,7 @@ If @addToIndex >= 0 it inserts value at given index. " NEGATIVE_IDX_COMMENT);
         static void eraseIndex(tes_context& ctx, ref obj, SInt32 index) {
             doReadOp(obj, index, [=](uint32_t idx) {
                 obj->_array.erase(obj->begin() + idx);
+                obj->u_changed();
             });
         }
         REGISTERF2(eraseIndex, "* index", "Erases the item at the index. "NEGATIVE_IDX_COMMENT);
@@ -227,6 +229,7 @@ If @addToIndex >= 0 it inserts value at given index. " NEGATIVE_IDX_COMMENT);
             doReadOp(obj, pyIndexes, [=](const std::array<uint32_t, 2>& indices) {
                 if (indices[0] <= indices[1]) {
                     obj->_array.erase(obj->begin() + indices[0], obj->begin() + indices[1] + 1);
+                    obj->u_changed();
                 }
             });
         }
@@ -250,6 +253,8 @@ If @addToIndex >= 0 it inserts value at given index. " NEGATIVE_IDX_COMMENT);
 
                 if (indices[0] != indices[1]) {
                     std::swap(obj->u_container()[indices[0]], obj->u_container()[indices[1]]);
+                    obj->u_changed(item((SInt32)indices[0]));
+                    obj->u_changed(item((SInt32)indices[1]));
                 }
             });
         }
@@ -259,6 +264,7 @@ If @addToIndex >= 0 it inserts value at given index. " NEGATIVE_IDX_COMMENT);
             if (obj) {
                 object_lock g(obj);
                 std::sort(obj->u_container().begin(), obj->u_container().end());
+                obj->u_changed();
             }
             return obj;
         }
@@ -270,11 +276,143 @@ If @addToIndex >= 0 it inserts value at given index. " NEGATIVE_IDX_COMMENT);
                 std::sort(obj->u_container().begin(), obj->u_container().end());
                 auto newEnd = std::unique(obj->u_container().begin(), obj->u_container().end());
                 obj->u_container().erase(newEnd, obj->u_container().end());
+                obj->u_changed();
             }
             return obj;
         }
         REGISTERF2(unique, "*", "Sorts the items, removes duplicates. Returns array itself. You can treat it as JSet now");
 
+        // runs @-operator over the array, same as path resolving does
+        template<class T>
+        static T aggregate(tes_context& ctx, ref obj, const char *operatorPath) {
+            return path_resolving::_resolve<T>(ctx, obj, operatorPath);
+        }
+
+        static Float32 sum(tes_context& ctx, ref obj) { return aggregate<Float32>(ctx, obj, "@sum"); }
+        REGISTERF2(sum, "*", "Returns sum of the numbers (int or float) in the array. Non-numeric items are skipped. Same as JValue.solveFlt(array, \"@sum\")");
+
+        static Float32 avg(tes_context& ctx, ref obj) { return aggregate<Float32>(ctx, obj, "@avg"); }
+        REGISTERF2(avg, "*", "Returns average of the numbers in the array or 0.0 if there are no numbers");
+
+        static Float32 product(tes_context& ctx, ref obj) { return aggregate<Float32>(ctx, obj, "@product"); }
+        REGISTERF2(product, "*", "Returns product of the numbers in the array or 0.0 if there are no numbers");
+
+        static object_base* histogram(tes_context& ctx, ref obj) { return aggregate<object_base*>(ctx, obj, "@histogram"); }
+        REGISTERF2(histogram, "*", "Returns a new JIntMap of {number: count} pairs, where number is a number from the array rounded down.\n"
+            "Returns 0 if there are no numbers in the array");
+
+        // not an @-operator: path operators take no arguments, so counting of a given value is API-only
+        template<class T>
+        static SInt32 countOf(tes_context& ctx, ref obj, T value) {
+            if (!obj) {
+                return 0;
+            }
+
+            object_lock g(obj);
+            return std::count(obj->u_container().begin(), obj->u_container().end(), item(value));
+        }
+        REGISTERF(countOf<SInt32>, "countOfInt", "* value", "Returns count of the items equal to the @value/@container.\n"
+            "Unlike sum, avg and the others, there is no path operator for it: use @count to count all the items");
+        REGISTERF(countOf<Float32>, "countOfFlt", "* value", "");
+        REGISTERF(countOf<const char *>, "countOfStr", "* value", "");
+        REGISTERF(countOf<object_base*>, "countOfObj", "* container", "");
+        REGISTERF(countOf<form_ref>, "countOfForm", "* value", "");
+
+        static ref sortBy(tes_context& ctx, ref obj, const char *paths, bool descending = false) {
+            if (obj) {
+                query::sort_by(ctx, *obj, paths, descending);
+            }
+            return obj;
+        }
+        REGISTERF2(sortBy, "* paths descending=false",
+            "Sorts the items by their values at the comma-separated @paths, for ex. \".level, .name\" - the second path breaks ties of the first one.\n"
+            "The sort is stable. Items without a value go first, then numbers, forms, containers and strings. Returns the array itself");
+
+        template<class T>
+        static VMResultArray<reflection::binding::convert_to_tes_type<T>> getRange(
+            tes_context& ctx, ref obj, SInt32 startIndex = 0, SInt32 endIndex = -1, T def = default_value<T>())
+        {
+            using converter = reflection::binding::get_converter<T>;
+
+            VMResultArray<reflection::binding::convert_to_tes_type<T>> results;
+            if (!obj) {
+                return results;
+            }
+
+            object_lock g(obj);
+            const auto fstIdx = convertReadIndex(obj, startIndex);
+            const auto lstIdx = convertReadIndex(obj, endIndex);
+            if (!(fstIdx && lstIdx && *fstIdx >= 0 && *fstIdx <= *lstIdx)) {
+                return results;
+            }
+
+            results.reserve(*lstIdx - *fstIdx + 1);
+            for (auto idx = *fstIdx; idx <= *lstIdx; ++idx) {
+                const item& itm = obj->_array[idx];
+                results.push_back(itm.isNull() ? converter::convert2Tes(def) : converter::convert2Tes(itm.readAs<T>()));
+            }
+            return results;
+        }
+        REGISTERF(getRange<SInt32>, "getIntRange", "* startIndex=0 endIndex=-1 default=0",
+            "Returns an array of the items in range [startIndex, endIndex], by default all the items. None items are replaced with @default.\n"
+            "Same as a getInt call per index, but a single native call and the array gets locked once. " NEGATIVE_IDX_COMMENT);
+        REGISTERF(getRange<Float32>, "getFltRange", "* startIndex=0 endIndex=-1 default=0.0", nullptr);
+        REGISTERF(getRange<skse::string_ref>, "getStrRange", "* startIndex=0 endIndex=-1 default=\"\"", nullptr);
+        REGISTERF(getRange<Handle>, "getObjRange", "* startIndex=0 endIndex=-1 default=0", nullptr);
+        REGISTERF(getRange<form_ref>, "getFormRange", "* startIndex=0 endIndex=-1 default=None", nullptr);
+
+        // writes the @values starting at the @startIndex under a single lock, replacing existing items and appending the rest.
+        // Returns the number of the written values
+        template<class T>
+        static SInt32 setValues(ref obj, const std::vector<T>& values, SInt32 startIndex = 0) {
+            if (!obj) {
+                return 0;
+            }
+
+            object_lock g(obj);
+            const auto fstIdx = convertWriteIndex(obj, startIndex);
+            if (!fstIdx || *fstIdx < 0) {
+                return 0;
+            }
+
+            const int32_t count = obj->u_count();
+            int32_t idx = *fstIdx;
+            for (const auto& value : values) {
+                if (idx < count) {
+                    obj->u_set(idx, item(value));
+                }
+                else {
+                    obj->u_push(item(value));
+                }
+                ++idx;
+            }
+            return (SInt32)values.size();
+        }
+
+        template<class T>
+        static SInt32 setRange(tes_context& ctx, ref obj, VMArray<reflection::binding::convert_to_tes_type<T>> values, SInt32 startIndex = 0) {
+            using converter = reflection::binding::get_converter<T>;
+
+            // the Papyrus values keep the storage of strings
+            std::vector<reflection::binding::convert_to_tes_type<T>> tesValues(values.Length());
+            std::vector<T> jvalues;
+            jvalues.reserve(values.Length());
+            for (UInt32 i = 0; i < values.Length(); ++i) {
+                values.Get(&tesValues[i], i);
+                jvalues.push_back(converter::convert2J(tesValues[i], ctx));
+            }
+
+            return setValues(obj, jvalues, startIndex);
+        }
+        REGISTERF(setRange<SInt32>, "setIntRange", "* values startIndex=0",
+            "Writes the @values into the array starting at the @startIndex: replaces existing items, appends the values past the end.\n"
+            "Returns the number of the written values. Same as a setInt call per index, but a single native call and the array gets locked once.\n"
+            "startIndex -1 appends all the values. " NEGATIVE_IDX_COMMENT);
+        REGISTERF(setRange<Float32>, "setFltRange", "* values startIndex=0", nullptr);
+        REGISTERF(setRange<const char*>, "setStrRange", "* values startIndex=0", nullptr);
+        REGISTERF(setRange<object_base*>, "setObjRange", "* containers startIndex=0", nullptr);
+        REGISTERF(setRange<form_ref>, "setFormRange", "* values startIndex=0", nullptr);
+
         template<
             typename ValueType,
             typename TesValueType = reflection::binding::convert_to_tes_type<ValueType>,
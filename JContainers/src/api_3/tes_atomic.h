@@ -25,27 +25,52 @@ namespace tes_api_3 {
             T previousVal = default_value<T>();
             bool assing_succeed = true;
 
-            using internal_item_type = typename item::user2variant_t<T>;
-
-            bool succeed = ca::visit_value(
+            bool succeed = ca::modify_value(
                 *obj, path,
                 createMissingKeys ? ca::creative : ca::constant,
                 [&](item& item_value) {
-                    if (item_value.isNull()) {
-                        item_value = func(initialValue, inputValue);
-                    }
-                    else if (internal_item_type *asT = item_value.get<internal_item_type>()) {
-                        previousVal = const_cast<const internal_item_type&>(*asT);
-                        *asT = func(const_cast<const internal_item_type&>(*asT), inputValue);
-                    }
-                    else {
-                        assing_succeed = false;
-                    }
+                    assing_succeed = u_applyFunction(item_value, func, inputValue, initialValue, previousVal);
                 });
 
             return (succeed && assing_succeed) ? previousVal : onError;
         }
 
+        // false if the value has another type
+        template<class T, class F>
+        static bool u_applyFunction(item& item_value, F&& func, const T& inputValue, const T& initialValue, T& previousVal) {
+            using internal_item_type = typename item::user2variant_t<T>;
+
+            if (item_value.isNull()) {
+                item_value = func(initialValue, inputValue);
+            }
+            else if (internal_item_type *asT = item_value.get<internal_item_type>()) {
+                previousVal = const_cast<const internal_item_type&>(*asT);
+                *asT = func(const_cast<const internal_item_type&>(*asT), inputValue);
+            }
+            else {
+                return false;
+            }
+            return true;
+        }
+
+        template<class T>
+        static void u_compareExchange(item& itemValue, T& newValue, const T& comparer, T& previousVal) {
+            if (itemValue == comparer) {
+
+                if (auto* valuePtr = itemValue.get<T>()) {
+                    previousVal = std::move(*valuePtr);
+                }
+
+                itemValue = std::move(newValue);
+            } else {
+
+                if (const auto* valuePtr = itemValue.get<T>()) {
+                    previousVal = *valuePtr;
+                }
+
+            }
+        }
+
         struct ignore_first {
             template<class T, class D>
             T&& operator()(const D&, T&& newValue) const {
@@ -81,24 +106,11 @@ namespace tes_api_3 {
                 return onError;
 
             T previousVal = default_value<T>();
-            bool succeed = ca::visit_value(
+            bool succeed = ca::modify_value(
                 *obj, path,
                 createMissingKeys ? ca::creative : ca::constant,
                 [&](item& itemValue) {
-                    if (itemValue == comparer) {
-
-                        if (auto* valuePtr = itemValue.get<T>()) {
-                            previousVal = std::move(*valuePtr);
-                        }
-
-                        itemValue = std::move(newValue);
-                    } else {
-
-                        if (const auto* valuePtr = itemValue.get<T>()) {
-                            previousVal = *valuePtr;
-                        }
-
-                    }
+                    u_compareExchange(itemValue, newValue, comparer, previousVal);
                 });
 
             return succeed ? previousVal : onError;
@@ -164,6 +176,81 @@ If @createMissingKeys is True, the function attemps to create missing @path elem
         REGISTERF(compareExchange<object_base*>, "compareExchangeObj", PARAMS_INT "0", nullptr);
 #   undef PARAMS_INT
 
+        //////////////////////////////////////////////////////////////////////////
+
+        static SInt32 getSlot(tes_context& ctx, object_base* obj, const char* path, bool createMissingKeys = false) {
+            if (!obj || !path) {
+                return 0;
+            }
+            return ctx.atomic_slots.make(ctx, *obj, path, createMissingKeys);
+        }
+        REGISTERF2(getSlot, "object path createMissingKeys=false",
+"Slot functions:\n\
+\n\
+Resolves the @path once and returns a slot - an identifier of the value location, or 0 if the path can't be resolved.\n\
+The slot* functions below are the same as the functions above, but work with the slot instead of the object and path, skipping the path resolving.\n\
+The slot doesn't retain the object: if the object (or the container holding the value) gets destroyed, the slot functions return @onErrorReturn.\n\
+If the value's key gets removed and added back, the slot finds it again. Slots are not saved, get them again after the game load");
+
+        static bool releaseSlot(tes_context& ctx, SInt32 slot) {
+            return ctx.atomic_slots.release(slot);
+        }
+        REGISTERF2(releaseSlot, "slot", "Frees the slot. There may be up to 65536 slots");
+
+        template<class T, class F>
+        static T slotFunction(tes_context& ctx, SInt32 slot, T inputValue, T initialValue, T onError) {
+            T previousVal = default_value<T>();
+            bool assing_succeed = true;
+
+            bool succeed = ctx.atomic_slots.perform(ctx, slot, [&](item& itemValue) {
+                assing_succeed = u_applyFunction(itemValue, F{}, inputValue, initialValue, previousVal);
+            });
+
+            return (succeed && assing_succeed) ? previousVal : onError;
+        }
+
+#   define PARAMS_INT   "slot value initialValue=0 onErrorReturn=0"
+#   define PARAMS_FLT   "slot value initialValue=0.0 onErrorReturn=0.0"
+        REGISTERF(ARGS(slotFunction<SInt32, std::plus<SInt32>>), "slotFetchAddInt", PARAMS_INT, "same as fetchAddInt, but for the @slot");
+        REGISTERF(ARGS(slotFunction<Float32, std::plus<Float32>>), "slotFetchAddFlt", PARAMS_FLT, nullptr);
+        REGISTERF(ARGS(slotFunction<SInt32, std::multiplies<SInt32>>), "slotFetchMultInt", PARAMS_INT, nullptr);
+        REGISTERF(ARGS(slotFunction<Float32, std::multiplies<Float32>>), "slotFetchMultFlt", PARAMS_FLT, nullptr);
+        REGISTERF(ARGS(slotFunction<uint32_t, std::bit_and<uint32_t>>), "slotFetchAndInt", PARAMS_INT, nullptr);
+        REGISTERF(ARGS(slotFunction<uint32_t, std::bit_xor<uint32_t>>), "slotFetchXorInt", PARAMS_INT, nullptr);
+        REGISTERF(ARGS(slotFunction<uint32_t, std::bit_or<uint32_t>>), "slotFetchOrInt", PARAMS_INT, nullptr);
+#   undef PARAMS_INT
+#   undef PARAMS_FLT
+
+        template<class T>
+        static T slotExchange(tes_context& ctx, SInt32 slot, T inputValue, T onError) {
+            return slotFunction<T, ignore_first>(ctx, slot, inputValue, inputValue, onError);
+        }
+        REGISTERF(slotExchange<SInt32>, "slotExchangeInt", "slot value onErrorReturn=0", "same as exchangeInt, but for the @slot");
+        REGISTERF(slotExchange<Float32>, "slotExchangeFlt", "slot value onErrorReturn=0.0", nullptr);
+
+        template<class T>
+        static T slotCompareExchange(tes_context& ctx, SInt32 slot, T newValue, T comparer, T onError) {
+            T previousVal = default_value<T>();
+            bool succeed = ctx.atomic_slots.perform(ctx, slot, [&](item& itemValue) {
+                u_compareExchange(itemValue, newValue, comparer, previousVal);
+            });
+
+            return succeed ? previousVal : onError;
+        }
+        REGISTERF(slotCompareExchange<SInt32>, "slotCompareExchangeInt", "slot desired expected onErrorReturn=0", "same as compareExchangeInt, but for the @slot");
+        REGISTERF(slotCompareExchange<Float32>, "slotCompareExchangeFlt", "slot desired expected onErrorReturn=0.0", nullptr);
+
+        template<class T>
+        static T slotGet(tes_context& ctx, SInt32 slot, T onError) {
+            T value = onError;
+            ctx.atomic_slots.perform(ctx, slot, [&](item& itemValue) {
+                value = itemValue.readAs<T>();
+            }, false);
+            return value;
+        }
+        REGISTERF(slotGet<SInt32>, "slotGetInt", "slot onErrorReturn=0", "returns the value of the @slot");
+        REGISTERF(slotGet<Float32>, "slotGetFlt", "slot onErrorReturn=0.0", nullptr);
+
     };
 
     TES_META_INFO(tes_atomic);
@@ -239,5 +326,68 @@ If @createMissingKeys is True, the function attemps to create missing @path elem
     */
 
         }
+
+        TEST(tes_atomic, slots)
+        {
+            tes_context_standalone context;
+            map& obj = map::make(context);
+            object_stack_ref objRef(&obj);
+
+            EXPECT_EQ(tes_atomic::getSlot(context, &obj, ".stats.kills"), 0);
+
+            auto slot = tes_atomic::getSlot(context, &obj, ".stats.kills", true);
+            EXPECT_TRUE(slot != 0);
+
+            EXPECT_EQ(tes_atomic::slotFunction<SInt32, std::plus<SInt32>>(context, slot, 2, 10, -1), 0);
+            EXPECT_EQ(tes_atomic::slotFunction<SInt32, std::plus<SInt32>>(context, slot, 2, 10, -1), 12);
+            EXPECT_EQ(ca::get(obj, ".stats.kills")->intValue(), 14);
+            EXPECT_EQ(tes_atomic::slotCompareExchange<SInt32>(context, slot, 100, 14, -1), 14);
+            EXPECT_EQ(tes_atomic::slotGet<SInt32>(context, slot, -1), 100);
+
+            // the type differs
+            EXPECT_EQ(tes_atomic::slotFunction<Float32, std::plus<Float32>>(context, slot, 1.f, 0.f, -1.f), -1.f);
+
+            // the key is looked up again after the container changes
+            auto stats = ca::get(obj, ".stats")->object()->as<map>();
+            stats->erase("kills");
+            EXPECT_EQ(tes_atomic::slotGet<SInt32>(context, slot, -1), -1);
+            stats->set("kills", item(5));
+            stats->set("deaths", item(1));
+            EXPECT_EQ(tes_atomic::slotExchange<SInt32>(context, slot, 7, -1), 5);
+            EXPECT_EQ(ca::get(obj, ".stats.kills")->intValue(), 7);
+
+            // many threads
+            {
+                auto counter = tes_atomic::getSlot(context, &obj, ".counter", true);
+                std::vector<std::thread> threads;
+                for (int i = 0; i < 4; ++i) {
+                    threads.emplace_back([&]() {
+                        for (int j = 0; j < 1000; ++j) {
+                            tes_atomic::slotFunction<SInt32, std::plus<SInt32>>(context, counter, 1, 0, 0);
+                        }
+                    });
+                }
+                for (auto& t : threads) {
+                    t.join();
+                }
+                EXPECT_EQ(tes_atomic::slotGet<SInt32>(context, counter, -1), 4000);
+            }
+
+            EXPECT_TRUE(tes_atomic::releaseSlot(context, slot));
+            EXPECT_FALSE(tes_atomic::releaseSlot(context, slot));
+            EXPECT_EQ(tes_atomic::slotGet<SInt32>(context, slot, -1), -1);
+
+            EXPECT_EQ(tes_atomic::slotGet<SInt32>(context, 0, -1), -1);
+            EXPECT_EQ(tes_atomic::slotGet<SInt32>(context, 100500, -1), -1);
+
+            // array items are found by index
+            array& arr = array::object(context);
+            arr.u_push(item(1));
+            obj.set("array", item(arr));
+            auto arrSlot = tes_atomic::getSlot(context, &obj, ".array[0]");
+            EXPECT_EQ(tes_atomic::slotFunction<SInt32, std::plus<SInt32>>(context, arrSlot, 1, 0, -1), 1);
+            arr.u_container().insert(arr.u_container().begin(), item(10));
+            EXPECT_EQ(tes_atomic::slotGet<SInt32>(context, arrSlot, -1), 10);
+        }
     }
 }
@@ -66,13 +66,19 @@ namespace tes_api_3 {
 
         using key_cref = const form_ref_lightweight&;
 
+        static form_map *findStorage(tes_context& ctx, const char *storageName) {
+            if (!validate_storage_name(storageName)) {
+                return nullptr;
+            }
+            return ctx.form_storages.get(ctx.root(), storageName);
+        }
+
         static form_map *makeFormStorage(tes_context& ctx, const char *storageName) {
             if (!validate_storage_name(storageName)) {
                 return nullptr;
             }
 
-            auto& db = ctx.root();
-            form_map::ref fmap = tes_map::getItem<object_base*>(ctx, &db, storageName)->as<form_map>();
+            form_map::ref fmap = findStorage(ctx, storageName);
 
             if (!fmap) {
                 fmap = tes_object::object<form_map>(ctx);
@@ -95,10 +101,10 @@ namespace tes_api_3 {
                 auto fmap = makeFormStorage(ctx, storageName);
                 tes_form_map::setItem(ctx, fmap, formKey, entry);
             } else {
-                auto& db = ctx.root();
-                auto fmap = tes_map::getItem<object_base*>(ctx, &db, storageName)->as<form_map>();
-                tes_form_map::removeKey(ctx, fmap, formKey);
+                tes_form_map::removeKey(ctx, findStorage(ctx, storageName), formKey);
             }
+
+            ctx.form_indexes.on_entry_changed(ctx, storageName, formKey.get(), entry.get());
         }
         REGISTERF2(setEntry, "storageName fKey entry", "associates given form key and entry (container). set entry to zero to destroy association");
 
@@ -119,12 +125,29 @@ namespace tes_api_3 {
         REGISTERF(makeMapEntry, "makeEntry", "storageName fKey", "returns (or creates new if not found) JMap entry for given storage and form");
 
         static object_base *findEntry(tes_context& ctx, const char *storageName, key_cref form) {
-            auto& db = ctx.root();
-            form_map *fmap = tes_map::getItem<object_base*>(ctx, &db, storageName)->as<form_map>();
-            return tes_form_map::getItem<object_base*>(ctx, fmap, form);
+            return tes_form_map::getItem<object_base*>(ctx, findStorage(ctx, storageName), form);
         }
         REGISTERF2(findEntry, "storageName fKey", "search for entry for given storage and form");
 
+        static object_base *getStorage(tes_context& ctx, const char *storageName, bool create = false) {
+            return create ? makeFormStorage(ctx, storageName) : findStorage(ctx, storageName);
+        }
+        REGISTERF2(getStorage, "storageName create=false",
+            "returns the storage - JFormMap of form keys and entries, or zero if there is no such storage. Creates the storage if @create is true.\n"
+            "Allows to lookup the storage once and then to use solve*InStorage functions in a loop");
+
+        template<class T>
+        static T solveGetterInStorage(tes_context& ctx, object_base *storage, key_cref form, const char* path, T t = default_value<T>()) {
+            return tes_object::resolveGetter<T>(ctx, tes_form_map::getItem<object_base*>(ctx, storage->as<form_map>(), form), path, t);
+        }
+        REGISTERF(solveGetterInStorage<Float32>, "solveFltInStorage", "storage fKey path default=0.0",
+            "attempts to get value associated with the @path inside the form entry of the @storage (see getStorage).\n"
+            "The path is relative to the entry: solveIntInStorage(getStorage(\"frostfall\"), form, \".keyB\") equals to solveInt(form, \".frostfall.keyB\")");
+        REGISTERF(solveGetterInStorage<SInt32>, "solveIntInStorage", "storage fKey path default=0", nullptr);
+        REGISTERF(solveGetterInStorage<skse::string_ref>, "solveStrInStorage", "storage fKey path default=\"\"", nullptr);
+        REGISTERF(solveGetterInStorage<Handle>, "solveObjInStorage", "storage fKey path default=0", nullptr);
+        REGISTERF(solveGetterInStorage<form_ref>, "solveFormInStorage", "storage fKey path default=None", nullptr);
+
         static map *findMapEntry(tes_context& ctx, const char *storageName, key_cref form) {
             return findEntry(ctx, storageName, form)->as<map>();
         }
@@ -145,7 +168,12 @@ namespace tes_api_3 {
         template<class T>
         static bool solveSetter(tes_context& ctx, key_cref form, const char* path, T value, bool createMissingKeys = false) {
             subpath_extractor sub(path, is_path);
-            return tes_object::solveSetter(ctx, makeMapEntry(ctx, sub.storageName(), form), sub.rest(), value, createMissingKeys);
+            map *entry = makeMapEntry(ctx, sub.storageName(), form);
+            bool succeed = tes_object::solveSetter(ctx, entry, sub.rest(), value, createMissingKeys);
+            if (succeed) {
+                ctx.form_indexes.on_entry_changed(ctx, sub.storageName(), form.get(), entry, sub.rest());
+            }
+            return succeed;
         }
         REGISTERF(solveSetter<Float32>, "solveFltSetter", "fKey path value createMissingKeys=false",
             "Attempts to assign value. Returns false if no such path\n"
@@ -193,13 +221,86 @@ namespace tes_api_3 {
         template<class T>
         static void setItem(tes_context& ctx, key_cref form, const char* path, T item) {
             subpath_extractor sub(path);
-            tes_map::setItem(ctx, makeMapEntry(ctx, sub.storageName(), form), sub.rest(), item);
+            map *entry = makeMapEntry(ctx, sub.storageName(), form);
+            tes_map::setItem(ctx, entry, sub.rest(), item);
+
+            if (entry && !ctx.form_indexes.empty()) {
+                ctx.form_indexes.on_entry_changed(ctx, sub.storageName(), form.get(), entry, (std::string(".") + sub.rest()).c_str());
+            }
         }
         REGISTERF(setItem<SInt32>, "setInt", "fKey key value", "creates key-value association. replaces existing value if any");
         REGISTERF(setItem<Float32>, "setFlt", "fKey key value", "");
         REGISTERF(setItem<const char *>, "setStr", "fKey key value", "");
         REGISTERF(setItem<object_stack_ref&>, "setObj", "fKey key container", "");
         REGISTERF(setItem<form_ref>, "setForm", "fKey key value", "");
+
+        //////////////////////////////////////////////////////////////////////////
+
+        static bool addIndex(tes_context& ctx, const char *storageName, const char *path, bool ordered = false) {
+            if (!validate_storage_name(storageName) || !path || !*path) {
+                return false;
+            }
+
+            ctx.form_indexes.add(ctx, { storageName, path, ordered ? form_db_index::ordered : form_db_index::hashed });
+            return true;
+        }
+        REGISTERF2(addIndex, "storageName path ordered=false",
+            "Index functions:\n"
+            "\n"
+            "Builds an index of the storage forms by the value at the @path inside their entries, for ex. addIndex(\"frostfall\", \".faction\").\n"
+            "The index is kept up to date by JFormDB setters and is saved along with the game. Only int, float, string and form values are indexed.\n"
+            "@ordered - the index supports range queries, otherwise only exact matches are fast");
+
+        static bool removeIndex(tes_context& ctx, const char *storageName, const char *path) {
+            return ctx.form_indexes.remove(storageName, path);
+        }
+        REGISTERF2(removeIndex, "storageName path", "Removes the index. Returns false if there was no such index");
+
+        static void rebuildIndexes(tes_context& ctx, const char *storageName) {
+            ctx.form_indexes.rebuild(ctx, storageName);
+        }
+        REGISTERF2(rebuildIndexes, "storageName",
+            "Rebuilds the storage indexes. Needed if entries were changed through the other than JFormDB functions, e.g. with JMap or JValue");
+
+        static object_base* formsArray(tes_context& ctx, const std::vector<FormId>& forms) {
+            auto& arr = array::object(ctx);
+            arr.u_container().reserve(forms.size());
+            for (FormId id : forms) {
+                arr.u_push(item(make_weak_form_id(id, ctx)));
+            }
+            return &arr;
+        }
+
+        template<class T>
+        static object_base* findForms(tes_context& ctx, const char *storageName, const char *path, T value) {
+            auto forms = ctx.form_indexes.find(ctx, storageName, path, item(value));
+            if (!forms) {
+                JC_LOG_TES_API_ERROR(JFormDB, findForms, "no index for '%s' storage and '%s' path", storageName, path);
+                return nullptr;
+            }
+            return formsArray(ctx, *forms);
+        }
+        REGISTERF(findForms<SInt32>, "findFormsWithInt", "storageName path value",
+            "Returns a new array of the storage forms whose entries have the @value at the @path. Requires an index, see addIndex");
+        REGISTERF(findForms<Float32>, "findFormsWithFlt", "storageName path value", nullptr);
+        REGISTERF(findForms<const char *>, "findFormsWithStr", "storageName path value", nullptr);
+        REGISTERF(findForms<form_ref>, "findFormsWithForm", "storageName path value", nullptr);
+
+        template<class T>
+        static object_base* findFormsInRange(tes_context& ctx, const char *storageName, const char *path, T low, T high) {
+            auto forms = ctx.form_indexes.find_range(ctx, storageName, path, item(low), item(high));
+            if (!forms) {
+                JC_LOG_TES_API_ERROR(JFormDB, findFormsInRange, "no index for '%s' storage and '%s' path", storageName, path);
+                return nullptr;
+            }
+            return formsArray(ctx, *forms);
+        }
+        REGISTERF(findFormsInRange<SInt32>, "findFormsInIntRange", "storageName path low high",
+            "Returns a new array of the storage forms whose entries have a value at the @path in [@low, @high] range, ordered by the value.\n"
+            "Ints and floats are compared by value, so findFormsInIntRange(10, 20) returns the forms with 12.5 too.\n"
+            "String ranges contain strings only. Fast with an ordered index, slower with a hashed one");
+        REGISTERF(findFormsInRange<Float32>, "findFormsInFltRange", "storageName path low high", nullptr);
+        REGISTERF(findFormsInRange<const char *>, "findFormsInStrRange", "storageName path low high", nullptr);
     };
 
     TES_META_INFO(tes_form_db);
@@ -275,5 +376,137 @@ namespace tes_api_3 {
         }
     }
 
+    TEST(tes_form_db, storage_cache)
+    {
+        tes_context_standalone ctx;
+
+        auto form = make_lightweight_form_ref((FormId)0x14, ctx);
+
+        EXPECT_NIL(tes_form_db::getStorage(ctx, "stats"));
+        EXPECT_TRUE(tes_form_db::solveSetter<SInt32>(ctx, form, ".stats.level", 10, true));
+
+        auto storage = tes_form_db::getStorage(ctx, "stats");
+        EXPECT_NOT_NIL(storage);
+        EXPECT_EQ(storage, tes_form_db::getStorage(ctx, "STATS"));
+        EXPECT_EQ(tes_form_db::solveGetterInStorage<SInt32>(ctx, storage, form, ".level"), 10);
+        EXPECT_EQ(tes_form_db::solveGetterInStorage<SInt32>(ctx, nullptr, form, ".level", -1), -1);
+
+        // repeated lookups don't touch the root
+        auto misses = ctx.form_storages.misses();
+        for (int i = 0; i < 10; ++i) {
+            EXPECT_EQ(tes_form_db::solveGetter<SInt32>(ctx, form, ".stats.level"), 10);
+        }
+        EXPECT_EQ(ctx.form_storages.misses(), misses);
+
+        // replaced and removed storages are noticed
+        object_stack_ref replacement = &form_map::object(ctx);
+        tes_db::setObj(ctx, "stats", replacement);
+        EXPECT_EQ(tes_form_db::solveGetter<SInt32>(ctx, form, ".stats.level", -1), -1);
+        EXPECT_TRUE(tes_form_db::getStorage(ctx, "stats") != storage);
+
+        // as well as the storages replaced through a path
+        EXPECT_TRUE(tes_form_db::solveSetter<SInt32>(ctx, form, ".stats.level", 20, true));
+        object_stack_ref assigned = tes_form_db::getStorage(ctx, "stats");
+        object_stack_ref other = &form_map::object(ctx);
+        EXPECT_TRUE(tes_db::solveSetter<object_base*>(ctx, ".stats", other.get()));
+        EXPECT_EQ(tes_form_db::solveGetter<SInt32>(ctx, form, ".stats.level", -1), -1);
+        EXPECT_TRUE(tes_form_db::getStorage(ctx, "stats") == other.get());
+
+        EXPECT_TRUE(ca::assign(ctx.root(), ".stats", item(assigned.get())));
+        EXPECT_EQ(tes_form_db::solveGetter<SInt32>(ctx, form, ".stats.level", -1), 20);
+        EXPECT_TRUE(tes_form_db::getStorage(ctx, "stats") == assigned.get());
+
+        tes_map::removeKey(ctx, &ctx.root(), "stats");
+        EXPECT_NIL(tes_form_db::getStorage(ctx, "stats"));
+        EXPECT_NOT_NIL(tes_form_db::getStorage(ctx, "stats", true));
+    }
+
+    TEST(tes_form_db, indexes)
+    {
+        tes_context_standalone ctx;
+
+        auto form = [&](uint32_t id) { return make_lightweight_form_ref((FormId)(0x41000000 | id), ctx); };
+        auto forms_of = [&](object_base *arr) {
+            std::vector<FormId> result;
+            for (auto& itm : arr->as<array>()->u_container()) {
+                result.push_back(itm.get<form_ref>()->get());
+            }
+            std::sort(result.begin(), result.end());
+            return result;
+        };
+        auto id = [](uint32_t i) { return (FormId)(0x41000000 | i); };
+
+        for (uint32_t i = 1; i <= 10; ++i) {
+            tes_form_db::solveSetter<SInt32>(ctx, form(i), ".npcs.level", i * 10, true);
+            tes_form_db::setItem<const char *>(ctx, form(i), ".npcs.faction", i % 2 ? "Stormcloaks" : "Legion");
+        }
+
+        // not indexed yet
+        EXPECT_NIL(tes_form_db::findForms<SInt32>(ctx, "npcs", ".level", 10));
+
+        EXPECT_TRUE(tes_form_db::addIndex(ctx, "npcs", ".faction"));
+        EXPECT_TRUE(tes_form_db::addIndex(ctx, "npcs", ".level", true));
+        EXPECT_FALSE(tes_form_db::addIndex(ctx, nullptr, ".level"));
+
+        EXPECT_EQ(forms_of(tes_form_db::findForms<const char *>(ctx, "npcs", ".faction", "legion")),
+            (std::vector<FormId>{ id(2), id(4), id(6), id(8), id(10) }));
+        EXPECT_EQ(forms_of(tes_form_db::findFormsInRange<SInt32>(ctx, "npcs", ".level", 25, 50)),
+            (std::vector<FormId>{ id(3), id(4), id(5) }));
+
+        // range query results are ordered by the value
+        auto range = tes_form_db::findFormsInRange<SInt32>(ctx, "npcs", ".level", 0, 1000)->as<array>();
+        EXPECT_EQ(range->u_count(), 10);
+        EXPECT_TRUE(range->u_container().front().get<form_ref>()->get() == id(1));
+        EXPECT_TRUE(range->u_container().back().get<form_ref>()->get() == id(10));
+
+        // ints and floats are compared by value
+        tes_form_db::solveSetter<Float32>(ctx, form(12), ".npcs.level", 12.5f, true);
+        EXPECT_EQ(forms_of(tes_form_db::findFormsInRange<SInt32>(ctx, "npcs", ".level", 10, 20)),
+            (std::vector<FormId>{ id(1), id(2), id(12) }));
+        EXPECT_EQ(forms_of(tes_form_db::findFormsInRange<Float32>(ctx, "npcs", ".level", 10.5f, 20.f)),
+            (std::vector<FormId>{ id(2), id(12) }));
+        tes_form_db::solveSetter<Float32>(ctx, form(13), ".npcs.level", std::numeric_limits<Float32>::quiet_NaN(), true);
+        EXPECT_EQ(forms_of(tes_form_db::findFormsInRange<SInt32>(ctx, "npcs", ".level", 10, 20)),
+            (std::vector<FormId>{ id(1), id(2), id(12) }));
+
+        // incremental maintenance
+        tes_form_db::setItem<const char *>(ctx, form(2), ".npcs.faction", "Stormcloaks");
+        tes_form_db::solveSetter<SInt32>(ctx, form(3), ".npcs.level", 500);
+        tes_form_db::setItem<const char *>(ctx, form(11), ".npcs.faction", "Legion");
+
+        EXPECT_EQ(forms_of(tes_form_db::findForms<const char *>(ctx, "npcs", ".faction", "Legion")),
+            (std::vector<FormId>{ id(4), id(6), id(8), id(10), id(11) }));
+        EXPECT_EQ(forms_of(tes_form_db::findFormsInRange<SInt32>(ctx, "npcs", ".level", 25, 50)),
+            (std::vector<FormId>{ id(4), id(5) }));
+        EXPECT_EQ(forms_of(tes_form_db::findForms<SInt32>(ctx, "npcs", ".level", 500)), (std::vector<FormId>{ id(3) }));
+
+        object_stack_ref none;
+        tes_form_db::setEntry(ctx, "npcs", form(4), none);
+        EXPECT_EQ(forms_of(tes_form_db::findForms<SInt32>(ctx, "npcs", ".level", 40)), std::vector<FormId>{});
+
+        // changes made around JFormDB are filtered out of the results and fixed by rebuild
+        tes_object::solveSetter<const char*>(ctx, tes_form_db::findEntry(ctx, "npcs", form(6)), ".faction", "Thalmor");
+        EXPECT_EQ(forms_of(tes_form_db::findForms<const char *>(ctx, "npcs", ".faction", "Legion")),
+            (std::vector<FormId>{ id(8), id(10), id(11) }));
+        EXPECT_EQ(forms_of(tes_form_db::findForms<const char *>(ctx, "npcs", ".faction", "Thalmor")), std::vector<FormId>{});
+        tes_form_db::rebuildIndexes(ctx, "npcs");
+        EXPECT_EQ(forms_of(tes_form_db::findForms<const char *>(ctx, "npcs", ".faction", "Thalmor")), (std::vector<FormId>{ id(6) }));
+
+        // definitions are saved, the data gets rebuilt on load
+        {
+            tes_context_standalone loaded;
+            loaded.read_from_string(ctx.write_to_string());
+
+            EXPECT_TRUE(loaded.form_indexes.has_index("npcs", ".level"));
+            EXPECT_EQ(forms_of(tes_form_db::findForms<const char *>(loaded, "npcs", ".faction", "Thalmor")), (std::vector<FormId>{ id(6) }));
+            EXPECT_EQ(forms_of(tes_form_db::findFormsInRange<SInt32>(loaded, "npcs", ".level", 25, 50)),
+                (std::vector<FormId>{ id(5) }));
+        }
+
+        EXPECT_TRUE(tes_form_db::removeIndex(ctx, "npcs", ".faction"));
+        EXPECT_FALSE(tes_form_db::removeIndex(ctx, "npcs", ".faction"));
+        EXPECT_NIL(tes_form_db::findForms<const char *>(ctx, "npcs", ".faction", "Legion"));
+    }
+
 
 }
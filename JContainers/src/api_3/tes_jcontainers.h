@@ -128,6 +128,29 @@ namespace tes_api_3 {
         }
         REGISTERF2_STATELESS(lastErrorString, nullptr, "DEPRECATED. Returns string that describes last error");
 
+        static bool profileStart(const char *className) {
+            return reflection::profiling::start(className);
+        }
+        REGISTERF2_STATELESS(profileStart, "className=\"\"",
+"Profiling functions. Native function calls get counted and timed (total, max time and a histogram of call times) while profiling is on.\n\
+Starts profiling the functions of the @className (JMap, JFormDB, etc) or of all the classes if @className is empty. Returns false if there is no such class");
+
+        static void profileStop() {
+            reflection::profiling::stop();
+        }
+        REGISTERF2_STATELESS(profileStop, nullptr, "Stops profiling. The statistics are kept");
+
+        static void profileReset() {
+            reflection::profiling::reset();
+        }
+        REGISTERF2_STATELESS(profileReset, nullptr, "Erases the statistics");
+
+        static bool profileDumpToFile(const char *filePath) {
+            return reflection::profiling::dump_to_file(filePath);
+        }
+        REGISTERF2_STATELESS(profileDumpToFile, "filePath",
+            "Writes the statistics of the called functions into JSON file, the most time consuming functions go first");
+
         REGISTER_TEXT([]() {
             const char fmt[] = R"===(
 ; Returns true if JContainers plugin installed properly
@@ -180,4 +203,30 @@ endfunction
         EXPECT_NO_THROW(vec = tes_jcontainers::contentsOfDirectoryAtPath<decltype(vec)>(":invaliddir"));
         EXPECT_TRUE(vec.empty());
     }
+
+    TEST(tes_jcontainers, profiling)
+    {
+        auto stats_of = [](const char *func, const char *className) {
+            return reflection::find_function_of_class(func, className)->stats;
+        };
+
+        EXPECT_FALSE(tes_jcontainers::profileStart("NoSuchClass"));
+        EXPECT_TRUE(tes_jcontainers::profileStart("JMap"));
+        EXPECT_TRUE(stats_of("setInt", "JMap")->enabled);
+        EXPECT_FALSE(stats_of("setInt", "JArray")->enabled);
+
+        stats_of("setInt", "JMap")->record(10);
+        tes_jcontainers::profileStop();
+        EXPECT_FALSE(stats_of("setInt", "JMap")->enabled);
+        EXPECT_TRUE(stats_of("setInt", "JMap")->calls == 1);
+
+        const char *path = "profile_dump.json";
+        EXPECT_TRUE(tes_jcontainers::profileDumpToFile(path));
+        auto root = make_unique_ptr(json_load_file(path, 0, nullptr), json_decref);
+        EXPECT_TRUE(root && json_array_size(json_object_get(root.get(), "functions")) >= 1);
+        boost::filesystem::remove_all(path);
+
+        tes_jcontainers::profileReset();
+        EXPECT_TRUE(stats_of("setInt", "JMap")->calls == 0);
+    }
 }
@@ -45,6 +45,106 @@ namespace tes_api_3 {
         REGISTERF(setItem<object_base*>, "setObj", "* key container", "");
         REGISTERF(setItem<form_ref>, "setForm", "* key value", "");
 
+        using tes_key_arg = reflection::binding::convert_to_tes_type<Key>;
+
+        // the keys of a Papyrus array. The Papyrus @keys array keeps the storage of string keys
+        static std::vector<Key> keysOf(tes_context& ctx, VMArray<tes_key_arg> keys, std::vector<tes_key_arg>& tesKeys) {
+            tesKeys.resize(keys.Length());
+            std::vector<Key> result;
+            result.reserve(keys.Length());
+            for (UInt32 i = 0; i < keys.Length(); ++i) {
+                keys.Get(&tesKeys[i], i);
+                result.push_back(reflection::binding::get_converter<Key>::convert2J(tesKeys[i], ctx));
+            }
+            return result;
+        }
+
+        // values at the @keys, read under a single lock. Missing values are replaced with @def
+        template<class T>
+        static VMResultArray<reflection::binding::convert_to_tes_type<T>> getValues(ref obj, const std::vector<Key>& keys, T def) {
+            using converter = reflection::binding::get_converter<T>;
+
+            VMResultArray<reflection::binding::convert_to_tes_type<T>> results;
+            results.assign(keys.size(), converter::convert2Tes(def));
+            if (!obj) {
+                return results;
+            }
+
+            object_lock g(obj);
+            // const access doesn't change the container version
+            const map_type& cobj = *obj;
+            for (size_t i = 0; i < keys.size(); ++i) {
+                if (map_functions::key_checker::check(keys[i])) {
+                    if (const item *itm = cobj.u_get(keys[i])) {
+                        results[i] = converter::convert2Tes(itm->readAs<T>());
+                    }
+                }
+            }
+            return results;
+        }
+
+        // assigns values[i] to keys[i] under a single lock, returns the number of the assigned values
+        template<class T>
+        static SInt32 setValues(ref obj, const std::vector<Key>& keys, const std::vector<T>& values) {
+            if (!obj) {
+                return 0;
+            }
+
+            SInt32 assigned = 0;
+            size_t count = (std::min)(keys.size(), values.size());
+
+            object_lock g(obj);
+            for (size_t i = 0; i < count; ++i) {
+                if (map_functions::key_checker::check(keys[i])) {
+                    obj->u_set(keys[i], item(values[i]));
+                    ++assigned;
+                }
+            }
+            return assigned;
+        }
+
+        template<class T>
+        static VMResultArray<reflection::binding::convert_to_tes_type<T>> getMany(
+            tes_context& ctx, ref obj, VMArray<tes_key_arg> keys, T def = default_value<T>())
+        {
+            std::vector<tes_key_arg> tesKeys;
+            return getValues(obj, keysOf(ctx, keys, tesKeys), def);
+        }
+        REGISTERF(getMany<SInt32>, "getIntMany", "* keys default=0",
+            "Returns an array of the values associated with the @keys. Missing values are replaced with @default.\n"
+            "Same as a getInt call per key, but a single native call and the container gets locked once");
+        REGISTERF(getMany<Float32>, "getFltMany", "* keys default=0.0", nullptr);
+        REGISTERF(getMany<skse::string_ref>, "getStrMany", "* keys default=\"\"", nullptr);
+        REGISTERF(getMany<Handle>, "getObjMany", "* keys default=0", nullptr);
+        REGISTERF(getMany<form_ref>, "getFormMany", "* keys default=None", nullptr);
+
+        template<class T>
+        static SInt32 setMany(tes_context& ctx, ref obj, VMArray<tes_key_arg> keys,
+            VMArray<reflection::binding::convert_to_tes_type<T>> values)
+        {
+            using converter = reflection::binding::get_converter<T>;
+
+            std::vector<tes_key_arg> tesKeys;
+            auto jkeys = keysOf(ctx, keys, tesKeys);
+
+            std::vector<reflection::binding::convert_to_tes_type<T>> tesValues(values.Length());
+            std::vector<T> jvalues;
+            jvalues.reserve(values.Length());
+            for (UInt32 i = 0; i < values.Length(); ++i) {
+                values.Get(&tesValues[i], i);
+                jvalues.push_back(converter::convert2J(tesValues[i], ctx));
+            }
+
+            return setValues(obj, jkeys, jvalues);
+        }
+        REGISTERF(setMany<SInt32>, "setIntMany", "* keys values",
+            "Inserts keys[i]: values[i] pair for each pair of the parallel @keys and @values arrays. Returns the number of the inserted pairs.\n"
+            "Same as a setInt call per key, but a single native call and the container gets locked once");
+        REGISTERF(setMany<Float32>, "setFltMany", "* keys values", nullptr);
+        REGISTERF(setMany<const char*>, "setStrMany", "* keys values", nullptr);
+        REGISTERF(setMany<object_base*>, "setObjMany", "* keys containers", nullptr);
+        REGISTERF(setMany<form_ref>, "setFormMany", "* keys values", nullptr);
+
         static bool hasKey(tes_context& ctx, ref obj, key_cref key) {
             return valueType(ctx, obj, key) != 0;
         }
@@ -66,8 +166,9 @@ namespace tes_api_3 {
                 object_lock g(obj);
 
                 arr._array.reserve(obj->u_count());
-                for each(auto& pair in obj->u_container()) {
-                    arr.u_container().emplace_back(pair.first);
+                const map_type& cobj = *obj;
+                for each(auto& pair in cobj.u_container()) {
+                    arr._array.emplace_back(pair.first);
                 }
             },
                 ctx);
@@ -82,7 +183,8 @@ namespace tes_api_3 {
             VMResultArray<tes_key> keys;
             object_lock l(obj);
             keys.reserve(obj->u_count());
-            std::transform(obj->u_container().begin(), obj->u_container().end(),
+            const map_type& cobj = *obj;
+            std::transform(cobj.u_container().begin(), cobj.u_container().end(),
                 std::back_inserter(keys),
                 [&ctx](const typename map_type::value_type& p) {
                     return reflection::binding::get_converter<typename map_type::key_type>::convert2Tes(p.first);
@@ -102,7 +204,8 @@ namespace tes_api_3 {
                 object_lock g(obj);
 
                 arr._array.reserve(obj->u_count());
-                for each(auto& pair in obj->u_container()) {
+                const map_type& cobj = *obj;
+                for each(auto& pair in cobj.u_container()) {
                     arr._array.push_back(pair.second);
                 }
             },
@@ -152,6 +255,7 @@ namespace tes_api_3 {
             else {
                 obj->u_container().insert(source->u_container().begin(), source->u_container().end());
             }
+            obj->u_changed();
         }
         REGISTERF2(addPairs, "* source overrideDuplicates", "Inserts key-value pairs from the source container");
 
@@ -251,6 +355,23 @@ Usage:
             // so that the function will not return unloaded (None) form keys at Papyrus level
             return map_functions_templ < form_map >::nextKey_forPapyrus(obj, previousKey, endKey, KeyCompareForNextKey{});
         }
+
+        static void setExpiredKeysPurging(tes_context& ctx, bool enabled) {
+            ctx.expired_form_keys.set_enabled(enabled);
+        }
+        REGISTERF2(setExpiredKeysPurging, "enabled=true",
+"Once a form gets deleted, the keys of the form get removed from form-maps in background (enabled by default).\n\
+Disabled, the keys stay in form-maps as None keys until the next save game load");
+
+        static bool isExpiredKeysPurgingEnabled(tes_context& ctx) {
+            return ctx.expired_form_keys.enabled();
+        }
+        REGISTERF2(isExpiredKeysPurgingEnabled, nullptr, nullptr);
+
+        static SInt32 purgedExpiredKeysCount(tes_context& ctx) {
+            return (SInt32)ctx.expired_form_keys.stats().reclaimed.load(std::memory_order_relaxed);
+        }
+        REGISTERF2(purgedExpiredKeysCount, nullptr, "Returns the number of the deleted forms' keys removed so far");
     };
 
     struct tes_integer_map_ext : class_meta < tes_integer_map_ext > {
@@ -227,21 +227,28 @@ JValue.cleanPool(\"uniquePoolName\")"
             "Note: by default it does not filter files by extension and will try to parse everything");
 
         static object_base* objectFromPrototype(tes_context& ctx, const char *prototype) {
+            if (auto tmpl = ctx.prototypes.find(prototype)) {
+                return &tmpl->instantiate(ctx);
+            }
+
             auto obj = json_deserializer::object_from_json_data( ctx, prototype);
+            if (obj) {
+                ctx.prototypes.insert(prototype, prototype_template::make(*obj));
+            }
             return obj;
         }
         REGISTERF2(objectFromPrototype, "prototype", "Creates a new container object using given JSON string-prototype");
 
-        static void writeToFile(tes_context& ctx, object_base *obj, const char * cpath) {
-            if (!cpath || !obj) {
-                return;
-            }
-
+        // creates missing parent directories of the file
+        static bool prepare_file_directory(const char * cpath) {
             boost::filesystem::path path(cpath);
             auto& dir = path.remove_filename();
-            if (!dir.empty() && !boost::filesystem::exists(dir) &&
-                (boost::filesystem::create_directories(dir), !boost::filesystem::exists(dir)))
-            {
+            return dir.empty() || boost::filesystem::exists(dir) ||
+                (boost::filesystem::create_directories(dir), boost::filesystem::exists(dir));
+        }
+
+        static void writeToFile(tes_context& ctx, object_base *obj, const char * cpath) {
+            if (!cpath || !obj || !prepare_file_directory(cpath)) {
                 return;
             }
 
@@ -252,6 +259,137 @@ JValue.cleanPool(\"uniquePoolName\")"
         }
         REGISTERF(writeToFile, "writeToFile", "* filePath", "Writes the object into JSON file");
 
+        // parsed JSON, shareable between the I/O part of a request and its completion
+        static std::shared_ptr<json_t> shared_json(json_unique_ref&& json) {
+            return std::shared_ptr<json_t>(json.release(), json_decref);
+        }
+
+        static SInt32 readFromFileAsync(tes_context& context, const char *path, const char *modEvent = "") {
+            if (!path) {
+                return 0;
+            }
+
+            std::string filePath(path);
+            return context.file_requests.start(modEvent, [filePath, &context]() -> async_requests::completion {
+                auto json = shared_json(json_deserializer::json_from_file(filePath.c_str()));
+                return [json, &context](internal_object_ref& result) {
+                    result = json ? json_deserializer::object_from_json(context, json.get()) : nullptr;
+                    return result != nullptr;
+                };
+            });
+        }
+        REGISTERF2(readFromFileAsync, "filePath modEvent=\"\"",
+            "Asynchronous file I/O. The file gets read and parsed in background, the script doesn't wait for it.\n"
+            "Unlike the other functions, these return a request number (0 if there are too many requests). A request is either polled with asyncRequestStatus,\n"
+            "or, if @modEvent isn't empty, the ModEvent gets sent once the request is done: its string argument is 'completed' or 'failed', numeric one is the request number.\n"
+            "Requests aren't saved.\n\n"
+            "Starts reading JSON file, the container object is then taken with takeAsyncResult");
+
+        static SInt32 readFromDirectoryAsync(tes_context& context, const char *dirPath, const char *extension = "", const char *modEvent = "") {
+            if (!dirPath) {
+                return 0;
+            }
+
+            std::string directory(dirPath), ext(extension ? extension : "");
+            return context.file_requests.start(modEvent, [directory, ext, &context]() -> async_requests::completion {
+                using files_t = std::vector<std::pair<std::string, std::shared_ptr<json_t>>>;
+                auto files = std::make_shared<files_t>();
+                try {
+                    namespace fs = boost::filesystem;
+                    for (fs::directory_iterator itr(directory), end_itr; itr != end_itr; ++itr) {
+                        if (ext.empty() || itr->path().extension().generic_string().compare(ext) == 0) {
+                            auto json = json_deserializer::json_from_file(itr->path().generic_string().c_str());
+                            if (json) {
+                                files->emplace_back(itr->path().filename().generic_string(), shared_json(std::move(json)));
+                            }
+                        }
+                    }
+                }
+                catch (const boost::filesystem::filesystem_error& exc) {
+                    JC_LOG_TES_API_ERROR(JValue, readFromDirectoryAsync, "throws '%s'", exc.what());
+                    return nullptr;
+                }
+
+                return [files, &context](internal_object_ref& result) {
+                    map& filesMap = map::object(context);
+                    for (auto& file : *files) {
+                        if (auto obj = json_deserializer::object_from_json(context, file.second.get())) {
+                            filesMap.set(file.first, item(obj));
+                        }
+                    }
+                    result = &filesMap;
+                    return true;
+                };
+            });
+        }
+        REGISTERF2(readFromDirectoryAsync, "directoryPath extension=\"\" modEvent=\"\"",
+            "Starts parsing JSON files in a directory, the JMap containing {filename, container-object} pairs is then taken with takeAsyncResult");
+
+        static SInt32 writeToFileAsync(tes_context& context, object_base *obj, const char *cpath, const char *modEvent = "") {
+            if (!cpath || !obj) {
+                return 0;
+            }
+
+            // the snapshot of the object graph is taken right away, so the script is free to change the object
+            auto json = shared_json(json_serializer::create_json_value(*obj));
+            if (!json) {
+                return 0;
+            }
+
+            std::string path(cpath);
+            return context.file_requests.start(modEvent, [json, path]() -> async_requests::completion {
+                bool written = false;
+                try {
+                    written = prepare_file_directory(path.c_str()) &&
+                        json_dump_file(json.get(), path.c_str(), JSON_INDENT(2)) == 0;
+                }
+                catch (const boost::filesystem::filesystem_error& exc) {
+                    JC_LOG_TES_API_ERROR(JValue, writeToFileAsync, "throws '%s'", exc.what());
+                }
+                return [written](internal_object_ref&) { return written; };
+            });
+        }
+        REGISTERF2(writeToFileAsync, "* filePath modEvent=\"\"",
+            "Starts writing the object into JSON file. The object's current state gets written, the later changes don't affect the file");
+
+        static SInt32 asyncRequestStatus(tes_context& context, SInt32 request) {
+            return context.file_requests.status(request);
+        }
+        REGISTERF2(asyncRequestStatus, "request",
+            "Returns the status of the request: 0 - no such request, 1 - in progress, 2 - completed, 3 - failed");
+
+        static object_base* takeAsyncResult(tes_context& context, SInt32 request) {
+            internal_object_ref result = context.file_requests.take(request);
+            if (!result) {
+                return nullptr;
+            }
+            // the object gets exposed and survives the request, as a just created one does
+            result->uid();
+            return result->prolong_lifetime();
+        }
+        REGISTERF2(takeAsyncResult, "request",
+            "Returns the container object read by the done request and forgets the request. Must be called for each done request, including writes and failed ones,\n"
+            "as there can be at most 1024 requests");
+
+        static object_base* readFromBinaryFile(tes_context& context, const char *path) {
+            return binary_deserializer::read_file(context, path);
+        }
+        REGISTERF2(readFromBinaryFile, "filePath",
+            "Binary serialization/deserialization:\n\n"
+            "Creates and returns a new container object containing contents of a file, written by writeToBinaryFile.\n"
+            "The binary format is faster to read and write than JSON and keeps forms and shared containers exactly");
+
+        static void writeToBinaryFile(tes_context& ctx, object_base *obj, const char * cpath) {
+            if (!cpath || !obj || !prepare_file_directory(cpath)) {
+                return;
+            }
+
+            if (!binary_serializer::write_file(*obj, cpath)) {
+                JC_LOG_TES_API_ERROR(JValue, writeToBinaryFile, "can't write file '%s'", cpath);
+            }
+        }
+        REGISTERF(writeToBinaryFile, "writeToBinaryFile", "* filePath", "Writes the object into a binary file");
+
         static SInt32 solvedValueType(tes_context& ctx, object_base* obj, const char *path) {
             SInt32 type = item_type::no_item;
 
@@ -310,6 +448,149 @@ For ex. JValue.hasPath(container, \".player.health\") will test whether @contain
         REGISTERF(solveSetter<const char*>, "solveStrSetter", "* path value createMissingKeys=false", nullptr);
         REGISTERF(solveSetter<ref>, "solveObjSetter", "* path value createMissingKeys=false", nullptr);
         REGISTERF(solveSetter<form_ref>, "solveFormSetter", "* path value createMissingKeys=false", nullptr);
+
+        template<class T>
+        static VMResultArray<reflection::binding::convert_to_tes_type<T>> solveMany(
+            tes_context& ctx, object_base* obj, VMArray<skse::string_ref> paths, T def = default_value<T>())
+        {
+            using converter = reflection::binding::get_converter<T>;
+
+            VMResultArray<reflection::binding::convert_to_tes_type<T>> results;
+            results.assign(paths.Length(), converter::convert2Tes(def));
+            if (!obj) {
+                return results;
+            }
+
+            std::vector<skse::string_ref> pathStrings(paths.Length());
+            std::vector<const char *> cpaths(paths.Length());
+            for (UInt32 i = 0; i < paths.Length(); ++i) {
+                paths.Get(&pathStrings[i], i);
+                cpaths[i] = pathStrings[i].c_str();
+            }
+
+            path_resolving::resolve_many(ctx, obj, cpaths, [&](size_t idx, item* itmPtr) {
+                if (itmPtr) {
+                    results[idx] = converter::convert2Tes(itmPtr->readAs<T>());
+                }
+            });
+
+            return results;
+        }
+        REGISTERF(solveMany<Float32>, "solveFltMany", "* paths default=0.0",
+            "Resolves each path of the @paths array, returns an array of the values. Missing values are replaced with @default.\n"
+            "Same as a solveFlt call per path, but a single native call, and the paths sharing leading keys visit them once");
+        REGISTERF(solveMany<SInt32>, "solveIntMany", "* paths default=0", nullptr);
+        REGISTERF(solveMany<skse::string_ref>, "solveStrMany", "* paths default=\"\"", nullptr);
+        REGISTERF(solveMany<Handle>, "solveObjMany", "* paths default=0", nullptr);
+        REGISTERF(solveMany<form_ref>, "solveFormMany", "* paths default=None", nullptr);
+
+        template<class T>
+        static SInt32 solveManySetter(tes_context& ctx, object_base* obj, VMArray<skse::string_ref> paths,
+            VMArray<reflection::binding::convert_to_tes_type<T>> values, bool createMissingKeys = false)
+        {
+            using converter = reflection::binding::get_converter<T>;
+
+            if (!obj) {
+                return 0;
+            }
+
+            SInt32 assigned = 0;
+            UInt32 count = (std::min)(paths.Length(), values.Length());
+            for (UInt32 i = 0; i < count; ++i) {
+                skse::string_ref path;
+                reflection::binding::convert_to_tes_type<T> tesValue;
+                paths.Get(&path, i);
+                values.Get(&tesValue, i);
+
+                T value = converter::convert2J(tesValue, ctx);
+                if (path.c_str() && ca::assign(*obj, path.c_str(), value, createMissingKeys ? ca::creative : ca::constant)) {
+                    ++assigned;
+                }
+            }
+
+            return assigned;
+        }
+        REGISTERF(solveManySetter<Float32>, "solveFltManySetter", "* paths values createMissingKeys=false",
+            "Assigns values[i] at paths[i] for each pair of the parallel @paths and @values arrays. Returns the number of assigned values.\n"
+            "Same as a solveFltSetter call per path, but a single native call");
+        REGISTERF(solveManySetter<SInt32>, "solveIntManySetter", "* paths values createMissingKeys=false", nullptr);
+        REGISTERF(solveManySetter<const char*>, "solveStrManySetter", "* paths values createMissingKeys=false", nullptr);
+        REGISTERF(solveManySetter<ref>, "solveObjManySetter", "* paths values createMissingKeys=false", nullptr);
+        REGISTERF(solveManySetter<form_ref>, "solveFormManySetter", "* paths values createMissingKeys=false", nullptr);
+
+        template<class T>
+        static object_base* filter(tes_context& ctx, ref obj, const char* path, const char* comparison, T value) {
+            if (!obj || !path) {
+                return nullptr;
+            }
+
+            auto op = query::parse_comparison(comparison);
+            if (!op) {
+                JC_LOG_TES_API_ERROR(JValue, filter, "unknown comparison '%s'", comparison ? comparison : "");
+                return nullptr;
+            }
+
+            return &query::filter(ctx, *obj, path, *op, item(value));
+        }
+        REGISTERF(filter<SInt32>, "filterInt", "* path comparison value",
+            "Returns a new array of the container values whose value at the @path compares to the @value successfully.\n"
+            "@comparison is one of ==, !=, <, <=, >, >=. Numbers are compared with numbers, strings with strings (case-insensitive), forms with forms.\n"
+            "Empty @path compares the values themselves. For ex. filterInt(records, \".level\", \">\", 10)");
+        REGISTERF(filter<Float32>, "filterFlt", "* path comparison value", nullptr);
+        REGISTERF(filter<const char*>, "filterStr", "* path comparison value", nullptr);
+        REGISTERF(filter<form_ref>, "filterForm", "* path comparison value", nullptr);
+
+        static object_base* project(tes_context& ctx, ref obj, const char* path) {
+            return obj && path ? &query::project(ctx, *obj, path) : nullptr;
+        }
+        REGISTERF2(project, "* path", "Returns a new array of the values at the @path of each container value. Missing values are None");
+
+        static object_base* groupBy(tes_context& ctx, ref obj, const char* path) {
+            return obj && path ? &query::group_by(ctx, *obj, path) : nullptr;
+        }
+        REGISTERF2(groupBy, "* path",
+            "Groups the container values by their value at the @path. Returns a new JMap of {key: array of values}.\n"
+            "Numbers and forms become string keys, values without string, number or form at the @path are skipped");
+
+        //////////////////////////////////////////////////////////////////////////
+
+        static SInt32 subscribeToChanges(tes_context& ctx, ref obj, const char* path = "", const char* modEvent = "") {
+            object_base *container = (path && *path) ? path_resolving::_resolve<object_base*>(ctx, obj, path) : obj;
+            return container ? ctx.changes.subscribe(*container, modEvent) : 0;
+        }
+        REGISTERF2(subscribeToChanges, "* path=\"\" modEvent=\"\"",
+            "Change notifications:\n"
+            "\n"
+            "Starts watching changes of the container at the @path of the object (or of the object itself, if the path is empty).\n"
+            "Returns the subscription, or 0 if there is no container at the @path. Instead of polling the values, poll the subscription:\n"
+            "pollChanges returns only what has changed. If the @modEvent isn't empty, the ModEvent (strArg \"changed\", numArg - the subscription)\n"
+            "is sent on the first change since the previous poll. Nested containers need their own subscriptions.\n"
+            "A subscription ends once its container is destroyed. Subscriptions are not saved");
+
+        static object_base* pollChanges(tes_context& ctx, SInt32 subscription) {
+            auto batch = ctx.changes.poll(subscription);
+            if (!batch || (batch->keys.empty() && !batch->whole)) {
+                return nullptr;
+            }
+
+            auto& result = array::object(ctx);
+            if (batch->whole) {
+                result.u_push(item());
+            }
+            for (auto& key : batch->keys) {
+                result.u_push(key);
+            }
+            return &result;
+        }
+        REGISTERF2(pollChanges, "subscription",
+            "Returns a new array of the keys (indexes for JArray) changed since the previous call, or 0 if nothing has changed.\n"
+            "Each key is returned once, no matter how many times it was changed. The array starts with None if the container\n"
+            "has changed as a whole: got cleared or sorted, items were inserted or erased, or too many keys changed");
+
+        static bool unsubscribeFromChanges(tes_context& ctx, SInt32 subscription) {
+            return ctx.changes.unsubscribe(ctx, subscription);
+        }
+        REGISTERF2(unsubscribeFromChanges, "subscription", "Stops watching the changes. Returns false if there is no such subscription");
         
 /*
 Int function atomicFetchAdd(int object, string path, int value, bool createMissingKeys=false, int initialValue=0, int onErrorReturn=0) Global Native
@@ -331,7 +612,7 @@ Int function atomicFetchDiv(int object, string path, int value, bool createMissi
 
             T previousVal = default_value<T>();
 
-            bool succeed = ca::visit_value(*obj, path, ca::access_way::creative, [&previousVal](item& value) {
+            bool succeed = ca::modify_value(*obj, path, ca::access_way::creative, [&previousVal](item& value) {
                 if (value.isNull()) {
                     value = initialValue;
                 }
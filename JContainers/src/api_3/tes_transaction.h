@@ -0,0 +1,159 @@
+namespace tes_api_3 {
+
+    using namespace collections;
+
+    class tes_transaction : public class_meta<tes_transaction> {
+    public:
+
+        REGISTER_TES_NAME("JTransaction");
+
+        void additionalSetup() {
+            metaInfo.comment =
+                "Batches container modifications. A transaction records the operations and applies them all on commit,\n"
+                "locking each container once and applying its operations in the order they were recorded. Several changes\n"
+                "of the same container become one native call and one lock acquisition instead of a call per change.\n"
+                "Containers are retained by the transaction until it's committed or cancelled.\n"
+                "Transactions are not saved, up to 1024 transactions may be pending at once";
+        }
+
+        static SInt32 create(tes_context& ctx) {
+            return ctx.pending_transactions.create();
+        }
+        REGISTERF2(create, "", "Creates new transaction and returns its identifier, 0 if there are too many pending transactions");
+
+        template<class T>
+        static bool setItem(tes_context& ctx, SInt32 tx, map* obj, const char* key, T value) {
+            if (!obj || !key) {
+                return false;
+            }
+            return ctx.pending_transactions.record(tx, [&](transaction& t) {
+                t.set(*obj, key, item(value));
+            });
+        }
+        REGISTERF(setItem<SInt32>, "setInt", "transaction map key value",
+            "Records JMap.set* operation. Returns false if there is no such transaction or the @map is None");
+        REGISTERF(setItem<Float32>, "setFlt", "transaction map key value", "");
+        REGISTERF(setItem<const char*>, "setStr", "transaction map key value", "");
+        REGISTERF(setItem<object_base*>, "setObj", "transaction map key container", "");
+        REGISTERF(setItem<form_ref>, "setForm", "transaction map key value", "");
+
+        static bool removeKey(tes_context& ctx, SInt32 tx, map* obj, const char* key) {
+            if (!obj || !key) {
+                return false;
+            }
+            return ctx.pending_transactions.record(tx, [&](transaction& t) {
+                t.remove(*obj, key);
+            });
+        }
+        REGISTERF2(removeKey, "transaction map key", "Records JMap.removeKey operation");
+
+        template<class T>
+        static bool addItem(tes_context& ctx, SInt32 tx, array* obj, T value) {
+            if (!obj) {
+                return false;
+            }
+            return ctx.pending_transactions.record(tx, [&](transaction& t) {
+                t.push(*obj, item(value));
+            });
+        }
+        REGISTERF(addItem<SInt32>, "addInt", "transaction array value", "Records JArray.add* operation (appends the value)");
+        REGISTERF(addItem<Float32>, "addFlt", "transaction array value", "");
+        REGISTERF(addItem<const char*>, "addStr", "transaction array value", "");
+        REGISTERF(addItem<object_base*>, "addObj", "transaction array container", "");
+        REGISTERF(addItem<form_ref>, "addForm", "transaction array value", "");
+
+        static SInt32 commit(tes_context& ctx, SInt32 tx) {
+            auto t = ctx.pending_transactions.take(tx);
+            if (!t) {
+                JC_LOG_TES_API_ERROR(JTransaction, commit, "no transaction %d", tx);
+                return -1;
+            }
+            return (SInt32)t->commit();
+        }
+        REGISTERF2(commit, "transaction",
+            "Applies the recorded operations and disposes the transaction. Returns the number of the applied operations\n"
+            "(operations removing missing keys are not counted) or -1 if there is no such transaction");
+
+        static bool cancel(tes_context& ctx, SInt32 tx) {
+            return ctx.pending_transactions.take(tx) != nullptr;
+        }
+        REGISTERF2(cancel, "transaction", "Disposes the transaction without applying it");
+    };
+
+    TES_META_INFO(tes_transaction);
+
+    TEST(tes_transaction, commit)
+    {
+        tes_context_standalone ctx;
+        object_stack_ref mapRef(&map::object(ctx));
+        object_stack_ref arrRef(&array::object(ctx));
+        map* obj = mapRef->as<map>();
+        array* arr = arrRef->as<array>();
+
+        obj->u_set("stale", item(1));
+
+        auto tx = tes_transaction::create(ctx);
+        EXPECT_TRUE(tx > 0);
+        EXPECT_TRUE(tes_transaction::setItem<SInt32>(ctx, tx, obj, "level", 10));
+        EXPECT_TRUE(tes_transaction::setItem<const char*>(ctx, tx, obj, "name", "Lydia"));
+        EXPECT_TRUE(tes_transaction::addItem<Float32>(ctx, tx, arr, 1.5f));
+        EXPECT_TRUE(tes_transaction::setItem<SInt32>(ctx, tx, obj, "level", 11));
+        EXPECT_TRUE(tes_transaction::removeKey(ctx, tx, obj, "stale"));
+        EXPECT_TRUE(tes_transaction::removeKey(ctx, tx, obj, "missing"));
+        EXPECT_TRUE(tes_transaction::addItem<object_base*>(ctx, tx, arr, obj));
+        EXPECT_FALSE(tes_transaction::setItem<SInt32>(ctx, tx, nullptr, "level", 1));
+
+        // nothing is applied before commit
+        EXPECT_TRUE(tes_map::getItem<SInt32>(ctx, obj, "level") == 0);
+        EXPECT_TRUE(arr->s_count() == 0);
+
+        EXPECT_TRUE(tes_transaction::commit(ctx, tx) == 6);
+        EXPECT_TRUE(tes_map::getItem<SInt32>(ctx, obj, "level") == 11);
+        EXPECT_TRUE(std::string(obj->findOrDef("name").strValue()) == "Lydia");
+        EXPECT_FALSE(tes_map::hasKey(ctx, obj, "stale"));
+        EXPECT_TRUE(arr->s_count() == 2);
+        EXPECT_TRUE(tes_array::itemAtIndex<object_base*>(ctx, arr, 1) == obj);
+
+        // the transaction is disposed
+        EXPECT_TRUE(tes_transaction::commit(ctx, tx) == -1);
+        EXPECT_FALSE(tes_transaction::setItem<SInt32>(ctx, tx, obj, "level", 1));
+
+        auto cancelled = tes_transaction::create(ctx);
+        tes_transaction::setItem<SInt32>(ctx, cancelled, obj, "level", 100);
+        EXPECT_TRUE(tes_transaction::cancel(ctx, cancelled));
+        EXPECT_FALSE(tes_transaction::cancel(ctx, cancelled));
+        EXPECT_TRUE(tes_map::getItem<SInt32>(ctx, obj, "level") == 11);
+        EXPECT_TRUE(ctx.pending_transactions.size() == 0);
+    }
+
+    // 10k updates of 12 keys: a native call per key vs a transaction per update
+    TEST(tes_transaction, perft)
+    {
+        tes_context_standalone ctx;
+        object_stack_ref mapRef(&map::object(ctx));
+        map* obj = mapRef->as<map>();
+
+        const int updates = 10000;
+        const char *keys[] = { "k0", "k1", "k2", "k3", "k4", "k5", "k6", "k7", "k8", "k9", "k10", "k11" };
+
+        util::do_with_timing("transaction: 12 JMap.setInt calls x 10000", [&]() {
+            for (int i = 0; i < updates; ++i) {
+                for (auto key : keys) {
+                    tes_map::setItem<SInt32>(ctx, obj, key, i);
+                }
+            }
+        });
+
+        util::do_with_timing("transaction: 12 JTransaction.setInt + commit x 10000", [&]() {
+            for (int i = 0; i < updates; ++i) {
+                auto tx = tes_transaction::create(ctx);
+                for (auto key : keys) {
+                    tes_transaction::setItem<SInt32>(ctx, tx, obj, key, i + 1);
+                }
+                tes_transaction::commit(ctx, tx);
+            }
+        });
+
+        EXPECT_TRUE(tes_map::getItem<SInt32>(ctx, obj, "k11") == updates);
+    }
+}
@@ -159,6 +159,199 @@ namespace tes_api_3 {
         }
     }
 
+    TEST(path_resolving, aggregation_operators)
+    {
+        tes_context_standalone  ctx;
+
+        auto resolve = [&](object_base *obj, const char *path) {
+            item result;
+            path_resolving::resolve(ctx, obj, path, [&](item * itm) {
+                if (itm) {
+                    result = *itm;
+                }
+            });
+            return result;
+        };
+
+        {
+            object_stack_ref obj = tes_object::objectFromPrototype(ctx, STR([1, 2, 3, 4, "str", 6]));
+
+            EXPECT_TRUE(resolve(obj, "@sum") == 16);
+            EXPECT_TRUE(resolve(obj, "@product") == 144);
+            EXPECT_TRUE(resolve(obj, "@count") == 6);
+            EXPECT_TRUE(std::abs(resolve(obj, "@avg").fltValue() - 3.2f) < 1e-5f);
+        }
+        {
+            object_stack_ref obj = tes_object::objectFromPrototype(ctx, STR([1, 2.5, 2.9, -0.5]));
+
+            EXPECT_TRUE(resolve(obj, "@sum") == 5.9f);
+            EXPECT_TRUE(resolve(obj, "@product").is_type<item::Real>());
+
+            object_stack_ref hist = resolve(obj, "@histogram").object();
+            auto histogram = hist ? hist->as<integer_map>() : nullptr;
+            EXPECT_TRUE(histogram && histogram->u_count() == 3);
+            EXPECT_TRUE(tes_object::resolveGetter<SInt32>(ctx, hist, "[2]") == 2);
+            EXPECT_TRUE(tes_object::resolveGetter<SInt32>(ctx, hist, "[-1]") == 1);
+        }
+        {
+            object_stack_ref obj = tes_object::objectFromPrototype(ctx, STR([]));
+
+            EXPECT_TRUE(resolve(obj, "@sum").isNull());
+            EXPECT_TRUE(resolve(obj, "@avg").isNull());
+            EXPECT_TRUE(resolve(obj, "@count") == 0);
+            EXPECT_TRUE(resolve(obj, "@histogram").isNull());
+        }
+        {
+            object_stack_ref obj = tes_object::objectFromPrototype(ctx, STR(
+            { "a": {"k": 1}, "b" : {"k": 2}, "c" : {"k": 3.5}, "d" : {"n": 100} }
+            ));
+
+            EXPECT_TRUE(resolve(obj, "@sum.value.k") == 6.5f);
+            EXPECT_TRUE(resolve(obj, "@count.value") == 4);
+            // a map needs .key or .value selector
+            EXPECT_TRUE(resolve(obj, "@count").isNull());
+            EXPECT_TRUE(resolve(obj, "@histogram").isNull());
+            EXPECT_TRUE(std::abs(resolve(obj, "@avg.value.k").fltValue() - 6.5f / 3) < 1e-5f);
+        }
+        {
+            object_stack_ref obj = tes_object::objectFromPrototype(ctx, STR([2147483647, 1]));
+            EXPECT_TRUE(resolve(obj, "@sum").is_type<item::Real>());
+        }
+    }
+
+    TEST(array, aggregation)
+    {
+        tes_context_standalone ctx;
+        auto& ar = tes_object::objectFromPrototype(ctx, STR([1, 2, 2, 2.0, "2", 4]))->as_link<array>();
+
+        EXPECT_TRUE(tes_array::sum(ctx, &ar) == 11.f);
+        EXPECT_TRUE(std::abs(tes_array::avg(ctx, &ar) - 2.2f) < 1e-5f);
+        EXPECT_TRUE(tes_array::product(ctx, &ar) == 32.f);
+        EXPECT_TRUE(tes_array::sum(ctx, nullptr) == 0.f);
+
+        EXPECT_TRUE(tes_array::countOf<SInt32>(ctx, &ar, 2) == 2);
+        EXPECT_TRUE(tes_array::countOf<Float32>(ctx, &ar, 2.f) == 1);
+        EXPECT_TRUE(tes_array::countOf<const char *>(ctx, &ar, "2") == 1);
+        EXPECT_TRUE(tes_array::countOf<SInt32>(ctx, nullptr, 2) == 0);
+
+        auto histogram = tes_array::histogram(ctx, &ar);
+        EXPECT_TRUE(histogram && histogram->as<integer_map>());
+        EXPECT_TRUE(tes_object::resolveGetter<SInt32>(ctx, histogram, "[2]") == 3);
+    }
+
+    TEST(query, filter_sort_group_project)
+    {
+        tes_context_standalone ctx;
+        object_stack_ref records = tes_object::objectFromPrototype(ctx, STR([
+            { "name": "Lydia", "level" : 12, "class" : "warrior" },
+            { "name": "aela", "level" : 20, "class" : "archer" },
+            { "name": "Faendal", "level" : 5, "class" : "archer" },
+            { "name": "Borgakh", "level" : 12.5, "class" : "warrior" },
+            { "name": "Erik" },
+            7
+        ]));
+
+        auto names = [&](object_base *arr) {
+            std::string result;
+            for (auto& itm : arr->as_link<array>().u_container()) {
+                auto name = path_resolving::_resolve<std::string>(ctx, itm.object(), ".name");
+                result += (name.empty() ? "-" : name) + " ";
+            }
+            return result;
+        };
+
+        object_stack_ref filtered = tes_object::filter<SInt32>(ctx, records, ".level", ">", 10);
+        EXPECT_TRUE(names(filtered) == "Lydia aela Borgakh ");
+        filtered = tes_object::filter<const char*>(ctx, records, ".class", "==", "ARCHER");
+        EXPECT_TRUE(names(filtered) == "aela Faendal ");
+        filtered = tes_object::filter<SInt32>(ctx, records, "", "==", 7);
+        EXPECT_TRUE(filtered->s_count() == 1);
+        EXPECT_NIL(tes_object::filter<SInt32>(ctx, records, ".level", "~", 10));
+
+        object_stack_ref sorted = tes_object::deepCopy(ctx, records);
+        tes_array::sortBy(ctx, sorted->as<array>(), ".level, .name");
+        EXPECT_TRUE(names(sorted) == "- Erik Faendal Lydia Borgakh aela ");
+        tes_array::sortBy(ctx, sorted->as<array>(), ".class,.name", true);
+        EXPECT_TRUE(names(sorted) == "Lydia Borgakh Faendal aela Erik - ");
+
+        object_stack_ref levels = tes_object::project(ctx, records, ".level");
+        EXPECT_TRUE(levels->s_count() == 6);
+        EXPECT_TRUE(tes_array::itemAtIndex<SInt32>(ctx, levels->as<array>(), 0) == 12);
+        EXPECT_TRUE(tes_array::valueType(ctx, levels->as<array>(), 4) == item_type::none);
+
+        object_stack_ref groups = tes_object::groupBy(ctx, records, ".class");
+        EXPECT_TRUE(groups->s_count() == 2);
+        EXPECT_TRUE(names(tes_object::resolveGetter<object_base*>(ctx, groups, ".warrior")) == "Lydia Borgakh ");
+        EXPECT_TRUE(names(tes_object::resolveGetter<object_base*>(ctx, groups, ".archer")) == "aela Faendal ");
+    }
+
+    TEST(query, sort_mixed_values)
+    {
+        tes_context_standalone ctx;
+        auto& values = array::object(ctx);
+        values.u_push(item{ 3 });
+        values.u_push(item{ std::numeric_limits<float>::quiet_NaN() });
+        values.u_push(item{ "b" });
+        values.u_push(item{ 1.5f });
+        values.u_push(item{});
+        values.u_push(item{ "A" });
+        values.u_push(item{ 2 });
+
+        // terminates despite NaN != NaN, orders by type and puts NaN after the other numbers
+        EXPECT_TRUE(query::sort_by(ctx, values, ""));
+        auto& sorted = values.u_container();
+        EXPECT_TRUE(sorted[0].isNull());
+        EXPECT_TRUE(sorted[1] == 1.5f);
+        EXPECT_TRUE(sorted[2] == 2);
+        EXPECT_TRUE(sorted[3] == 3);
+        EXPECT_TRUE(std::isnan(sorted[4].fltValue()));
+        EXPECT_TRUE(sorted[5] == std::string("A"));
+        EXPECT_TRUE(sorted[6] == std::string("b"));
+
+        EXPECT_TRUE(query::sort_by(ctx, values, "", true));
+        EXPECT_TRUE(std::isnan(sorted[2].fltValue()));
+        EXPECT_TRUE(sorted[6].isNull());
+    }
+
+    // 10k records: query functions vs Papyrus-style loop with a native call per element
+    TEST(query, perft)
+    {
+        tes_context_standalone ctx;
+        auto& records = array::object(ctx);
+        for (int i = 0; i < 10000; ++i) {
+            auto& rec = map::object(ctx);
+            rec.u_set("level", item{ (i * 7919) % 100 });
+            rec.u_set("name", item{ "name" + std::to_string(i) });
+            records.u_push(item{ rec });
+        }
+
+        SInt32 papyrusCount = 0, queryCount = 0;
+        util::do_with_timing("query: filter .level > 50 with solveInt per element", [&]() {
+            auto& result = array::object(ctx);
+            SInt32 count = tes_array::count(ctx, &records);
+            for (SInt32 i = 0; i < count; ++i) {
+                auto rec = tes_array::itemAtIndex<object_base*>(ctx, &records, i);
+                if (tes_object::resolveGetter<SInt32>(ctx, rec, ".level") > 50) {
+                    tes_array::addItemAt<object_base*>(ctx, &result, rec);
+                }
+            }
+            papyrusCount = result.s_count();
+        });
+
+        util::do_with_timing("query: filterInt .level > 50", [&]() {
+            queryCount = tes_object::filter<SInt32>(ctx, &records, ".level", ">", 50)->s_count();
+        });
+        EXPECT_TRUE(papyrusCount == queryCount);
+
+        util::do_with_timing("query: sortBy .level, .name", [&]() {
+            tes_array::sortBy(ctx, &records, ".level, .name");
+        });
+
+        util::do_with_timing("query: groupBy .level", [&]() {
+            EXPECT_TRUE(tes_object::groupBy(ctx, &records, ".level")->s_count() == 100);
+        });
+    }
+
     TEST(path_resolving, explicit_key_construction)
     {
         tes_context_standalone  ctx;
@@ -207,6 +400,272 @@ namespace tes_api_3 {
         EXPECT_TRUE(itr == m->u_container().end());
     }
 
+    TEST(tes_map, bulk_access)
+    {
+        tes_context_standalone ctx;
+        object_stack_ref mapRef(&map::object(ctx));
+        map* m = mapRef->as<map>();
+
+        std::vector<const char*> keys = { "level", "gold", nullptr, "health" };
+        EXPECT_TRUE(tes_map::setValues<SInt32>(m, keys, { 10, 20, 30 }) == 2);
+        EXPECT_TRUE(tes_map::getItem<SInt32>(ctx, m, "gold") == 20);
+        EXPECT_FALSE(tes_map::hasKey(ctx, m, "health"));
+
+        m->u_set("name", item("Lydia"));
+        auto values = tes_map::getValues<SInt32>(m, { "gold", "missing", "level", "name" }, -1);
+        EXPECT_TRUE((values == std::vector<SInt32>{ 20, -1, 10, 0 }));
+        EXPECT_TRUE(tes_map::getValues<Float32>(nullptr, keys, 1.f).size() == keys.size());
+
+        object_stack_ref arrRef(&array::object(ctx));
+        array* arr = arrRef->as<array>();
+        EXPECT_TRUE(tes_array::setValues<SInt32>(arr, { 1, 2, 3 }) == 3);
+        EXPECT_TRUE(tes_array::setValues<SInt32>(arr, { 20, 30, 40 }, 1) == 3);
+        EXPECT_TRUE(tes_array::setValues<SInt32>(arr, { 50 }, -1) == 1);
+        EXPECT_TRUE(tes_array::setValues<SInt32>(arr, { 50 }, 10) == 0);
+        EXPECT_TRUE((tes_array::getRange<SInt32>(ctx, arr) == std::vector<SInt32>{ 1, 20, 30, 40, 50 }));
+        EXPECT_TRUE((tes_array::getRange<SInt32>(ctx, arr, 1, -2) == std::vector<SInt32>{ 20, 30, 40 }));
+        EXPECT_TRUE(tes_array::getRange<SInt32>(ctx, arr, 3, 1).empty());
+        EXPECT_TRUE(tes_array::getRange<SInt32>(ctx, arr, -10, 1).empty());
+
+        arr->u_container()[0] = item();
+        EXPECT_TRUE(tes_array::getRange<SInt32>(ctx, arr, 0, 0, -1).front() == -1);
+    }
+
+    // 12 keys and 128 array items accessed 10000 times: a native call per value vs one bulk call
+    TEST(tes_map, bulk_access_perft)
+    {
+        tes_context_standalone ctx;
+        object_stack_ref mapRef(&map::object(ctx));
+        object_stack_ref arrRef(&array::object(ctx));
+        map* m = mapRef->as<map>();
+        array* arr = arrRef->as<array>();
+
+        const int repeats = 10000;
+        const std::vector<const char*> keys = { "k0", "k1", "k2", "k3", "k4", "k5", "k6", "k7", "k8", "k9", "k10", "k11" };
+        const std::vector<SInt32> values(keys.size(), 1);
+        const std::vector<SInt32> arrayValues(128, 1);
+        SInt32 sum = 0, bulkSum = 0;
+
+        util::do_with_timing("bulk access: 12 JMap.setInt calls x 10000", [&]() {
+            for (int i = 0; i < repeats; ++i) {
+                for (auto key : keys) {
+                    tes_map::setItem<SInt32>(ctx, m, key, 1);
+                }
+            }
+        });
+        util::do_with_timing("bulk access: JMap.setIntMany with 12 keys x 10000", [&]() {
+            for (int i = 0; i < repeats; ++i) {
+                tes_map::setValues<SInt32>(m, keys, values);
+            }
+        });
+
+        util::do_with_timing("bulk access: 12 JMap.getInt calls x 10000", [&]() {
+            for (int i = 0; i < repeats; ++i) {
+                for (auto key : keys) {
+                    sum += tes_map::getItem<SInt32>(ctx, m, key);
+                }
+            }
+        });
+        util::do_with_timing("bulk access: JMap.getIntMany with 12 keys x 10000", [&]() {
+            for (int i = 0; i < repeats; ++i) {
+                for (auto value : tes_map::getValues<SInt32>(m, keys, 0)) {
+                    bulkSum += value;
+                }
+            }
+        });
+        EXPECT_TRUE(sum == bulkSum);
+
+        tes_array::setValues(arr, arrayValues);
+        sum = bulkSum = 0;
+
+        util::do_with_timing("bulk access: 128 JArray.getInt calls x 10000", [&]() {
+            for (int i = 0; i < repeats; ++i) {
+                for (SInt32 idx = 0; idx < 128; ++idx) {
+                    sum += tes_array::itemAtIndex<SInt32>(ctx, arr, idx);
+                }
+            }
+        });
+        util::do_with_timing("bulk access: JArray.getIntRange of 128 items x 10000", [&]() {
+            for (int i = 0; i < repeats; ++i) {
+                for (auto value : tes_array::getRange<SInt32>(ctx, arr)) {
+                    bulkSum += value;
+                }
+            }
+        });
+        EXPECT_TRUE(sum == bulkSum);
+
+        util::do_with_timing("bulk access: 128 JArray.setInt calls x 10000", [&]() {
+            for (int i = 0; i < repeats; ++i) {
+                for (SInt32 idx = 0; idx < 128; ++idx) {
+                    tes_array::replaceItemAtIndex<SInt32>(ctx, arr, idx, 1);
+                }
+            }
+        });
+        util::do_with_timing("bulk access: JArray.setIntRange of 128 items x 10000", [&]() {
+            for (int i = 0; i < repeats; ++i) {
+                tes_array::setValues(arr, arrayValues);
+            }
+        });
+    }
+
+    TEST(tes_map, c_string_keys)
+    {
+        tes_context_standalone ctx;
+        object_stack_ref mapRef(&map::object(ctx));
+        map* m = mapRef->as<map>();
+
+        tes_map::setItem<SInt32>(ctx, m, "Key", 1);
+        tes_map::setItem<SInt32>(ctx, m, "KEY", 2);
+        EXPECT_TRUE(m->u_count() == 1);
+        EXPECT_TRUE(tes_map::getItem<SInt32>(ctx, m, "key") == 2);
+        EXPECT_TRUE(m->u_container().begin()->first == "Key");
+
+        const map& cm = *m;
+        EXPECT_NOT_NIL(cm.u_get("kEy"));
+        EXPECT_NIL(cm.u_get("Key2"));
+        EXPECT_TRUE(m->erase("KEy"));
+        EXPECT_TRUE(m->u_count() == 0);
+
+        // long keys don't fit into std::string's inline buffer - lookups used to allocate a temporary key
+        std::vector<std::string> keys;
+        for (int i = 0; i < 100; ++i) {
+            keys.push_back("a_rather_long_settings_key_" + std::to_string(i));
+            tes_map::setItem<SInt32>(ctx, m, keys.back().c_str(), i);
+        }
+
+        SInt32 sum = 0;
+        util::do_with_timing("c string keys: 100 JMap.getInt calls x 10000", [&]() {
+            for (int i = 0; i < 10000; ++i) {
+                for (auto& key : keys) {
+                    sum += tes_map::getItem<SInt32>(ctx, m, key.c_str());
+                }
+            }
+        });
+        EXPECT_TRUE(sum == 10000 * (99 * 100 / 2));
+
+        util::do_with_timing("c string keys: 100 JMap.setInt calls x 10000", [&]() {
+            for (int i = 0; i < 10000; ++i) {
+                for (auto& key : keys) {
+                    tes_map::setItem<SInt32>(ctx, m, key.c_str(), i);
+                }
+            }
+        });
+        EXPECT_TRUE(m->u_count() == 100);
+    }
+
+    TEST(tes_object, change_subscriptions)
+    {
+        tes_context_standalone ctx;
+        object_stack_ref root = json_deserializer::object_from_json_data(ctx, STR({ "settings": {"a": 1, "b": 2}, "list": [1, 2, 3] }));
+        map *settings = path_resolving::_resolve<object_base*>(ctx, root.get(), ".settings")->as<map>();
+        array *list = path_resolving::_resolve<object_base*>(ctx, root.get(), ".list")->as<array>();
+
+        auto changes = [&](SInt32 subscription) {
+            std::string result;
+            if (auto keys = tes_object::pollChanges(ctx, subscription)) {
+                for (auto& key : keys->as<array>()->u_container()) {
+                    if (key.isNull()) {
+                        result += "* ";
+                    }
+                    else if (auto str = key.get<std::string>()) {
+                        result += *str + " ";
+                    }
+                    else {
+                        result += std::to_string(key.intValue()) + " ";
+                    }
+                }
+            }
+            return result;
+        };
+
+        EXPECT_EQ(tes_object::subscribeToChanges(ctx, root.get(), ".nothing"), 0);
+        auto settingsSub = tes_object::subscribeToChanges(ctx, root.get(), ".settings");
+        EXPECT_TRUE(settingsSub != 0);
+        EXPECT_EQ(changes(settingsSub), "");
+
+        // repeated changes are coalesced, unrelated containers are not reported
+        tes_object::solveSetter<SInt32>(ctx, root.get(), ".settings.a", 5);
+        tes_object::solveSetter<SInt32>(ctx, root.get(), ".settings.a", 6);
+        tes_map::setItem<SInt32>(ctx, settings, "c", 1);
+        tes_object::solveSetter<SInt32>(ctx, root.get(), ".list[0]", 10);
+        EXPECT_EQ(changes(settingsSub), "a c ");
+        EXPECT_EQ(changes(settingsSub), "");
+
+        tes_atomic::performAtomicFunction<SInt32, std::plus<SInt32>>(ctx, root.get(), ".settings.b", 1, 0, false, 0);
+        tes_map::removeKey(ctx, settings, "c");
+        EXPECT_EQ(changes(settingsSub), "b c ");
+
+        auto listSub = tes_object::subscribeToChanges(ctx, list);
+        tes_array::replaceItemAtIndex<SInt32>(ctx, list, 1, 7);
+        tes_array::addItemAt<SInt32>(ctx, list, 4);
+        EXPECT_EQ(changes(listSub), "1 3 ");
+        tes_array::addItemAt<SInt32>(ctx, list, 0, 0);
+        EXPECT_EQ(changes(listSub), "* ");
+
+        // too many keys
+        for (int i = 0; i < 300; ++i) {
+            tes_map::setItem<SInt32>(ctx, settings, std::to_string(i).c_str(), i);
+        }
+        EXPECT_EQ(changes(settingsSub), "* ");
+
+        tes_object::clear(ctx, settings);
+        EXPECT_EQ(changes(settingsSub), "* ");
+
+        EXPECT_TRUE(tes_object::unsubscribeFromChanges(ctx, settingsSub));
+        EXPECT_FALSE(tes_object::unsubscribeFromChanges(ctx, settingsSub));
+        EXPECT_TRUE(!settings->is_watched());
+        EXPECT_NIL(tes_object::pollChanges(ctx, settingsSub));
+
+        // the subscriptions of a destroyed container end
+        auto listSubscription = tes_object::subscribeToChanges(ctx, list);
+        ctx.on_watched_object_destroyed(*list);
+        EXPECT_NIL(tes_object::pollChanges(ctx, listSubscription));
+        EXPECT_NIL(tes_object::pollChanges(ctx, listSub));
+        EXPECT_FALSE(tes_object::unsubscribeFromChanges(ctx, listSub));
+    }
+
+    TEST(tes_object, async_file_io)
+    {
+        tes_context_standalone ctx;
+
+        auto wait_for = [&](SInt32 request) {
+            for (int i = 0; i < 500 && tes_object::asyncRequestStatus(ctx, request) == async_requests::pending; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return tes_object::asyncRequestStatus(ctx, request);
+        };
+
+        const char *path = "async_io_test/obj.json";
+        object_stack_ref obj = json_deserializer::object_from_json_data(ctx, STR({ "a": 1, "b": [1, 2] }));
+
+        auto write = tes_object::writeToFileAsync(ctx, obj.get(), path);
+        EXPECT_TRUE(write != 0);
+        // doesn't get into the file
+        tes_map::setItem<SInt32>(ctx, obj->as<map>(), "a", 2);
+        EXPECT_EQ(wait_for(write), async_requests::completed);
+        EXPECT_NIL(tes_object::takeAsyncResult(ctx, write));
+        EXPECT_EQ(tes_object::asyncRequestStatus(ctx, write), async_requests::no_request);
+
+        auto read = tes_object::readFromFileAsync(ctx, path);
+        EXPECT_EQ(wait_for(read), async_requests::completed);
+        object_stack_ref readObj = tes_object::takeAsyncResult(ctx, read);
+        EXPECT_TRUE(readObj && tes_object::resolveGetter<SInt32>(ctx, readObj.get(), ".a") == 1);
+
+        auto readDir = tes_object::readFromDirectoryAsync(ctx, "async_io_test", ".json");
+        EXPECT_EQ(wait_for(readDir), async_requests::completed);
+        object_stack_ref files = tes_object::takeAsyncResult(ctx, readDir);
+        EXPECT_TRUE(files && files->s_count() == 1);
+
+        auto missing = tes_object::readFromFileAsync(ctx, "async_io_test/nothing.json");
+        EXPECT_EQ(wait_for(missing), async_requests::failed);
+
+        // dropped along with the state
+        ctx.clearState();
+        EXPECT_EQ(tes_object::asyncRequestStatus(ctx, missing), async_requests::no_request);
+
+        boost::filesystem::remove_all("async_io_test");
+    }
+
     TEST(tes_object, pool)
     {
         tes_context_standalone ctx;
@@ -6,12 +6,17 @@
 #include <boost/range/algorithm/find_end.hpp>
 
 #include <functional>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
 
 #include "forms/form_handling.h"
 #include "collections/collections.h"
 #include "collections/context.h"
 
 #include "collections/operators.h"
+#include "collections/path_compiler.h"
 
 namespace collections
 {
@@ -20,320 +25,379 @@ namespace collections
         namespace bs = boost;
         namespace ss = std;
 
-        typedef ss::function<item* (object_base*)> NodeFunc;
-        typedef ss::function<void (const item& , item&)> ElementFunc;
         typedef boost::iterator_range<const char*> path_type;
 
-        struct state {
-            bool succeed;
-            path_type path;
-            NodeFunc nodeGetter;
-            object_base *object;
-
-            state(bool _succeed, const NodeFunc& _node, object_base *_object, const path_type& _path) {
-                succeed = _succeed;
-                nodeGetter = _node;
-                path = _path;
-                object = _object;
-            }
-
-            state(bool _succeed, const state& st) {
-                succeed = _succeed;
-                nodeGetter = st.nodeGetter;
-                path = st.path;
-                object = st.object;
-            }
-        };
-
-        template<class T>
-        static bool _map_visit_helper(tes_context& context, T& container, path_type path, std::function<void(item *)>&& function)
-        {
-            if (path.empty()) {
-                return false;
-            }
-
-            bool isKeyVisit = false;
-
-            path_type::iterator rightPath;
-
-            if (bs::istarts_with(path, ".key")) {
-                isKeyVisit = true;
-                rightPath = path.begin() + bs::size(".key") - 1;
-            }
-            else if (bs::istarts_with(path, ".value")) {
-                isKeyVisit = false;
-                rightPath = path.begin() + bs::size(".value") - 1;
-            } else {
-                return false;
-            }
+        namespace {
 
-            auto copy = container.container_copy();
+            // Parses @operator's right part. For arrays it's applied to each element as is,
+            // maps also require it to start with '.key' or '.value'
+            void compile_operator_tail(path_token& token, const path_type& rightPath) {
+                token.tail = compile_path(rightPath);
 
-            if (isKeyVisit) {
-                item itm;
-                for (auto &pair : copy) {
-                    itm = pair.first;
-                    resolve(context, itm, rightPath, function);
+                if (bs::istarts_with(rightPath, ".key")) {
+                    token.has_map_selector = true;
+                    token.visits_keys = true;
+                    token.map_tail = compile_path(path_type(rightPath.begin() + bs::size(".key") - 1, rightPath.end()));
                 }
-            } else { // is value visit
-                for (auto &pair : copy) {
-                    resolve(context, pair.second, rightPath, function);
+                else if (bs::istarts_with(rightPath, ".value")) {
+                    token.has_map_selector = true;
+                    token.visits_keys = false;
+                    token.map_tail = compile_path(path_type(rightPath.begin() + bs::size(".value") - 1, rightPath.end()));
                 }
             }
 
-            return true;
-        }
+            bool parse_index(const path_type& indexRange, int32_t& index) {
+                // same as std::stoi(.., 0): leading whitespace and trailing garbage are allowed
+                char buffer[32] = { '\0' };
+                if (indexRange.size() >= sizeof buffer) {
+                    return false;
+                }
+                std::copy(indexRange.begin(), indexRange.end(), buffer);
 
-        void resolve(tes_context& context, item& target, const char *cpath,
-            const std::function<void(item *)>& itemFunction, bool createMissingKeys)
-        {
-            if (!cpath) {
-                return;
-            }
+                char *end = nullptr;
+                errno = 0;
+                long value = strtol(buffer, &end, 0);
+                if (end == buffer || errno == ERANGE || value < INT32_MIN || value > INT32_MAX) {
+                    return false;
+                }
 
-            if (target.object()) {
-                resolve(context, target.object(), cpath, itemFunction, createMissingKeys);
-            }
-            else if (!*cpath) {
-                itemFunction(&target);
+                index = static_cast<int32_t>(value);
+                return true;
             }
         }
 
-        void resolve(tes_context& context, object_base *collection, const char *cpath,
-            const std::function<void(item *)>& itemFunction, bool createMissingKeys)
-        {
+        std::shared_ptr<const compiled_path> compile_path(const util::cstring& fullPath) {
+            auto result = std::make_shared<compiled_path>();
+            auto& tokens = result->tokens;
+            path_type path = fullPath;
 
-            if (!collection || !cpath) {
-                return;
-            }
-
-            // path is empty -> just visit collection
-            if (!*cpath) {
-                item itm(collection);
-                itemFunction(&itm);
-                return ;
-            }
+            while (!path.empty()) {
+                path_token token;
 
-            namespace bs = boost;
-            namespace ss = std;
+                if (bs::starts_with(path, "@") && path.size() >= 2) {
+                    auto begin = path.begin() + 1;
+                    auto end = bs::find_if(path_type(begin, path.end()), bs::is_any_of("."));
+                    auto operationStr = ss::string(begin, end);
 
-            auto path = bs::make_iterator_range(cpath, cpath + strnlen_s(cpath, 1024));
+                    token.kind = path_token::operator_call;
+                    token.op = operationStr.empty() ? nullptr : operators::get_operator(operationStr.c_str());
+                    if (!token.op) {
+                        break;
+                    }
 
-            auto operatorRule = [createMissingKeys, &context](const state &st) -> state {
-                const auto& path = st.path;
+                    compile_operator_tail(token, path_type(end, path.end()));
+                    tokens.push_back(std::move(token));
+                    return result;
+                }
+                else if (bs::starts_with(path, ".") && path.size() >= 2) {
+                    auto begin = path.begin() + 1;
+                    auto end = bs::find_if(path_type(begin, path.end()), bs::is_any_of(".["));
+                    if (begin == end) {
+                        break;
+                    }
 
-                if (!bs::starts_with(path, "@") || path.size() < 2) {
-                    return state(false, st);
+                    token.kind = path_token::map_key;
+                    token.key.assign(begin, end);
+                    tokens.push_back(std::move(token));
+                    path = path_type(end, path.end());
                 }
+                else if (bs::starts_with(path, "[") && path.size() >= 3) {
+                    auto begin = path.begin() + 1;
+                    auto end = bs::find_if(path_type(begin, path.end()), bs::is_any_of("]"));
+                    auto indexRange = path_type(begin, end);
+                    if (indexRange.empty() || end == path.end()) {
+                        break;
+                    }
 
-                auto begin = path.begin() + 1;
-                auto end = bs::find_if(path_type(begin, path.end()), bs::is_any_of("."));
-                auto operationStr = ss::string(begin, end);
+                    if (!forms::is_form_string(indexRange.begin())) {
+                        token.kind = path_token::index_key;
+                        if (!parse_index(indexRange, token.index)) {
+                            break;
+                        }
+                    }
+                    else {
+                        auto fId = forms::from_string(indexRange);
+                        if (!fId) {
+                            break;
+                        }
+                        token.kind = path_token::form_key;
+                        token.form = *fId;
+                    }
 
-                if (operationStr.empty()) {
-                    return state(false, st);
+                    tokens.push_back(std::move(token));
+                    path = path_type(end + 1, path.end());
                 }
+                else {
+                    break;
+                }
+            }
 
-                auto rightPath = path_type(end, path.end());
+            result->complete = path.empty();
+            return result;
+        }
 
-                auto collection = st.nodeGetter(st.object)->object();
+        compiled_path_cache& path_cache() {
+            static compiled_path_cache cache;
+            return cache;
+        }
 
-                if (!collection) {
-                    return state(false, st);
+        item* path_executor::lookup(object_base& container, const path_token& token) const {
+            switch (token.kind) {
+            case path_token::map_key:
+                if (auto obj = container.as<map>()) {
+                    auto itemPtr = obj->u_get(token.key);
+                    if (!itemPtr && _createMissingKeys) {
+                        itemPtr = obj->u_set(token.key, item());
+                    }
+                    return itemPtr;
                 }
+                return nullptr;
+            case path_token::index_key:
+                if (auto obj = container.as<array>()) {
+                    return obj->u_get(token.index);
+                }
+                else if (auto obj = container.as<integer_map>()) {
+                    return obj->u_get(token.index);
+                }
+                return nullptr;
+            case path_token::form_key:
+                if (auto obj = container.as<form_map>()) {
+                    return obj->u_get(make_weak_form_id(token.form, _context));
+                }
+                return nullptr;
+            default:
+                return nullptr;
+            }
+        }
 
-                auto opr = operators::get_operator(operationStr.c_str());
-
-                if (!opr) {
-                    return state(false, st);
+        // Aggregates container values without copying the container: plain values are fed to the operator
+        // right under the lock. If there is a path to resolve inside each element, only element objects
+        // are collected (and retained) under the lock and resolved after it's released - so that
+        // self-referencing containers won't deadlock
+        void path_executor::apply_operator(object_base& collection, const path_token& token, operators::operator_state& state) const {
+            auto itemVisitFunc = [&](item *itm) {
+                if (itm) {
+                    token.op->func(*itm, state);
                 }
+            };
 
-                item sharedItem;
+            std::vector<object_stack_ref> nested;
 
-                auto itemVisitFunc = [&](item *item) {
-                    if (item) {
-                        opr->func(*item, sharedItem);
-                    }
-                };
+            struct helper {
+                const path_token& token;
+                operators::operator_state& state;
+                std::vector<object_stack_ref>& nested;
 
-                struct 
-                {
-                    decltype(context)       context;
-                    decltype(rightPath)     *rightPath;
-                    decltype(itemVisitFunc) *visitFunc;
-
-                    void operator()(array& arr) {
-                        // have to copy array to prevent its modification during iteration
-                        auto array_copy = arr.container_copy();
-                        for (auto &itm : array_copy) {
-                            resolve(context, itm, rightPath->begin(), *visitFunc);
-                        }
+                static bool is_empty(const compiled_path& path) {
+                    return path.tokens.empty() && path.complete;
+                }
+
+                void visit(const item& itm, const compiled_path& tail) {
+                    if (is_empty(tail)) {
+                        token.op->func(itm, state);
                     }
-                    void operator()(map& cnt) {
-                        _map_visit_helper(context, cnt, *rightPath, *visitFunc);
+                    else if (auto obj = itm.object()) {
+                        nested.emplace_back(obj);
+                    }
+                }
+
+                void operator()(array& arr) {
+                    object_lock lock(arr);
+                    state.visited = true;
+                    if (token.op->bulk && is_empty(*token.tail)) {
+                        token.op->bulk(arr.u_container(), state);
+                        return;
                     }
-                    void operator()(form_map& cnt) {
-                        _map_visit_helper(context, cnt, *rightPath, *visitFunc);
+                    for (auto &itm : arr.u_container()) {
+                        visit(itm, *token.tail);
                     }
-                    void operator()(integer_map& cnt) {
-                        _map_visit_helper(context, cnt, *rightPath, *visitFunc);
+                }
+                template<class T> void operator()(T& cnt) {
+                    if (!token.has_map_selector) {
+                        return;
                     }
 
-                } helper{ context, &rightPath, &itemVisitFunc };
-
-                perform_on_object(*collection, helper);
-
-                return state(true,
-                    [=](object_base *) mutable -> item* { return &sharedItem;},
-                    nullptr,
-                    path_type());
+                    object_lock lock(cnt);
+                    const T& ccnt = cnt;
+                    state.visited = true;
+                    if (token.visits_keys) {
+                        // keys are never objects, so there is nothing to resolve inside them
+                        if (is_empty(*token.map_tail)) {
+                            item itm;
+                            for (auto &pair : ccnt.u_container()) {
+                                itm = pair.first;
+                                token.op->func(itm, state);
+                            }
+                        }
+                    }
+                    else {
+                        for (auto &pair : ccnt.u_container()) {
+                            visit(pair.second, *token.map_tail);
+                        }
+                    }
+                }
             };
 
-            auto mapRule = [createMissingKeys, &context](const state &st) -> state {
+            perform_on_object(collection, helper{ token, state, nested });
 
-                const auto& path = st.path;
-
-                if (!bs::starts_with(path, ".") || path.size() < 2) {
-                    return state(false, st);
+            if (!nested.empty()) {
+                const compiled_path& tail = collection.as<array>() ? *token.tail : *token.map_tail;
+                for (auto& obj : nested) {
+                    path_executor{ _context, false }.execute(*obj, tail, itemVisitFunc);
                 }
+            }
+        }
 
-                auto begin = path.begin() + 1;
-                auto end = bs::find_if(path_type(begin, path.end()), bs::is_any_of(".["));
-
-                if (begin == end) {
-                    return state(false, st);
+        path_executor::destination path_executor::walk(object_base& collection, const compiled_path& path,
+            std::vector<object_stack_ref> *reached, size_t first) const
+        {
+            destination dest;
+            item root(&collection);
+            object_base *container = &collection;
+            const path_token *pending = nullptr; // key of the current node in the container. null - the root
+
+            if (reached) {
+                reached->resize(first);
+                if (first > 0) {
+                    container = reached->back().get();
+                    pending = &path.tokens[first - 1];
                 }
+            }
 
-                object_lock lock(st.object);
-                auto node = st.nodeGetter(st.object);
+            for (size_t i = first; i < path.tokens.size(); ++i) {
+                auto& token = path.tokens[i];
+                object_base *next = nullptr;
+                {
+                    object_lock lock(container);
+                    item *node = pending ? lookup(*container, *pending) : &root;
 
-                if (createMissingKeys && node && node->isNull()) {
-                    *node = map::object(context);
+                    if (token.kind == path_token::map_key && _createMissingKeys && node && node->isNull()) {
+                        *node = map::object(_context);
+                        if (pending) {
+                            perform_on_object(*container, ca::u_touch_helper());
+                        }
+                    }
+
+                    next = node ? node->object() : nullptr;
                 }
 
-                auto container = node ? node->object() : nullptr;
+                if (!next) {
+                    return dest;
+                }
 
-                if (!container) {
-                    return state(false, st);
+                if (reached) {
+                    reached->emplace_back(next);
                 }
 
-                return state(   true,
-                                    [=](object_base *container) {
-                                        item *itemPtr = nullptr;
+                if (token.kind == path_token::operator_call) {
+                    operators::operator_state state;
+                    apply_operator(*next, token, state);
+                    if (token.op->finish && state.visited) {
+                        token.op->finish(state, _context);
+                    }
+                    dest.operator_value = std::move(state.value);
+                    return dest;
+                }
 
-                                        if (auto obj = container->as<map>()) {
-                                            ss::string key(begin, end);
-                                            itemPtr = obj->u_get(key);
+                container = next;
+                pending = &token;
+            }
 
-                                            if (!itemPtr && createMissingKeys) {
-                                                obj->u_set(key, item());
-                                                itemPtr = obj->u_get(key);
-                                            }
-                                        }
+            if (path.complete) {
+                dest.container = container;
+                dest.key = pending;
+            }
+            return dest;
+        }
 
-                                        return itemPtr;
-                                },
-                                container,
-                                path_type(end, path.end()) );
-            };
+        void resolve(tes_context& context, item& target, const char *cpath,
+            const std::function<void(item *)>& itemFunction, bool createMissingKeys)
+        {
+            resolve<const std::function<void(item *)>&>(context, target, cpath, itemFunction, createMissingKeys);
+        }
 
-            auto arrayRule = [&context](const state &st) -> state {
+        void resolve(tes_context& context, object_base *collection, const char *cpath,
+            const std::function<void(item *)>& itemFunction, bool createMissingKeys)
+        {
+            resolve<const std::function<void(item *)>&>(context, collection, cpath, itemFunction, createMissingKeys);
+        }
 
-                const auto& path = st.path;
+        void resolve(tes_context& context, object_base *collection, const compiled_path& path,
+            const std::function<void(item *)>& itemFunction)
+        {
+            resolve<const std::function<void(item *)>&>(context, collection, path, itemFunction);
+        }
 
-                if (!bs::starts_with(path, "[") || path.size() < 3) {
-                    return state(false, st);
+        namespace {
+            bool same_step(const path_token& l, const path_token& r) {
+                if (l.kind != r.kind) {
+                    return false;
                 }
 
-                auto begin = path.begin() + 1;
-                auto end = bs::find_if(path_type(begin, path.end()), bs::is_any_of("]"));
-                auto indexRange = path_type(begin, end);
-
-                if (indexRange.empty()) {
-                    return state(false, st);
+                switch (l.kind) {
+                case path_token::map_key: return l.key == r.key;
+                case path_token::index_key: return l.index == r.index;
+                case path_token::form_key: return l.form == r.form;
+                default: return false;
                 }
+            }
+        }
 
-                int32_t indexOrFormId = 0;
-                FormId frmId = FormId::Zero;
+        void resolve_many(tes_context& context, object_base *collection, const std::vector<const char *>& paths,
+            const std::function<void(size_t, item *)>& itemFunction)
+        {
+            if (!collection) {
+                return;
+            }
 
-                if (!forms::is_form_string(indexRange.begin())) {
-                    try {
-                        indexOrFormId = std::stoi(ss::string(indexRange.begin(), indexRange.end()), nullptr, 0);
-                    }
-                    catch (const std::invalid_argument& ) {
-                        return state(false, st);
-                    }
-                    catch (const std::out_of_range& ) {
-                        return state(false, st);
-                    }
+            std::vector<std::shared_ptr<const compiled_path>> compiled(paths.size());
+            std::vector<size_t> order;
+            order.reserve(paths.size());
+
+            for (size_t i = 0; i < paths.size(); ++i) {
+                if (!paths[i]) {
+                    continue;
+                }
+                if (!*paths[i]) {
+                    item itm(collection);
+                    itemFunction(i, &itm);
+                    continue;
                 }
-                else {
-                    auto fId = forms::from_string(indexRange);
-                    if (!fId) {
-                        return state(false, st);
-                    }
 
-                    frmId = *fId;
-                }
-
-                object_lock lock(st.object);
-                auto container = st.nodeGetter(st.object)->object();
-
-                if (!container) {
-                    return state(false, st);
-                }
-
-                return state(   true,
-                                [=, &context](object_base* container) {
-                                    if (container->as<array>()) {
-                                        return container->as<array>()->u_get(indexOrFormId);
-                                    }
-                                    else if (container->as<form_map>()) {
-                                        return container->as<form_map>()->u_get(make_weak_form_id(frmId, context));
-                                    }
-                                    else if (container->as<integer_map>()) {
-                                        return container->as<integer_map>()->u_get(indexOrFormId);
-                                    }
-                                    else {
-                                        return (item *)nullptr;
-                                    } 
-                                },
-                                container,
-                                path_type(end + 1, path.end()) );
-            };
+                compiled[i] = path_cache().get(util::make_cstring_safe(paths[i], 1024));
+                order.push_back(i);
+            }
 
-            const ss::function<state (const state &st) > rules[] = {operatorRule, mapRule, arrayRule};
+            // paths with common prefixes become neighbours
+            std::sort(order.begin(), order.end(), [&](size_t l, size_t r) {
+                return strcmp(paths[l], paths[r]) < 0;
+            });
 
-            item root(collection);
-            state st(true, [&](object_base*) { return &root;}, collection, path);
+            path_executor executor{ context, false };
+            std::vector<object_stack_ref> reached;
+            const compiled_path *previous = nullptr;
 
-            while (true) {
+            for (size_t idx : order) {
+                const compiled_path& path = *compiled[idx];
 
-                bool anySucceed = false;
-                for (auto& func : rules) {
-                    st = func(st);
-                    anySucceed = st.succeed;
-                    if (anySucceed) {
-                        break;
+                // resume after the tokens shared with the previous path
+                size_t shared = 0;
+                if (previous) {
+                    auto limit = (std::min)(previous->tokens.size(), path.tokens.size());
+                    while (shared < limit && same_step(previous->tokens[shared], path.tokens[shared])) {
+                        ++shared;
                     }
                 }
-
-                if (st.path.empty() && anySucceed) {
-
-                    if (st.object) {
-                        object_lock lock(st.object);
-                        itemFunction( st.nodeGetter(st.object));
-                    } else {
-                        itemFunction( st.nodeGetter(nullptr));
-                    }
-
-                    break;
+                // reached[shared] is the container both paths lead to. The steps before @first are skipped,
+                // so none of them may be an operator
+                size_t first = (std::min)({ shared + 1, reached.size(), path.tokens.size() });
+                if (first > 0 && path.tokens[first - 1].kind == path_token::operator_call) {
+                    --first;
                 }
 
-                if (!anySucceed) {
-                    itemFunction(nullptr);
-                    break;
-                }
+                auto func = [&](item *itm) { itemFunction(idx, itm); };
+                executor.execute(*collection, path, func, &reached, first);
+                previous = &path;
             }
         }
     }
@@ -2,11 +2,13 @@
 
 #include <functional>
 #include <type_traits>
+#include <vector>
 #include <boost/optional.hpp>
 #include <boost/variant/variant.hpp>
 
 #include "collections/collections.h"
 #include "collections/default_value.h"
+#include "collections/path_compiler.h"
 
 namespace collections
 {
@@ -16,12 +18,62 @@ namespace collections
 
     namespace path_resolving {
 
+        // Resolves the @cpath, @itemFunction receives the value or null if there is no value. It gets called
+        // under the lock of the container which holds the value. The callable is not wrapped into std::function:
+        // the std::function overloads below only forward here
+        template<class F>
+        void resolve(tes_context& ctx, object_base *target, const char *cpath, F&& itemFunction, bool createMissingKeys = false) {
+            if (!target || !cpath) {
+                return;
+            }
+
+            // path is empty -> just visit collection
+            if (!*cpath) {
+                item itm(target);
+                itemFunction(&itm);
+                return;
+            }
+
+            auto compiled = path_cache().get(util::make_cstring_safe(cpath, 1024));
+            path_executor{ ctx, createMissingKeys }.execute(*target, *compiled, itemFunction);
+        }
+
+        template<class F>
+        void resolve(tes_context& ctx, item& target, const char *cpath, F&& itemFunction, bool createMissingKeys = false) {
+            if (!cpath) {
+                return;
+            }
+
+            if (target.object()) {
+                resolve(ctx, target.object(), cpath, itemFunction, createMissingKeys);
+            }
+            else if (!*cpath) {
+                itemFunction(&target);
+            }
+        }
+
+        // same, but the @path was compiled beforehand
+        template<class F>
+        void resolve(tes_context& ctx, object_base *target, const compiled_path& path, F&& itemFunction) {
+            if (target) {
+                path_executor{ ctx, false }.execute(*target, path, itemFunction);
+            }
+        }
+
         void resolve(tes_context& ctx, item& target, const char *cpath,
             const std::function<void(item *)>& itemFunction, bool createMissingKeys = false);
 
         void resolve(tes_context& ctx, object_base *target, const char *cpath,
             const std::function<void(item *)>& itemFunction, bool createMissingKeys = false);
 
+        void resolve(tes_context& ctx, object_base *target, const compiled_path& path,
+            const std::function<void(item *)>& itemFunction);
+
+        // Resolves each of the @paths, @itemFunction receives index of the path and its value.
+        // Paths sharing leading keys visit the shared part once
+        void resolve_many(tes_context& ctx, object_base *target, const std::vector<const char *>& paths,
+            const std::function<void(size_t, item *)>& itemFunction);
+
         template<class T>
         inline T _resolve(tes_context& ctx, object_base *target, const char *cpath, T def = default_value<T>()) {
             resolve(ctx, target, cpath, [&](item *itm) {
@@ -86,6 +138,28 @@ namespace collections
             return perform_on_object_and_return<bool >(collection, u_erase_key_helper(), key);
         }
 
+        struct key_to_item : bs::static_visitor<item> {
+            template<class Key> item operator () (const Key& key) const { return item(key); }
+        };
+
+        inline void u_record_change(object_base& collection, const key_variant& key) {
+            if (collection.is_watched()) {
+                collections::u_record_change(collection, bs::apply_visitor(key_to_item(), key));
+            }
+        }
+
+        struct u_touch_helper {
+            void operator () (array&) const {}
+            template<class T> void operator () (T& cnt) const { cnt.u_touch(); }
+        };
+
+        // A value of the @collection got replaced through an item pointer: bumps the map version, so that
+        // the caches relying on it notice the change, and tells the change subscribers
+        inline void u_value_replaced(object_base& collection, const key_variant& key) {
+            perform_on_object(collection, u_touch_helper());
+            u_record_change(collection, key);
+        }
+
         struct accesss_info {
             object_base& collection;
             key_variant key;
@@ -133,6 +207,24 @@ namespace collections
             }
         }
 
+        // same as visit_value, but tells change subscribers that the value has changed
+        template<class Func>
+        inline bool modify_value(object_base& target, const char *cpath, access_way way, Func f) {
+            auto ac_info = (way == constant ? access_constant(target, cpath) : access_creative(target, cpath));
+            if (ac_info) {
+                object_lock g(ac_info->collection);
+                auto itmPtr = u_access_value(ac_info->collection, ac_info->key);
+                if (itmPtr) {
+                    f(*itmPtr);
+                    u_value_replaced(ac_info->collection, ac_info->key);
+                }
+                return itmPtr != nullptr;
+            }
+            else {
+                return false;
+            }
+        }
+
         template<class Value>
         inline bs::optional<Value> get(object_base& target, const char *cpath) {
             auto ac_info = access_constant(target, cpath);
@@ -155,6 +247,7 @@ namespace collections
                     auto itmPtr = u_access_value(ac_info->collection, ac_info->key);
                     if (itmPtr) {
                         *itmPtr = std::forward<Value>(value);
+                        u_value_replaced(ac_info->collection, ac_info->key);
                     }
                     return itmPtr != nullptr;
                 } else {
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+
+#include "util/spinlock.h"
+#include "skse/skse.h"
+#include "object/background_tasks.h"
+#include "collections/collections.h"
+
+namespace collections {
+
+    // Per-context file reads and writes running on the background worker, identified by number.
+    // A request is done in two parts: the I/O part runs outside of the context's gate and must not touch
+    // the context, the completion it returns runs under the gate and builds the resulting container.
+    // The result is retained until taken. Requests aren't saved
+    class async_requests {
+    public:
+
+        enum status_t : int32_t {
+            no_request = 0,
+            pending,
+            completed,
+            failed,
+        };
+
+        // builds the request's result (may leave it empty), returns false if the request failed
+        using completion = std::function<bool(internal_object_ref& result)>;
+        using io_part = std::function<completion()>;
+
+    private:
+
+        struct request {
+            status_t status = pending;
+            internal_object_ref result;
+            // SKSE ModEvent sent once the request is done
+            std::string mod_event;
+        };
+
+        background_tasks& _tasks;
+
+        util::spinlock _lock;
+        std::map<int32_t, request> _requests;
+        int32_t _last_id = 0;
+
+    public:
+
+        // the requests retain their results until taken, so their number is limited
+        enum { kMaxRequests = 1024 };
+
+        explicit async_requests(background_tasks& tasks) : _tasks(tasks) {}
+
+        // Returns 0 if there are too many requests. If the @modEvent isn't empty, the ModEvent gets sent once
+        // the request is done, with the request number as its numeric argument
+        int32_t start(const char *modEvent, io_part io) {
+            int32_t id = 0;
+            {
+                util::spinlock::guard g(_lock);
+                if (_requests.size() >= kMaxRequests) {
+                    return 0;
+                }
+
+                if (++_last_id <= 0) {
+                    _last_id = 1;
+                }
+                id = _last_id;
+                _requests[id].mod_event = modEvent ? modEvent : "";
+            }
+
+            _tasks.post_prepared([this, id, io]() -> std::function<void()> {
+                completion complete = io();
+                return [this, id, complete]() { finish(id, complete); };
+            });
+            return id;
+        }
+
+        status_t status(int32_t id) {
+            util::spinlock::guard g(_lock);
+            auto itr = _requests.find(id);
+            return itr != _requests.end() ? itr->second.status : no_request;
+        }
+
+        // removes the done request from the set and returns its result
+        internal_object_ref take(int32_t id) {
+            util::spinlock::guard g(_lock);
+            auto itr = _requests.find(id);
+            if (itr == _requests.end() || itr->second.status == pending) {
+                return nullptr;
+            }
+            auto result = std::move(itr->second.result);
+            _requests.erase(itr);
+            return result;
+        }
+
+        size_t size() {
+            util::spinlock::guard g(_lock);
+            return _requests.size();
+        }
+
+        // the requests in progress complete silently
+        void clear() {
+            decltype(_requests) requests;
+            {
+                util::spinlock::guard g(_lock);
+                requests.swap(_requests);
+            }
+        }
+
+    private:
+
+        bool is_pending(int32_t id) {
+            util::spinlock::guard g(_lock);
+            auto itr = _requests.find(id);
+            return itr != _requests.end() && itr->second.status == pending;
+        }
+
+        // run by the gate, never concurrently with other context tasks
+        void finish(int32_t id, const completion& complete) {
+            // the request might have been dropped along with the state
+            if (!is_pending(id)) {
+                return;
+            }
+
+            internal_object_ref result;
+            bool succeeded = complete && complete(result);
+
+            std::string modEvent;
+            {
+                util::spinlock::guard g(_lock);
+                auto itr = _requests.find(id);
+                if (itr == _requests.end()) {
+                    return;
+                }
+                itr->second.status = succeeded ? completed : failed;
+                itr->second.result = std::move(result);
+                modEvent.swap(itr->second.mod_event);
+            }
+
+            if (!modEvent.empty()) {
+                skse::send_mod_event(modEvent.c_str(), succeeded ? "completed" : "failed", (float)id);
+            }
+        }
+    };
+}
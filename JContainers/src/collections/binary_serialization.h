@@ -0,0 +1,461 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <string>
+#include <fstream>
+#include <unordered_map>
+#include <stdexcept>
+
+#include "forms/form_handling.h"
+#include "collections/collections.h"
+
+namespace collections {
+
+    // Compact self-describing binary alternative to JSON files:
+    //
+    //  file   := magic version root-item record*
+    //  record := varint(count) entry*           - one per container, in order of first appearance
+    //  entry  := item | string item | form item | int32 item    - array, map, form-map, int-map entries
+    //  item   := tag payload
+    //
+    // A container is written as an object-reference tag carrying its type and index. The first reference to
+    // an index creates the container, so the file can be read and written in a single streaming pass,
+    // and shared or cyclic references cost a few bytes instead of a path string.
+    // Forms are stored as a plugin name and a local form id, so the file does not depend on load order
+    namespace binary_serialization {
+
+        const char magic[] = { 'J', 'C', 'B', 'F' };
+        const uint8_t version = 1;
+
+        enum item_tag : uint8_t {
+            tag_none = 0,
+            tag_int,
+            tag_float,
+            tag_string,
+            tag_form,
+            tag_object,
+        };
+
+        enum object_tag : uint8_t {
+            object_array = 0,
+            object_map,
+            object_form_map,
+            object_integer_map,
+        };
+
+        struct format_error : std::runtime_error {
+            explicit format_error(const char *what) : std::runtime_error(what) {}
+        };
+    }
+
+    class binary_serializer {
+
+        typedef binary_serialization::item_tag item_tag;
+        typedef binary_serialization::object_tag object_tag;
+
+        std::ostream& _out;
+        std::unordered_map<const object_base*, uint32_t> _indexes;
+        std::deque<const object_base*> _toWrite;
+
+        explicit binary_serializer(std::ostream& out) : _out(out) {}
+
+    public:
+
+        static bool write(const object_base& root, std::ostream& out) {
+            binary_serializer ser(out);
+            ser._write(root);
+            return !out.fail();
+        }
+
+        static bool write_file(const object_base& root, const char *path) {
+            if (!path) {
+                return false;
+            }
+
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            return file.is_open() && write(root, file);
+        }
+
+    private:
+
+        void _write(const object_base& root) {
+            namespace bs = binary_serialization;
+
+            _out.write(bs::magic, sizeof bs::magic);
+            write_raw(bs::version);
+            write_object_ref(root);
+
+            while (!_toWrite.empty() && !_out.fail()) {
+                auto& object = *_toWrite.front();
+                _toWrite.pop_front();
+                write_record(object);
+            }
+        }
+
+        template<class T> void write_raw(const T& value) {
+            _out.write(reinterpret_cast<const char*>(&value), sizeof value);
+        }
+
+        void write_varint(uint32_t value) {
+            while (value >= 0x80) {
+                _out.put(static_cast<char>(value | 0x80));
+                value >>= 7;
+            }
+            _out.put(static_cast<char>(value));
+        }
+
+        void write_string(const char *str, size_t length) {
+            write_varint(static_cast<uint32_t>(length));
+            _out.write(str, length);
+        }
+
+        // false if the form can't be bound to a plugin. Such forms are lost, same as in JSON
+        static bool is_writable_form(FormId id) {
+            return !forms::is_static(id) || skse::modname_from_index(forms::mod_index(id)) != nullptr;
+        }
+
+        void write_form(FormId id) {
+            const char *modName = forms::is_static(id) ? skse::modname_from_index(forms::mod_index(id)) : "";
+            write_string(modName, strlen(modName));
+            write_raw(forms::is_static(id) ? forms::local_id(id) : (uint32_t)id);
+        }
+
+        static object_tag object_type(const object_base& object) {
+            namespace bs = binary_serialization;
+
+            if (object.as<array>()) { return bs::object_array; }
+            if (object.as<map>()) { return bs::object_map; }
+            if (object.as<form_map>()) { return bs::object_form_map; }
+            return bs::object_integer_map;
+        }
+
+        void write_object_ref(const object_base& object) {
+            auto result = _indexes.emplace(&object, static_cast<uint32_t>(_indexes.size()));
+            if (result.second) {
+                _toWrite.push_back(&object);
+            }
+
+            write_raw(binary_serialization::tag_object);
+            write_raw(object_type(object));
+            write_varint(result.first->second);
+        }
+
+        void write_item(const item& itm) {
+            namespace bs = binary_serialization;
+
+            struct item_visitor : boost::static_visitor<> {
+                binary_serializer& ser;
+
+                explicit item_visitor(binary_serializer& s) : ser(s) {}
+
+                void operator()(const boost::blank&) const {
+                    ser.write_raw(bs::tag_none);
+                }
+                void operator()(const SInt32& val) const {
+                    ser.write_raw(bs::tag_int);
+                    ser.write_raw(val);
+                }
+                void operator()(const item::Real& val) const {
+                    ser.write_raw(bs::tag_float);
+                    ser.write_raw(val);
+                }
+                void operator()(const std::string& val) const {
+                    ser.write_raw(bs::tag_string);
+                    ser.write_string(val.c_str(), val.size());
+                }
+                void operator()(const form_ref& val) const {
+                    if (is_writable_form(val.get())) {
+                        ser.write_raw(bs::tag_form);
+                        ser.write_form(val.get());
+                    }
+                    else {
+                        ser.write_raw(bs::tag_none);
+                    }
+                }
+                void operator()(const internal_object_ref& val) const {
+                    if (object_base *obj = val.get()) {
+                        ser.write_object_ref(*obj);
+                    }
+                    else {
+                        ser.write_raw(bs::tag_none);
+                    }
+                }
+            };
+
+            itm.var().apply_visitor(item_visitor(*this));
+        }
+
+        void write_record(const object_base& object) {
+            struct helper {
+                binary_serializer * self;
+
+                void operator () (const array& cnt) {
+                    self->write_varint(static_cast<uint32_t>(cnt.u_container().size()));
+                    for (auto& itm : cnt.u_container()) {
+                        self->write_item(itm);
+                    }
+                }
+                void operator () (const map& cnt) {
+                    self->write_varint(static_cast<uint32_t>(cnt.u_container().size()));
+                    for (auto& pair : cnt.u_container()) {
+                        self->write_string(pair.first.c_str(), pair.first.size());
+                        self->write_item(pair.second);
+                    }
+                }
+                void operator () (const form_map& cnt) {
+                    // forms that can't be bound to a plugin are skipped, so the count is not known upfront
+                    std::vector<std::pair<FormId, const item*>> entries;
+                    entries.reserve(cnt.u_container().size());
+                    for (auto& pair : cnt.u_container()) {
+                        auto id = pair.first.get();
+                        if (is_writable_form(id)) {
+                            entries.emplace_back(id, &pair.second);
+                        }
+                    }
+
+                    self->write_varint(static_cast<uint32_t>(entries.size()));
+                    for (auto& pair : entries) {
+                        self->write_form(pair.first);
+                        self->write_item(*pair.second);
+                    }
+                }
+                void operator () (const integer_map& cnt) {
+                    self->write_varint(static_cast<uint32_t>(cnt.u_container().size()));
+                    for (auto& pair : cnt.u_container()) {
+                        self->write_raw(pair.first);
+                        self->write_item(pair.second);
+                    }
+                }
+            };
+
+            object_lock lock(object);
+            perform_on_object(object, helper{ this });
+        }
+    };
+
+    class binary_deserializer {
+
+        typedef binary_serialization::item_tag item_tag;
+        typedef binary_serialization::object_tag object_tag;
+
+        tes_context& _context;
+        std::istream& _in;
+        std::vector<object_base*> _objects;
+        std::string _buffer;
+        // end of the data if the stream is seekable, bounds the string lengths read from the data
+        std::istream::pos_type _end = -1;
+
+        binary_deserializer(tes_context& context, std::istream& in) : _context(context), _in(in) {
+            auto pos = _in.tellg();
+            if (pos != std::istream::pos_type(-1)) {
+                if (_in.seekg(0, std::ios::end)) {
+                    _end = _in.tellg();
+                }
+                _in.clear();
+                _in.seekg(pos);
+            }
+        }
+
+    public:
+
+        static object_base* read(tes_context& context, std::istream& in) {
+            try {
+                return binary_deserializer(context, in)._read();
+            }
+            catch (const binary_serialization::format_error& exc) {
+                JC_log("Can't read binary container data: %s", exc.what());
+                return nullptr;
+            }
+        }
+
+        static object_base* read_file(tes_context& context, const char *path) {
+            if (!path) {
+                return nullptr;
+            }
+
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open()) {
+                return nullptr;
+            }
+
+            auto obj = read(context, file);
+            if (!obj) {
+                JC_LOG_ERROR("Can't read binary file at '%s'", path);
+            }
+            return obj;
+        }
+
+    private:
+
+        object_base* _read() {
+            namespace bs = binary_serialization;
+
+            char fileMagic[sizeof bs::magic] = { 0 };
+            _in.read(fileMagic, sizeof fileMagic);
+            if (_in.fail() || memcmp(fileMagic, bs::magic, sizeof fileMagic) != 0) {
+                throw bs::format_error("not a binary container file");
+            }
+            if (read_raw<uint8_t>() != bs::version) {
+                throw bs::format_error("unsupported version");
+            }
+
+            if (read_raw<item_tag>() != bs::tag_object) {
+                throw bs::format_error("root is not a container");
+            }
+            object_base& root = read_object_ref();
+
+            for (size_t i = 0; i < _objects.size(); ++i) {
+                read_record(*_objects[i]);
+            }
+
+            return &root;
+        }
+
+        template<class T> T read_raw() {
+            T value;
+            _in.read(reinterpret_cast<char*>(&value), sizeof value);
+            if (_in.fail()) {
+                throw binary_serialization::format_error("unexpected end of data");
+            }
+            return value;
+        }
+
+        uint32_t read_varint() {
+            uint32_t value = 0;
+            for (int shift = 0; shift < 35; shift += 7) {
+                auto byte = read_raw<uint8_t>();
+                value |= uint32_t(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0) {
+                    return value;
+                }
+            }
+            throw binary_serialization::format_error("malformed varint");
+        }
+
+        // a string stored in a non-seekable stream can't be longer
+        enum { kMaxStringLength = 0x1000000 };
+
+        const std::string& read_string() {
+            auto length = read_varint();
+            if (length > kMaxStringLength || (_end != std::istream::pos_type(-1) && length > _end - _in.tellg())) {
+                throw binary_serialization::format_error("string length exceeds the data size");
+            }
+
+            _buffer.resize(length);
+            if (!_buffer.empty()) {
+                _in.read(&_buffer[0], _buffer.size());
+                if (_in.fail()) {
+                    throw binary_serialization::format_error("unexpected end of data");
+                }
+            }
+            return _buffer;
+        }
+
+        // none if the plugin the form belongs to is not loaded
+        boost::optional<FormId> read_form_id() {
+            const std::string& modName = read_string();
+            auto localId = read_raw<uint32_t>();
+
+            if (modName.empty()) {
+                return (FormId)localId;
+            }
+
+            auto modIdx = skse::modindex_from_name(modName.c_str());
+            if (modIdx == FormGlobalPrefix) {
+                return boost::none;
+            }
+            return forms::construct(modIdx, localId);
+        }
+
+        object_base& read_object_ref() {
+            namespace bs = binary_serialization;
+
+            auto type = read_raw<object_tag>();
+            auto index = read_varint();
+
+            if (index < _objects.size()) {
+                return *_objects[index];
+            }
+            if (index != _objects.size()) {
+                throw bs::format_error("object index out of order");
+            }
+
+            object_base *object = nullptr;
+            switch (type) {
+            case bs::object_array: object = &array::object(_context); break;
+            case bs::object_map: object = &map::object(_context); break;
+            case bs::object_form_map: object = &form_map::object(_context); break;
+            case bs::object_integer_map: object = &integer_map::object(_context); break;
+            default:
+                throw bs::format_error("unknown object type");
+            }
+
+            _objects.push_back(object);
+            return *object;
+        }
+
+        item read_item() {
+            namespace bs = binary_serialization;
+
+            switch (read_raw<item_tag>()) {
+            case bs::tag_none:
+                return item();
+            case bs::tag_int:
+                return item(read_raw<SInt32>());
+            case bs::tag_float:
+                return item(read_raw<item::Real>());
+            case bs::tag_string:
+                return item(read_string());
+            case bs::tag_form:
+                return item(make_weak_form_id(read_form_id().get_value_or(FormId::Zero), _context));
+            case bs::tag_object:
+                return item(read_object_ref());
+            default:
+                throw bs::format_error("unknown item tag");
+            }
+        }
+
+        void read_record(object_base& object) {
+            struct helper {
+                binary_deserializer * self;
+
+                void operator () (array& cnt) {
+                    auto count = self->read_varint();
+                    for (uint32_t i = 0; i < count; ++i) {
+                        cnt.u_push(self->read_item());
+                    }
+                }
+                void operator () (map& cnt) {
+                    auto count = self->read_varint();
+                    for (uint32_t i = 0; i < count; ++i) {
+                        std::string key = self->read_string();
+                        cnt.u_set(key, self->read_item());
+                    }
+                }
+                void operator () (form_map& cnt) {
+                    auto count = self->read_varint();
+                    for (uint32_t i = 0; i < count; ++i) {
+                        auto key = self->read_form_id();
+                        auto value = self->read_item();
+                        if (key) {
+                            cnt.u_set(make_weak_form_id(*key, self->_context), std::move(value));
+                        }
+                    }
+                }
+                void operator () (integer_map& cnt) {
+                    auto count = self->read_varint();
+                    for (uint32_t i = 0; i < count; ++i) {
+                        auto key = self->read_raw<int32_t>();
+                        cnt.u_set(key, self->read_item());
+                    }
+                }
+            };
+
+            object_lock lock(object);
+            perform_on_object(object, helper{ this });
+        }
+    };
+
+}
@@ -58,7 +58,7 @@ namespace reflection { namespace binding {
     template<> struct GetConv < forms::form_ref > {
         typedef TESForm* tes_type;
         static TESForm* convert2Tes(const forms::form_ref& id) {
-            return skse::lookup_form(id.get());
+            return id.form();
         }
         static forms::form_ref convert2J(const TESForm* form, tes_context& ctx) {
             return make_weak_form_id(form, ctx);
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "util/spinlock.h"
+#include "skse/skse.h"
+#include "object/background_tasks.h"
+#include "collections/collections.h"
+
+namespace collections {
+
+    // Per-context change subscriptions. A subscription watches a container and accumulates the keys (array indexes)
+    // changed since the last poll. Repeated changes of the same key are coalesced, so a subscriber polling
+    // at any rate receives at most one record per key. A subscription ends once its container gets destroyed.
+    // Subscriptions aren't saved.
+    // Changes get recorded under the container lock, so ModEvents are queued and sent by a background task:
+    // a synchronous event dispatch must not run while the changed container is locked
+    class change_feed {
+
+        struct subscription {
+            Handle object = Handle::Null;
+            // object_base::_serial of the container, tells it from an object which has reused its handle
+            uint64_t serial = 0;
+            // SKSE ModEvent sent on the first change since the last poll
+            std::string mod_event;
+            bool notified = false;
+            std::set<item> keys;
+            // the container has changed as a whole: got cleared, sorted, items were inserted
+            // or erased, or too many keys changed
+            bool whole = false;
+        };
+
+        typedef std::vector<std::pair<std::string, int32_t>> event_list;
+
+        background_tasks& _background;
+        util::spinlock _lock;
+        std::map<int32_t, subscription> _subscriptions;
+        std::unordered_multimap<HandleT, int32_t> _by_object;
+        int32_t _last_id = 0;
+        // ModEvents waiting for the background task, and whether the task is posted already
+        event_list _pending_events;
+        bool _send_posted = false;
+
+    public:
+
+        explicit change_feed(background_tasks& background) : _background(background) {}
+
+        enum { kMaxPendingKeys = 256 };
+
+        struct batch {
+            std::vector<item> keys;
+            bool whole;
+        };
+
+        // Returns the subscription id. If the @modEvent isn't empty, the ModEvent gets sent on the first change
+        // since the last poll, with the subscription id as its numeric argument
+        int32_t subscribe(object_base& container, const char *modEvent = nullptr) {
+            auto handle = container.uid();
+            ++container._watchers;
+
+            util::spinlock::guard g(_lock);
+            int32_t id = ++_last_id;
+            auto& sub = _subscriptions[id];
+            sub.object = handle;
+            sub.serial = container._serial;
+            sub.mod_event = modEvent ? modEvent : "";
+            _by_object.emplace((HandleT)handle, id);
+            return id;
+        }
+
+        bool unsubscribe(object_context& context, int32_t id) {
+            Handle handle = Handle::Null;
+            uint64_t serial = 0;
+            {
+                util::spinlock::guard g(_lock);
+                auto itr = _subscriptions.find(id);
+                if (itr == _subscriptions.end()) {
+                    return false;
+                }
+
+                handle = itr->second.object;
+                serial = itr->second.serial;
+                _subscriptions.erase(itr);
+
+                auto range = _by_object.equal_range((HandleT)handle);
+                for (auto it = range.first; it != range.second; ++it) {
+                    if (it->second == id) {
+                        _by_object.erase(it);
+                        break;
+                    }
+                }
+            }
+
+            object_stack_ref obj = context.getObjectRef(handle);
+            if (obj && obj->_serial == serial) {
+                --obj->_watchers;
+            }
+            return true;
+        }
+
+        // ends the subscriptions of the @container, called once it's being destroyed
+        void drop(object_base& container) {
+            util::spinlock::guard g(_lock);
+
+            auto range = _by_object.equal_range((HandleT)container._uid());
+            for (auto it = range.first; it != range.second;) {
+                auto itr = _subscriptions.find(it->second);
+                if (itr != _subscriptions.end() && itr->second.serial == container._serial) {
+                    _subscriptions.erase(itr);
+                    it = _by_object.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+
+        // called under the container lock
+        void record(object_base& container, const item& key) {
+            bool postSend = false;
+            {
+                util::spinlock::guard g(_lock);
+                _record(container, key, _pending_events);
+                if (!_pending_events.empty() && !_send_posted) {
+                    _send_posted = postSend = true;
+                }
+            }
+
+            if (postSend) {
+                _background.post([this]() { send_pending_events(); });
+            }
+        }
+
+        // sends the queued ModEvents. Runs on the background worker, where no container is locked
+        void send_pending_events() {
+            event_list events;
+            {
+                util::spinlock::guard g(_lock);
+                events.swap(_pending_events);
+                _send_posted = false;
+            }
+
+            for (auto& event : events) {
+                skse::send_mod_event(event.first.c_str(), "changed", (float)event.second);
+            }
+        }
+
+    private:
+
+        void _record(object_base& container, const item& key, event_list& events) {
+            auto range = _by_object.equal_range((HandleT)container._uid());
+            for (auto it = range.first; it != range.second; ++it) {
+                auto& sub = _subscriptions[it->second];
+                if (sub.serial != container._serial) {
+                    continue;
+                }
+
+                if (!sub.notified && !sub.mod_event.empty()) {
+                    sub.notified = true;
+                    events.emplace_back(sub.mod_event, it->second);
+                }
+
+                if (sub.whole) {
+                    continue;
+                }
+
+                if (key.isNull() || sub.keys.size() >= kMaxPendingKeys) {
+                    sub.whole = true;
+                    sub.keys.clear();
+                }
+                else {
+                    sub.keys.insert(key);
+                }
+            }
+        }
+
+    public:
+
+        // takes the changes accumulated since the last poll. None if there is no such subscription
+        boost::optional<batch> poll(int32_t id) {
+            util::spinlock::guard g(_lock);
+            auto itr = _subscriptions.find(id);
+            if (itr == _subscriptions.end()) {
+                return boost::none;
+            }
+
+            auto& sub = itr->second;
+            batch result{ std::vector<item>(sub.keys.begin(), sub.keys.end()), sub.whole };
+            sub.keys.clear();
+            sub.whole = false;
+            sub.notified = false;
+            return result;
+        }
+
+        size_t size() {
+            util::spinlock::guard g(_lock);
+            return _subscriptions.size();
+        }
+
+        void clear() {
+            util::spinlock::guard g(_lock);
+            _subscriptions.clear();
+            _by_object.clear();
+            _pending_events.clear();
+        }
+    };
+}
@@ -4,6 +4,7 @@
 #include <boost/serialization/export.hpp>
 
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/string.hpp>
 #include <boost/serialization/map.hpp>
 #include <boost/serialization/variant.hpp>
 #include <boost/serialization/shared_ptr.hpp>
@@ -153,6 +154,10 @@ namespace collections {
         util::tree_erase_if(cnt, [](const value_type& pair){
             return pair.first.is_expired();
         });
+
+        for (auto& pair : cnt) {
+            u_record_form_key(*this, pair.first.get_raw());
+        }
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -164,4 +169,14 @@ namespace collections {
     }
 
     //////////////////////////////////////////////////////////////////////////
+
+    void u_record_change(object_base& container, const item& key) {
+        HACK_get_tcontext(container).changes.record(container, key);
+    }
+
+    void u_record_form_key(object_base& container, FormId formId) {
+        HACK_get_tcontext(container).expired_form_keys.record(container, formId);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
 }
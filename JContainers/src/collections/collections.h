@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include <string>
 #include <assert.h>
@@ -20,6 +21,14 @@ namespace collections {
 
 	class tes_context;
 
+    // Tells subscribers of the @container that its @key has changed, see change_feed.
+    // Null @key means that the whole container has changed. Called under the container lock
+    void u_record_change(object_base& container, const item& key);
+
+    // Tells the context that the form-keyed @container has got a key of the @formId form, see form_key_purger.
+    // Called under the container lock
+    void u_record_form_key(object_base& container, FormId formId);
+
     template<class T>
     class collection_base : public object_base
     {
@@ -38,6 +47,13 @@ namespace collections {
         object_base& base() { return *this; }
         const object_base& base() const { return *this; }
 
+        // tells change subscribers, if any, that the @key (or the whole container, if the key is None) has changed
+        void u_changed(const item& key = item()) {
+            if (this->is_watched()) {
+                u_record_change(*this, key);
+            }
+        }
+
         typedef typename object_stack_ref_template<T> ref;
         typedef typename object_stack_ref_template<const T> cref;
 
@@ -152,10 +168,14 @@ namespace collections {
 
         template<class T> void u_push(T&& item) {
             _array.emplace_back(std::forward<T>(item));
+            if (is_watched()) {
+                u_changed(collections::item((SInt32)_array.size() - 1));
+            }
         }
 
         void u_clear() override {
             _array.clear();
+            u_changed();
         }
 
         SInt32 u_count() const override {
@@ -193,6 +213,7 @@ namespace collections {
             auto idx = u_convertIndex(index);
             if (idx) {
                 _array.erase(_array.begin() + *idx);
+                u_changed();
                 return true;
             }
             return false;
@@ -202,7 +223,11 @@ namespace collections {
         item* u_set(int32_t index, T&& itm) {
             auto idx = u_convertIndex(index);
             if (idx) {
-                return &(_array[*idx] = std::forward<T>(itm));
+                item& value = (_array[*idx] = std::forward<T>(itm));
+                if (is_watched()) {
+                    u_changed(item((SInt32)*idx));
+                }
+                return &value;
             }
             return nullptr;
         }
@@ -253,17 +278,49 @@ namespace collections {
         using const_iterator = typename container_type::const_iterator;
     protected:
         ContainerType cnt;
+        // bumped by mutations: a key gets inserted or erased, a value gets replaced, the container gets cleared
+        // or replaced as a whole
+        std::atomic<uint32_t> _version{ 0 };
 
         template<class ContainerType>
         static util::choose_iterator<ContainerType> _find(ContainerType& c, const key_type& k) { return c.find(k); }
 
+        // the key to search the container with. A container which accepts other key types converts them here
+        template<class Key>
+        const Key& u_lookup_key(const Key& key) const { return key; }
+
+        template<class Key>
+        const_iterator u_find(const Key& key) const {
+            return RealType::_find(cnt, static_cast<const RealType*>(this)->u_lookup_key(key));
+        }
+
+        template<class Key>
+        iterator u_find(const Key& key) {
+            return RealType::_find(cnt, static_cast<const RealType*>(this)->u_lookup_key(key));
+        }
+
     public:
 
+        // Marks the container modified. Called by the mutating methods; a caller which replaces a value through
+        // a pointer or a reference obtained with u_get or u_get_or_create has to call it too.
+        // The container is guarded by the object lock, so plain increment is enough
+        void u_touch() {
+            _version.store(_version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        // changes whenever the container gets modified. Can be read without the lock,
+        // to tell whether lookups cached earlier are still valid
+        uint32_t version() const {
+            return _version.load(std::memory_order_relaxed);
+        }
+
         const container_type& u_container() const {
             return cnt;
         }
 
+        // mutable access to the whole container. Readers should use the const overload
         container_type& u_container() {
+            u_touch();
             return cnt;
         }
 
@@ -287,12 +344,17 @@ namespace collections {
         }
 
         item& u_get_or_create(const key_type& key) {
-            return cnt[key];
+            auto itr = cnt.lower_bound(key);
+            if (itr == cnt.end() || cnt.key_comp()(key, itr->first)) {
+                u_touch();
+                itr = cnt.emplace_hint(itr, key, item());
+            }
+            return itr->second;
         }
 
         template<class Key>
         const item* u_get(const Key& key) const {
-            auto itr = RealType::_find(cnt, key);
+            auto itr = u_find(key);
             return itr != cnt.end() ? &(itr->second) : nullptr;
         }
 
@@ -302,7 +364,7 @@ namespace collections {
         }
 
         template<class Key>
-        const_iterator u_find_iterator(const Key& k) const { return RealType::_find(cnt, k); }
+        const_iterator u_find_iterator(const Key& k) const { return u_find(k); }
 
         template<class Key>
         bool erase(const Key& key) {
@@ -312,16 +374,32 @@ namespace collections {
 
         template<class Key>
         bool u_erase(const Key& key) {
-            typename container_type::iterator itr = RealType::_find(cnt, key);
-            return itr != cnt.end() ? (cnt.erase(itr), true) : false;
+            iterator itr = u_find(key);
+            if (itr == cnt.end()) {
+                return false;
+            }
+
+            u_touch();
+            if (this->is_watched()) {
+                this->u_changed(item(itr->first));
+            }
+            cnt.erase(itr);
+            return true;
         }
 
         void u_clear() override {
+            u_touch();
             cnt.clear();
+            this->u_changed();
         }
 
         template<class T, class Key> item* u_set(const Key& key, T&& value) {
-            return &(cnt[key] = std::forward<T>(value));
+            item *result = &(static_cast<RealType*>(this)->u_get_or_create(key) = std::forward<T>(value));
+            u_touch();
+            if (this->is_watched()) {
+                this->u_changed(item(u_find(key)->first));
+            }
+            return result;
         }
 
         template<class T, class Key> void set(const Key& key, T&& value) {
@@ -346,7 +424,7 @@ namespace collections {
         }
         
         void u_visit_referenced_objects(const std::function<void(object_base&)>& visitor) override {
-            for (auto& pair : u_container()) {
+            for (auto& pair : cnt) {
                 if (auto obj = pair.second.object()) {
                     visitor(*obj);
                 }
@@ -369,7 +447,34 @@ namespace collections {
 
     class map : public basic_map_collection< map, std::map<std::string, item, map_case_insensitive_comp > >
     {
+    private:
+        using base = basic_map_collection< map, std::map<std::string, item, map_case_insensitive_comp > >;
+
     public:
+
+        // C string key support. Papyrus passes string keys as C strings. std::map can't be searched
+        // by a C string without a key_type (VS2013 has no heterogeneous lookup), so the C string gets copied
+        // into a lookup key owned by the map: its buffer is reused, the lookups don't allocate.
+        // A new std::string key gets allocated only when a new key gets inserted
+
+        using base::u_lookup_key;
+        using base::u_get_or_create;
+
+        // guarded by the object lock, as the rest of the map
+        const std::string& u_lookup_key(const char *key) const {
+            _lookup_key.assign(key);
+            return _lookup_key;
+        }
+
+        item& u_get_or_create(const char *key) {
+            auto itr = cnt.lower_bound(u_lookup_key(key));
+            if (itr == cnt.end() || cnt.key_comp()(_lookup_key, itr->first)) {
+                u_touch();
+                itr = cnt.emplace_hint(itr, key, item());
+            }
+            return itr->second;
+        }
+
         enum  {
             TypeId = CollectionType::Map,
         };
@@ -378,6 +483,9 @@ namespace collections {
 
         template<class Archive>
         void serialize(Archive & ar, const unsigned int version);
+
+    private:
+        mutable std::string _lookup_key;
     };
 
     class form_map : public basic_map_collection< form_map, std::map<form_ref, item, form_ref::stable_less_comparer> >
@@ -403,8 +511,51 @@ namespace collections {
             return itr != c.end() && itr->first == k ? itr : c.end();
         }
 
+        item& u_get_or_create(const form_ref& key) {
+            auto itr = cnt.lower_bound(key);
+            if (itr == cnt.end() || cnt.key_comp()(key, itr->first)) {
+                u_touch();
+                itr = cnt.emplace_hint(itr, key, item());
+                if (key.is_not_expired()) {
+                    u_record_form_key(*this, key.get_raw());
+                }
+            }
+            return itr->second;
+        }
+
         item& u_get_or_create(const form_ref_lightweight& key) {
-            return cnt[key.to_form_ref()];
+            return u_get_or_create(key.to_form_ref());
+        }
+
+    private:
+
+        // the first expired key of the @formId form: expired keys of a form go after the non-expired one
+        const_iterator u_expired_keys_of(FormId formId) const {
+            return cnt.lower_bound(form_ref::make_expired(formId));
+        }
+
+    public:
+
+        // whether there is a key, expired or not, of the @formId form
+        bool u_has_form_key(FormId formId) const {
+            auto itr = u_expired_keys_of(formId);
+            return (itr != cnt.end() && itr->first.get_raw() == formId)
+                || (itr != cnt.begin() && std::prev(itr)->first.get_raw() == formId);
+        }
+
+        // erases the expired keys of the deleted @formId form. Returns the number of erased keys
+        size_t u_erase_expired(FormId formId) {
+            size_t erased = 0;
+            auto itr = u_expired_keys_of(formId);
+            while (itr != cnt.end() && itr->first.get_raw() == formId && itr->first.is_expired()) {
+                this->u_changed(item(itr->first));
+                itr = cnt.erase(itr);
+                ++erased;
+            }
+            if (erased) {
+                u_touch();
+            }
+            return erased;
         }
 
     public:
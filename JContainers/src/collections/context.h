@@ -9,6 +9,14 @@
 
 #include "forms/form_observer.h"
 #include "collections/collections.h"
+#include "collections/prototype_cache.h"
+#include "collections/form_db_index.h"
+#include "collections/form_storage_cache.h"
+#include "collections/item_slots.h"
+#include "collections/change_feed.h"
+#include "collections/transaction.h"
+#include "collections/form_key_purger.h"
+#include "collections/async_requests.h"
 
 namespace collections
 {
@@ -28,13 +36,20 @@ namespace collections
 
         tes_context(forms::form_observer& form_watcher)
             : _form_watcher(form_watcher)
+            , changes(background)
+            , expired_form_keys(*this, background)
+            , file_requests(background)
         {
+            _form_watcher.add_deletion_listener(expired_form_keys);
+
             for (auto& init : post_init::getListConst()) {
                 init(*this);
             }
         }
 
         ~tes_context() {
+            _form_watcher.remove_deletion_listener(expired_form_keys);
+            background.close();
             shutdown();
         }
 
@@ -68,6 +83,34 @@ namespace collections
 
         forms::form_observer& _form_watcher;
 
+        // parsed JValue.objectFromPrototype templates. Forms are bound to the current load order,
+        // so the cache gets dropped together with the state
+        prototype_cache prototypes;
+
+        // JFormDB storage indexes. Saved along with the context
+        form_db_indexes form_indexes;
+
+        // JFormDB storage lookups, so that form_map needn't be searched in the root each time
+        form_storage_cache form_storages;
+
+        // JAtomic slots
+        item_slots atomic_slots;
+
+        // JValue change subscriptions
+        change_feed changes;
+
+        // JTransaction transactions being built
+        transactions pending_transactions;
+
+        // the context's tasks on the background worker
+        background_tasks background;
+
+        // eager removal of deleted forms' keys from JFormMaps
+        form_key_purger expired_form_keys;
+
+        // JValue asynchronous file reads and writes
+        async_requests file_requests;
+
         //////
     public:
 
@@ -85,6 +128,20 @@ namespace collections
         // complete shutdown, this context shouldn't be used for now
         void shutdown();
 
+        void stop_activity() override {
+            base::stop_activity();
+            background.pause();
+        }
+
+        void start_activity() override {
+            background.resume();
+            base::start_activity();
+        }
+
+        void on_watched_object_destroyed(object_base& obj) override {
+            changes.drop(obj);
+        }
+
         friend class boost::serialization::access;
         BOOST_SERIALIZATION_SPLIT_MEMBER();
 
@@ -94,18 +151,31 @@ namespace collections
             _root_object_id.store(Handle::Null, std::memory_order_relaxed);
             _cached_root = nullptr;
             //_form_watcher.u_clearState();
+            prototypes.clear();
+            form_indexes.clear();
+            form_storages.clear();
+            atomic_slots.clear();
+            changes.clear();
+            pending_transactions.clear();
+            expired_form_keys.clear();
+            file_requests.clear();
 
             base::u_clearState();
         }
 
     };
 
-    class tes_context_standalone : public tes_context {
-        forms::form_observer _observer;
+    namespace detail {
+        // a base, so that the observer gets constructed before and destroyed after the context
+        struct standalone_form_observer {
+            forms::form_observer _observer;
+        };
+    }
 
+    class tes_context_standalone : private detail::standalone_form_observer, public tes_context {
     public:
 
-        tes_context_standalone() : tes_context(_observer) {} // not safe to pass uninitialized yet memory
+        tes_context_standalone() : tes_context(_observer) {}
     };
 
     // so that this won't be lost or hidden
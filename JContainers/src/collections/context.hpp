@@ -4,7 +4,7 @@
 
 #include "jansson.h"
 
-BOOST_CLASS_VERSION(collections::tes_context, 2);
+BOOST_CLASS_VERSION(collections::tes_context, 3);
 
 namespace collections {
 
@@ -111,6 +111,9 @@ namespace collections {
                     u_postLoadInitializations();
                     u_applyUpdates(hdr.commonVersion);
                     u_postLoadMaintenance(hdr.commonVersion);
+
+                    // only the definitions were saved
+                    form_indexes.rebuild(*this);
                 }
                 catch (const std::exception& exc) {
                     _FATALERROR("caught exception (%s) during archive load - '%s'",
@@ -139,10 +142,8 @@ namespace collections {
 
         activity_stopper s{ *this };
         {
-            // we can also cleanup objects here
-            {
-                _form_watcher.u_remove_expired_forms();
-            }
+            // deleted forms aren't saved
+            _form_watcher.apply_pending_deletions();
 
             header::write_to_stream(stream);
             boost::archive::binary_oarchive arch{ stream };
@@ -153,6 +154,14 @@ namespace collections {
 
     void tes_context::u_print_stats() const {
         base::u_print_stats();
+
+        auto stats = prototypes.get_stats();
+        JC_log("prototype cache: %llu hits, %llu misses, %u templates, %u bytes",
+            stats.hits, stats.misses, (uint32_t)stats.templates, (uint32_t)stats.bytes);
+
+        auto& purged = expired_form_keys.stats();
+        JC_log("expired form keys: %llu purged from %llu form-maps in %llu passes",
+            purged.reclaimed.load(), purged.containers.load(), purged.passes.load());
     }
 
     void tes_context::read_from_string(const std::string & data) {
@@ -175,6 +184,10 @@ namespace collections {
     template<class Archive> void tes_context::load(Archive & ar, unsigned int version) {
         ar >> static_cast<base&>(*this);
         boost::serialization::load_atomic(ar, _root_object_id);
+
+        if (version >= 3) {
+            ar >> form_indexes;
+        }
 /*
 
         if (version == 1) { // to support v3.3-testing-3,
@@ -185,6 +198,7 @@ namespace collections {
     template<class Archive> void tes_context::save(Archive & ar, unsigned int version) const {
         ar << static_cast<const base&>(*this);
         boost::serialization::save_atomic(ar, _root_object_id);
+        ar << form_indexes;
         //ar << _form_watcher;
     }
 
@@ -230,6 +244,7 @@ namespace collections {
         }
 
         _root_object_id.store(db ? db->uid() : Handle::Null, std::memory_order_relaxed);
+        form_storages.clear();
     }
 
     map& tes_context::root()
@@ -0,0 +1,514 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/functional/hash.hpp>
+#include <boost/optional.hpp>
+
+#include "util/spinlock.h"
+#include "forms/form_observer.h"
+#include "collections/collections.h"
+#include "collections/access.h"
+
+namespace collections {
+
+    // Secondary index of a JFormDB storage: the forms of the storage, keyed by a value at the @path inside their entries.
+    // Only scalar values (int, float, string, form) are indexed. Range queries compare ints and floats by value,
+    // other bounds compare in item order, so that a string range contains strings only
+    class form_db_index {
+    public:
+
+        enum kind_t : uint8_t {
+            hashed = 0,
+            ordered = 1,
+        };
+
+        struct definition {
+            std::string storage;
+            std::string path;
+            kind_t kind;
+        };
+
+    private:
+
+        struct form_id_hash {
+            size_t operator()(FormId id) const { return boost::hash<uint32_t>()((uint32_t)id); }
+        };
+
+        // consistent with item equality: strings are case-insensitive
+        struct key_hash {
+            size_t operator()(const item& key) const {
+                struct visitor : boost::static_visitor<size_t> {
+                    size_t operator()(const boost::blank&) const { return 0; }
+                    size_t operator()(SInt32 val) const { return boost::hash<SInt32>()(val); }
+                    size_t operator()(item::Real val) const { return val == 0 ? 0 : boost::hash<item::Real>()(val); }
+                    size_t operator()(const form_ref& val) const { return boost::hash<uint32_t>()((uint32_t)val.get()); }
+                    size_t operator()(const internal_object_ref& val) const { return boost::hash<const void*>()(val.get()); }
+                    size_t operator()(const std::string& val) const {
+                        size_t seed = 0;
+                        for (char c : val) {
+                            boost::hash_combine(seed, tolower((unsigned char)c));
+                        }
+                        return seed;
+                    }
+                };
+
+                size_t seed = key.var().which();
+                boost::hash_combine(seed, key.var().apply_visitor(visitor()));
+                return seed;
+            }
+        };
+
+        struct key_equal {
+            bool operator()(const item& l, const item& r) const { return l == r; }
+        };
+
+        static double number_of(const item& key) {
+            auto intValue = boost::get<SInt32>(&key.var());
+            return intValue ? *intValue : *boost::get<item::Real>(&key.var());
+        }
+
+        // item order, except that numbers go by value no matter whether int or float; an int goes before
+        // the float of the same value
+        struct range_less {
+            bool operator()(const item& l, const item& r) const {
+                if (l.isNumber() && r.isNumber()) {
+                    double lv = number_of(l), rv = number_of(r);
+                    return lv != rv ? lv < rv : l.type() < r.type();
+                }
+                return l < r;
+            }
+        };
+
+        typedef std::unordered_set<FormId, form_id_hash> form_set;
+        typedef std::map<item, form_set, range_less> ordered_index;
+
+        static bool same_number(ordered_index::const_iterator itr, double value) {
+            return itr->first.isNumber() && number_of(itr->first) == value;
+        }
+
+        // the first key which is a number >= @low. Ints go before the floats of the same value,
+        // so a float bound has to step back over the ints equal to it
+        static ordered_index::const_iterator numeric_lower_bound(const ordered_index& index, const item& low) {
+            auto itr = index.lower_bound(low);
+            while (low.is_type<item::Real>() && itr != index.begin() && same_number(std::prev(itr), number_of(low))) {
+                --itr;
+            }
+            return itr;
+        }
+
+        // the first key after the numbers <= @high. An int bound has to step over the floats equal to it
+        static ordered_index::const_iterator numeric_upper_bound(const ordered_index& index, const item& high) {
+            auto itr = index.upper_bound(high);
+            while (high.is_type<SInt32>() && itr != index.end() && same_number(itr, number_of(high))) {
+                ++itr;
+            }
+            return itr;
+        }
+
+        definition _def;
+        // current key of each indexed form
+        std::unordered_map<FormId, item, form_id_hash> _keys;
+        std::unordered_map<item, form_set, key_hash, key_equal> _hashed;
+        ordered_index _ordered;
+
+        template<class Index>
+        void _erase_from(Index& index, FormId form, const item& key) {
+            auto itr = index.find(key);
+            if (itr != index.end()) {
+                itr->second.erase(form);
+                if (itr->second.empty()) {
+                    index.erase(itr);
+                }
+            }
+        }
+
+    public:
+
+        explicit form_db_index(const definition& def) : _def(def) {}
+
+        const definition& def() const { return _def; }
+        size_t size() const { return _keys.size(); }
+
+        // NaN has no place in the key order
+        static bool is_indexable(const item& key) {
+            return key.isNumber() ? !std::isnan(number_of(key)) : key.is_type<std::string>() || key.is_type<form_ref>();
+        }
+
+        // @low <= @key <= @high
+        static bool in_range(const item& key, const item& low, const item& high) {
+            if (low.isNumber() && high.isNumber()) {
+                return key.isNumber() && number_of(low) <= number_of(key) && number_of(key) <= number_of(high);
+            }
+            return !(key < low) && !(high < key);
+        }
+
+        // indexes the @form by the @key or removes the @form if the @key isn't indexable
+        void set(FormId form, const item& key) {
+            auto itr = _keys.find(form);
+            if (itr != _keys.end()) {
+                if (itr->second == key) {
+                    return;
+                }
+                erase(form);
+            }
+
+            if (!is_indexable(key)) {
+                return;
+            }
+
+            _keys.emplace(form, key);
+            if (_def.kind == ordered) {
+                _ordered[key].insert(form);
+            }
+            else {
+                _hashed[key].insert(form);
+            }
+        }
+
+        void erase(FormId form) {
+            auto itr = _keys.find(form);
+            if (itr == _keys.end()) {
+                return;
+            }
+
+            if (_def.kind == ordered) {
+                _erase_from(_ordered, form, itr->second);
+            }
+            else {
+                _erase_from(_hashed, form, itr->second);
+            }
+            _keys.erase(itr);
+        }
+
+        std::vector<FormId> find(const item& key) const {
+            const form_set *forms = nullptr;
+            if (_def.kind == ordered) {
+                auto itr = _ordered.find(key);
+                forms = itr != _ordered.end() ? &itr->second : nullptr;
+            }
+            else {
+                auto itr = _hashed.find(key);
+                forms = itr != _hashed.end() ? &itr->second : nullptr;
+            }
+
+            return forms ? std::vector<FormId>(forms->begin(), forms->end()) : std::vector<FormId>();
+        }
+
+        // forms with @low <= key <= @high, ordered by key. Hashed index has to visit and sort all the matching keys
+        std::vector<FormId> find_range(const item& low, const item& high) const {
+            std::vector<FormId> result;
+
+            if (_def.kind == ordered) {
+                auto collect = [&](ordered_index::const_iterator begin, ordered_index::const_iterator end) {
+                    for (auto itr = begin; itr != end; ++itr) {
+                        result.insert(result.end(), itr->second.begin(), itr->second.end());
+                    }
+                };
+
+                if (low.isNumber() && high.isNumber()) {
+                    if (number_of(low) <= number_of(high)) {
+                        collect(numeric_lower_bound(_ordered, low), numeric_upper_bound(_ordered, high));
+                    }
+                }
+                else if (!(high < low)) {
+                    collect(_ordered.lower_bound(low), _ordered.upper_bound(high));
+                }
+            }
+            else {
+                std::vector<std::pair<const item*, FormId>> matches;
+                for (auto& pair : _keys) {
+                    if (in_range(pair.second, low, high)) {
+                        matches.emplace_back(&pair.second, pair.first);
+                    }
+                }
+
+                std::stable_sort(matches.begin(), matches.end(), [](const std::pair<const item*, FormId>& l, const std::pair<const item*, FormId>& r) {
+                    return range_less()(*l.first, *r.first);
+                });
+                result.reserve(matches.size());
+                for (auto& match : matches) {
+                    result.push_back(match.second);
+                }
+            }
+            return result;
+        }
+    };
+
+    // Per-context set of JFormDB storage indexes. Index definitions are saved, index data is rebuilt on load.
+    // The indexes are kept up to date by JFormDB setters, changes made through other APIs need an explicit rebuild.
+    // Query results are always verified against the storage, so stale index data may cause misses, but not wrong forms
+    class form_db_indexes {
+
+        mutable util::spinlock _lock;
+        std::vector<form_db_index> _indexes;
+
+        static bool same_name(const std::string& l, const char *r) {
+            return r && _stricmp(l.c_str(), r) == 0;
+        }
+
+        static bool starts_with(const char *str, const char *prefix) {
+            return _strnicmp(str, prefix, strlen(prefix)) == 0;
+        }
+
+        form_db_index* u_find(const char *storage, const char *path) {
+            for (auto& index : _indexes) {
+                if (same_name(index.def().storage, storage) && same_name(index.def().path, path)) {
+                    return &index;
+                }
+            }
+            return nullptr;
+        }
+
+        template<class Context>
+        static form_map* storage_of(Context& context, const std::string& storage) {
+            return context.form_storages.get(context.root(), storage.c_str());
+        }
+
+        template<class Context>
+        static item key_of(Context& context, object_base *entry, const std::string& path) {
+            item key;
+            path_resolving::resolve(context, entry, path.c_str(), [&](item *itm) {
+                if (itm) {
+                    key = *itm;
+                }
+            });
+            return key;
+        }
+
+        template<class Context>
+        static form_db_index make_index(Context& context, const form_db_index::definition& def) {
+            form_db_index index(def);
+
+            object_stack_ref storage = storage_of(context, def.storage);
+            if (!storage) {
+                return index;
+            }
+
+            std::vector<std::pair<FormId, object_stack_ref>> entries;
+            {
+                object_lock lock(storage);
+                auto& cnt = storage->as<form_map>()->u_container();
+                entries.reserve(cnt.size());
+                for (auto& pair : cnt) {
+                    if (auto entry = pair.second.object()) {
+                        entries.emplace_back(pair.first.get(), entry);
+                    }
+                }
+            }
+
+            for (auto& pair : entries) {
+                index.set(pair.first, key_of(context, pair.second.get(), def.path));
+            }
+            return index;
+        }
+
+    public:
+
+        bool empty() const {
+            util::spinlock::guard g(_lock);
+            return _indexes.empty();
+        }
+
+        std::vector<form_db_index::definition> definitions() const {
+            util::spinlock::guard g(_lock);
+            std::vector<form_db_index::definition> defs;
+            for (auto& index : _indexes) {
+                defs.push_back(index.def());
+            }
+            return defs;
+        }
+
+        // builds the index. Replaces the index with the same storage and path, if any
+        template<class Context>
+        void add(Context& context, const form_db_index::definition& def) {
+            auto index = make_index(context, def);
+
+            util::spinlock::guard g(_lock);
+            if (auto existing = u_find(def.storage.c_str(), def.path.c_str())) {
+                *existing = std::move(index);
+            }
+            else {
+                _indexes.push_back(std::move(index));
+            }
+        }
+
+        bool remove(const char *storage, const char *path) {
+            util::spinlock::guard g(_lock);
+            auto itr = std::find_if(_indexes.begin(), _indexes.end(), [&](const form_db_index& index) {
+                return same_name(index.def().storage, storage) && same_name(index.def().path, path);
+            });
+            if (itr == _indexes.end()) {
+                return false;
+            }
+            _indexes.erase(itr);
+            return true;
+        }
+
+        bool has_index(const char *storage, const char *path) const {
+            util::spinlock::guard g(_lock);
+            return const_cast<form_db_indexes*>(this)->u_find(storage, path) != nullptr;
+        }
+
+        // rebuilds indexes of the @storage, or all indexes if the @storage is null
+        template<class Context>
+        void rebuild(Context& context, const char *storage = nullptr) {
+            for (auto& def : definitions()) {
+                if (!storage || same_name(def.storage, storage)) {
+                    add(context, def);
+                }
+            }
+        }
+
+        // Updates the @storage indexes after an entry change. @changedPath is relative to the entry,
+        // null means that the whole entry was replaced or removed
+        template<class Context>
+        void on_entry_changed(Context& context, const char *storage, FormId form, object_base *entry, const char *changedPath = nullptr) {
+            std::vector<std::string> paths;
+            {
+                util::spinlock::guard g(_lock);
+                for (auto& index : _indexes) {
+                    auto& def = index.def();
+                    if (same_name(def.storage, storage) && (!changedPath
+                        || starts_with(changedPath, def.path.c_str()) || starts_with(def.path.c_str(), changedPath)))
+                    {
+                        paths.push_back(def.path);
+                    }
+                }
+            }
+
+            if (paths.empty()) {
+                return;
+            }
+
+            std::vector<item> keys;
+            for (auto& path : paths) {
+                keys.push_back(entry ? key_of(context, entry, path) : item());
+            }
+
+            util::spinlock::guard g(_lock);
+            for (size_t i = 0; i < paths.size(); ++i) {
+                if (auto index = u_find(storage, paths[i].c_str())) {
+                    index->set(form, keys[i]);
+                }
+            }
+        }
+
+        // none if there is no such index
+        template<class Context>
+        boost::optional<std::vector<FormId>> find(Context& context, const char *storage, const char *path, const item& key) {
+            return _query(context, storage, path,
+                [&](const form_db_index& index) { return index.find(key); },
+                [&](const item& actual) { return actual == key; });
+        }
+
+        template<class Context>
+        boost::optional<std::vector<FormId>> find_range(Context& context, const char *storage, const char *path,
+            const item& low, const item& high)
+        {
+            return _query(context, storage, path,
+                [&](const form_db_index& index) { return index.find_range(low, high); },
+                [&](const item& actual) { return form_db_index::is_indexable(actual) && form_db_index::in_range(actual, low, high); });
+        }
+
+        void clear() {
+            util::spinlock::guard g(_lock);
+            _indexes.clear();
+        }
+
+        template<class Archive> void save(Archive& ar, unsigned int version) const {
+            auto defs = definitions();
+            uint32_t count = static_cast<uint32_t>(defs.size());
+            ar << count;
+            for (auto& def : defs) {
+                uint8_t kind = def.kind;
+                ar << def.storage << def.path << kind;
+            }
+        }
+
+        // loads the definitions only, the data gets rebuilt after the whole context is loaded
+        template<class Archive> void load(Archive& ar, unsigned int version) {
+            uint32_t count = 0;
+            ar >> count;
+
+            util::spinlock::guard g(_lock);
+            _indexes.clear();
+            for (uint32_t i = 0; i < count; ++i) {
+                form_db_index::definition def;
+                uint8_t kind = 0;
+                ar >> def.storage >> def.path >> kind;
+                def.kind = static_cast<form_db_index::kind_t>(kind);
+                _indexes.emplace_back(def);
+            }
+        }
+
+        friend class boost::serialization::access;
+        BOOST_SERIALIZATION_SPLIT_MEMBER();
+
+    private:
+
+        // @query selects the candidates from the index, @predicate tells whether the actual entry value still matches.
+        // Drops the forms which entries were removed or changed in a way the index doesn't know about
+        template<class Context, class Query, class Predicate>
+        boost::optional<std::vector<FormId>> _query(Context& context, const char *storage, const char *path,
+            Query&& query, Predicate&& predicate)
+        {
+            std::vector<FormId> candidates;
+            std::string indexPath;
+            {
+                util::spinlock::guard g(_lock);
+                auto index = u_find(storage, path);
+                if (!index) {
+                    return boost::none;
+                }
+                candidates = query(*index);
+                indexPath = index->def().path;
+            }
+
+            std::vector<FormId> result;
+            object_stack_ref fmap = storage_of(context, storage);
+            if (!fmap || candidates.empty()) {
+                return result;
+            }
+
+            std::vector<std::pair<FormId, item>> stale;
+            result.reserve(candidates.size());
+
+            for (FormId form : candidates) {
+                object_stack_ref entry;
+                {
+                    object_lock lock(fmap);
+                    auto itm = fmap->as<form_map>()->u_get(make_weak_form_id(form, context));
+                    entry = itm ? itm->object() : nullptr;
+                }
+
+                item actual = entry ? key_of(context, entry.get(), indexPath) : item();
+                if (predicate(actual)) {
+                    result.push_back(form);
+                }
+                else {
+                    stale.emplace_back(form, std::move(actual));
+                }
+            }
+
+            if (!stale.empty()) {
+                util::spinlock::guard g(_lock);
+                if (auto index = u_find(storage, path)) {
+                    for (auto& pair : stale) {
+                        index->set(pair.first, pair.second);
+                    }
+                }
+            }
+
+            return result;
+        }
+    };
+
+}
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "util/spinlock.h"
+#include "util/stl_ext.h"
+#include "object/object_context.h"
+#include "object/background_tasks.h"
+#include "forms/form_observer.h"
+#include "collections/collections.h"
+
+namespace collections {
+
+    struct form_key_purge_stats {
+        // compaction passes done
+        std::atomic<uint64_t> passes{ 0 };
+        // containers compacted
+        std::atomic<uint64_t> containers{ 0 };
+        // expired keys erased
+        std::atomic<uint64_t> reclaimed{ 0 };
+    };
+
+    // Per-context purge of the keys of deleted forms. Without it such keys stay in JFormMaps as expired ones
+    // until the next save game load. JFormMaps report each new form key, so that the purger knows
+    // which containers may reference a form; once the form observer applies a batch of deletions,
+    // the containers get compacted on the background worker, a container is locked once per pass.
+    // The index consists of hints only - by the time of the pass a container may have lost the key
+    // or may be gone; a container which got its keys in some other way just keeps the expired ones.
+    // Once the index doubles since the last prune, the entries of destroyed containers and of the keys
+    // the containers have lost get pruned on the background worker
+    class form_key_purger : public forms::form_observer::deletion_listener {
+
+        object_context& _context;
+        // passes run through the context's gate, so that none runs while the context loads or saves
+        background_tasks& _tasks;
+
+        util::spinlock _lock;
+        // form id -> containers which have got a key of the form
+        std::unordered_map<uint32_t, std::unordered_set<HandleT>> _containers_by_form;
+        // total number of the indexed containers
+        size_t _indexed = 0;
+        size_t _prune_at = kMinPruneAt;
+        bool _prune_scheduled = false;
+        // the containers and deleted forms the next pass will deal with
+        std::vector<std::pair<Handle, FormId>> _pending;
+        bool _pass_scheduled = false;
+
+        std::atomic<bool> _enabled{ true };
+        form_key_purge_stats _stats;
+
+    public:
+
+        enum { kMinPruneAt = 0x4000 };
+
+        form_key_purger(object_context& context, background_tasks& tasks)
+            : _context(context)
+            , _tasks(tasks)
+        {}
+
+        // Disabled purger neither tracks new keys nor purges the expired ones. Expired keys are still
+        // dropped when a save game gets loaded
+        void set_enabled(bool enabled) {
+            _enabled.store(enabled, std::memory_order_relaxed);
+            if (!enabled) {
+                clear();
+            }
+        }
+
+        bool enabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+        const form_key_purge_stats& stats() const { return _stats; }
+
+        // called under the container lock
+        void record(object_base& container, FormId formId) {
+            if (!enabled()) {
+                return;
+            }
+
+            const Handle handle = container.uid();
+            bool schedule = false;
+            {
+                util::spinlock::guard g(_lock);
+                if (!_containers_by_form[util::to_integral(formId)].insert((HandleT)handle).second) {
+                    return;
+                }
+                if (++_indexed >= _prune_at && !_prune_scheduled) {
+                    _prune_scheduled = schedule = true;
+                }
+            }
+
+            if (schedule) {
+                _tasks.post([this]() { u_prune(); });
+            }
+        }
+
+        void on_forms_deleted(const std::vector<FormId>& formIds) override {
+            if (!enabled()) {
+                return;
+            }
+
+            bool schedule = false;
+            {
+                util::spinlock::guard g(_lock);
+                for (FormId formId : formIds) {
+                    auto itr = _containers_by_form.find(util::to_integral(formId));
+                    if (itr == _containers_by_form.end()) {
+                        continue;
+                    }
+                    for (HandleT handle : itr->second) {
+                        _pending.emplace_back((Handle)handle, formId);
+                    }
+                    _indexed -= itr->second.size();
+                    _containers_by_form.erase(itr);
+                }
+
+                if (!_pending.empty() && !_pass_scheduled) {
+                    _pass_scheduled = schedule = true;
+                }
+            }
+
+            if (schedule) {
+                schedule_pass();
+            }
+        }
+
+        // runs the pending pass right now, unless the context's activity is stopped
+        void run_pending_pass() {
+            _tasks.run_now([this]() { u_run_pass(); });
+        }
+
+        // prunes the index right now, unless the context's activity is stopped
+        void prune_index() {
+            _tasks.run_now([this]() { u_prune(); });
+        }
+
+        size_t indexed_count() {
+            util::spinlock::guard g(_lock);
+            return _indexed;
+        }
+
+        void clear() {
+            util::spinlock::guard g(_lock);
+            _containers_by_form.clear();
+            _indexed = 0;
+            _prune_at = kMinPruneAt;
+            _pending.clear();
+        }
+
+    private:
+
+        void schedule_pass() {
+            _tasks.post([this]() { u_run_pass(); });
+        }
+
+        // run by the gate, never concurrently with other context tasks
+        void u_run_pass() {
+            std::vector<std::pair<Handle, FormId>> pending;
+            {
+                util::spinlock::guard g(_lock);
+                pending.swap(_pending);
+                _pass_scheduled = false;
+            }
+
+            if (pending.empty()) {
+                return;
+            }
+
+            std::sort(pending.begin(), pending.end());
+
+            uint64_t containers = 0, reclaimed = 0;
+            for (size_t i = 0; i < pending.size();) {
+                const Handle handle = pending[i].first;
+                object_stack_ref ref = _context.getObjectRef(handle);
+                form_map *container = ref ? ref->as<form_map>() : nullptr;
+                if (!container) {
+                    for (; i < pending.size() && pending[i].first == handle; ++i) {}
+                    continue;
+                }
+
+                object_lock g(container);
+                for (; i < pending.size() && pending[i].first == handle; ++i) {
+                    reclaimed += container->u_erase_expired(pending[i].second);
+                }
+                ++containers;
+            }
+
+            _stats.passes.fetch_add(1, std::memory_order_relaxed);
+            _stats.containers.fetch_add(containers, std::memory_order_relaxed);
+            _stats.reclaimed.fetch_add(reclaimed, std::memory_order_relaxed);
+        }
+
+        void u_forget(const std::pair<Handle, FormId>& entry) {
+            auto itr = _containers_by_form.find(util::to_integral(entry.second));
+            if (itr != _containers_by_form.end() && itr->second.erase((HandleT)entry.first)) {
+                --_indexed;
+                if (itr->second.empty()) {
+                    _containers_by_form.erase(itr);
+                }
+            }
+        }
+
+        // run by the gate, never concurrently with other context tasks. The entries of a live container
+        // get dropped under its lock, so that a key it gets meanwhile isn't lost
+        void u_prune() {
+            std::vector<std::pair<Handle, FormId>> indexed;
+            {
+                util::spinlock::guard g(_lock);
+                _prune_scheduled = false;
+                indexed.reserve(_indexed);
+                for (auto& pair : _containers_by_form) {
+                    for (HandleT handle : pair.second) {
+                        indexed.emplace_back((Handle)handle, util::to_enum<FormId>(pair.first));
+                    }
+                }
+            }
+
+            std::sort(indexed.begin(), indexed.end());
+
+            for (size_t i = 0; i < indexed.size();) {
+                const Handle handle = indexed[i].first;
+                object_stack_ref ref = _context.getObjectRef(handle);
+                form_map *container = ref ? ref->as<form_map>() : nullptr;
+                if (!container) {
+                    util::spinlock::guard g(_lock);
+                    for (; i < indexed.size() && indexed[i].first == handle; ++i) {
+                        u_forget(indexed[i]);
+                    }
+                    continue;
+                }
+
+                object_lock cg(container);
+                util::spinlock::guard g(_lock);
+                for (; i < indexed.size() && indexed[i].first == handle; ++i) {
+                    if (!container->u_has_form_key(indexed[i].second)) {
+                        u_forget(indexed[i]);
+                    }
+                }
+            }
+
+            util::spinlock::guard g(_lock);
+            _prune_at = (std::max)((size_t)kMinPruneAt, _indexed * 2);
+        }
+    };
+}
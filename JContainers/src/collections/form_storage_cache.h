@@ -0,0 +1,98 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "util/cstring.h"
+#include "util/spinlock.h"
+#include "collections/collections.h"
+
+namespace collections {
+
+    // Per-context cache of JFormDB storage lookups: storage name -> form_map stored in the JDB root.
+    // The entries are valid while the root stays the same and its version doesn't change,
+    // any modification of the root drops all of them. The entries retain their storages, so that a storage
+    // replaced in some way the version doesn't reflect is never a dangling pointer
+    class form_storage_cache {
+
+        struct entry {
+            std::string name;
+            internal_object_ref storage;
+        };
+
+        util::spinlock _lock;
+        const map *_root = nullptr;
+        uint32_t _root_version = 0;
+        // keys point into names owned by entries
+        std::unordered_map<util::cstring, std::unique_ptr<entry>, util::cstring_ihash, util::cstring_iequal> _entries;
+        uint64_t _hits = 0;
+        uint64_t _misses = 0;
+
+    public:
+
+        // the form_map associated with the @name in the @root, or null if there is no such storage
+        form_map* get(map& root, const char *name) {
+            auto key = util::make_cstring(name);
+            {
+                util::spinlock::guard g(_lock);
+                if (_root == &root && _root_version == root.version()) {
+                    auto itr = _entries.find(key);
+                    if (itr != _entries.end()) {
+                        ++_hits;
+                        return itr->second->storage->as<form_map>();
+                    }
+                }
+                else {
+                    // releases the storages the root may no longer have
+                    _entries.clear();
+                }
+                ++_misses;
+            }
+
+            form_map *storage = nullptr;
+            uint32_t version = 0;
+            {
+                const map& croot = root;
+                object_lock lock(croot);
+                version = croot.version();
+                auto itm = croot.u_get(name);
+                storage = itm ? itm->object()->as<form_map>() : nullptr;
+            }
+
+            if (!storage) {
+                return nullptr;
+            }
+
+            util::spinlock::guard g(_lock);
+            if (_root != &root || _root_version != version) {
+                _entries.clear();
+                _root = &root;
+                _root_version = version;
+            }
+
+            std::unique_ptr<entry> e(new entry{ std::string(key.begin(), key.end()), internal_object_ref(storage) });
+            auto& savedName = e->name;
+            _entries.emplace(util::cstring(savedName.data(), savedName.data() + savedName.size()), std::move(e));
+
+            return storage;
+        }
+
+        void clear() {
+            util::spinlock::guard g(_lock);
+            _entries.clear();
+            _root = nullptr;
+            _root_version = 0;
+        }
+
+        uint64_t hits() {
+            util::spinlock::guard g(_lock);
+            return _hits;
+        }
+
+        uint64_t misses() {
+            util::spinlock::guard g(_lock);
+            return _misses;
+        }
+    };
+}
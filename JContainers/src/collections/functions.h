@@ -87,7 +87,11 @@ namespace collections {
             object_lock g(obj);
             auto idx = convertWriteIndex(obj, pyIndex);
             if (idx) {
+                auto countBefore = obj->u_count();
                 operation(*idx);
+                // insertion in the middle shifts the rest of the items
+                bool appendedOne = *idx == countBefore && obj->u_count() == countBefore + 1;
+                obj->u_changed(appendedOne ? item(*idx) : item());
             }
         }
     };
@@ -139,6 +143,10 @@ namespace collections {
                 object_lock g(obj);
                 item &itm = obj->u_get_or_create(key);
                 operation(itm);
+                obj->u_touch();
+                if (obj->is_watched()) {
+                    obj->u_changed(item(obj->u_find_iterator(key)->first));
+                }
             }
         }
 
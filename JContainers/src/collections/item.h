@@ -241,7 +241,10 @@ namespace collections {
         }
 
         TESForm * form() const {
-            return skse::lookup_form(formId());
+            if (auto val = boost::get<form_ref>(&_var)) {
+                return val->form();
+            }
+            return nullptr;
         }
 
         FormId formId() const {
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "util/spinlock.h"
+#include "collections/collections.h"
+#include "collections/access.h"
+
+namespace collections {
+
+    // Per-context table of resolved item locations - a container and a key in it, so that repeated JAtomic
+    // operations on the same value skip the path parsing and lookups of the intermediate containers.
+    // Slots don't retain their containers, operations on a slot of a destroyed container fail - even if
+    // the container's handle got reused by another object.
+    // Slots aren't saved
+    class item_slots {
+
+        struct slot {
+            Handle container = Handle::Null;
+            // object_base::_serial of the container
+            uint64_t serial = 0;
+            ca::key_variant key;
+            // map value found by the @key, valid while the map version equals to the @version.
+            // Guarded by the container lock
+            const item *cached = nullptr;
+            uint32_t version = 0;
+        };
+
+        struct locator {
+            slot& s;
+
+            item* operator () (array& cnt) {
+                auto index = boost::get<int32_t>(&s.key);
+                return index ? cnt.u_get(*index) : nullptr;
+            }
+
+            // const access doesn't change the map version
+            template<class T> item* operator () (T& cnt) {
+                if (s.cached && s.version == cnt.version()) {
+                    return const_cast<item*>(s.cached);
+                }
+
+                const T& ccnt = cnt;
+                auto key = boost::get<typename T::key_type>(&s.key);
+                s.cached = key ? ccnt.u_get(*key) : nullptr;
+                s.version = cnt.version();
+                return const_cast<item*>(s.cached);
+            }
+        };
+
+        util::spinlock _lock;
+        // slot id is an index + 1. Null - free slot
+        std::vector<std::shared_ptr<slot>> _slots;
+        std::vector<int32_t> _free_ids;
+
+        std::shared_ptr<slot> _get(int32_t id) {
+            util::spinlock::guard g(_lock);
+            return id > 0 && id <= (int32_t)_slots.size() ? _slots[id - 1] : nullptr;
+        }
+
+        // null if the slot's container was destroyed
+        static object_stack_ref find_container(object_context& context, const slot& s) {
+            object_stack_ref container = context.getObjectRef(s.container);
+            return container && container->_serial == s.serial ? container : nullptr;
+        }
+
+        // frees the slots of destroyed containers
+        void u_purge(object_context& context) {
+            for (size_t i = 0; i < _slots.size(); ++i) {
+                if (_slots[i] && !find_container(context, *_slots[i])) {
+                    _slots[i] = nullptr;
+                    _free_ids.push_back((int32_t)i + 1);
+                }
+            }
+        }
+
+    public:
+
+        enum { kMaxSlots = 0x10000 };
+
+        // resolves the @path and returns id of the slot, 0 if the path can't be resolved or there are too many slots.
+        // With @createMissingKeys missing path elements, including the last one, get created
+        int32_t make(object_context& context, object_base& root, const char *path, bool createMissingKeys = false) {
+            auto info = createMissingKeys ? ca::access_creative(root, path) : ca::access_constant(root, path);
+            if (!info) {
+                return 0;
+            }
+
+            auto s = std::make_shared<slot>();
+            s->container = info->collection.uid();
+            s->serial = info->collection._serial;
+            s->key = std::move(info->key);
+
+            util::spinlock::guard g(_lock);
+            if (_free_ids.empty() && _slots.size() >= kMaxSlots) {
+                u_purge(context);
+            }
+
+            if (!_free_ids.empty()) {
+                int32_t id = _free_ids.back();
+                _free_ids.pop_back();
+                _slots[id - 1] = std::move(s);
+                return id;
+            }
+
+            if (_slots.size() >= kMaxSlots) {
+                return 0;
+            }
+
+            _slots.push_back(std::move(s));
+            return (int32_t)_slots.size();
+        }
+
+        bool release(int32_t id) {
+            util::spinlock::guard g(_lock);
+            if (id <= 0 || id > (int32_t)_slots.size() || !_slots[id - 1]) {
+                return false;
+            }
+            _slots[id - 1] = nullptr;
+            _free_ids.push_back(id);
+            return true;
+        }
+
+        // calls @func with the slot item under the container lock. False if the slot is invalid, its container
+        // was destroyed or the key is missing. @modifies - whether the @func replaces the item
+        template<class F>
+        bool perform(object_context& context, int32_t id, F&& func, bool modifies = true) {
+            auto s = _get(id);
+            if (!s) {
+                return false;
+            }
+
+            object_stack_ref container = find_container(context, *s);
+            if (!container) {
+                return false;
+            }
+
+            object_lock lock(container);
+            item *itm = perform_on_object_and_return<item*>(*container, locator{ *s });
+            if (!itm) {
+                return false;
+            }
+
+            func(*itm);
+            if (modifies) {
+                ca::u_value_replaced(*container, s->key);
+            }
+            return true;
+        }
+
+        size_t size() {
+            util::spinlock::guard g(_lock);
+            return _slots.size() - _free_ids.size();
+        }
+
+        void clear() {
+            util::spinlock::guard g(_lock);
+            _slots.clear();
+            _free_ids.clear();
+        }
+    };
+}
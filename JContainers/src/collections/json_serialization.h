@@ -3,10 +3,14 @@
 #include <set>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <jansson.h>
 #include <memory>
 
 #include "boost/filesystem/path.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/iostreams/device/mapped_file.hpp"
 #include "boost_extras.h"
 
 #include "forms/form_handling.h"
@@ -85,7 +89,59 @@ namespace collections {
 
     public:
 
+        // Files below this size are read through a plain buffered stream - mapping them costs more than it saves
+        enum { kMappedFileThreshold = 64 * 1024 };
+
         static json_unique_ref json_from_file(const char *path) {
+            if (!path) {
+                return make_unique_ptr((json_ref)nullptr, json_decref);
+            }
+
+            boost::system::error_code code;
+            auto size = boost::filesystem::file_size(path, code);
+            if (!code && size >= kMappedFileThreshold) {
+                // falls back to the buffered read only if the file can't be mapped: a parse error is already logged
+                bool mapped = false;
+                auto ref = json_from_mapped_file(path, &mapped);
+                if (mapped) {
+                    return ref;
+                }
+            }
+
+            return json_from_buffered_file(path);
+        }
+
+        // Maps the whole file into memory and parses it in-place, avoiding the copy through the CRT buffer.
+        // Returns null if the file can't be mapped or parsed, @mapped tells whether the file got mapped
+        static json_unique_ref json_from_mapped_file(const char *path, bool *mapped = nullptr) {
+            json_ref ref = nullptr;
+            if (mapped) {
+                *mapped = false;
+            }
+            if (path) {
+                try {
+                    boost::iostreams::mapped_file_source file(path);
+                    if (file.is_open()) {
+                        if (mapped) {
+                            *mapped = true;
+                        }
+                        json_error_t error;
+                        ref = json_loadb(file.data(), file.size(), 0, &error);
+
+                        if (!ref) {
+                            JC_LOG_ERROR("Can't parse JSON file at '%s' at line %u:%u - %s",
+                                path, error.line, error.column, error.text);
+                        }
+                    }
+                }
+                catch (const std::exception& exc) {
+                    JC_log("Can't map file '%s' into memory: %s", path, exc.what());
+                }
+            }
+            return make_unique_ptr(ref, json_decref);
+        }
+
+        static json_unique_ref json_from_buffered_file(const char *path) {
             json_ref ref = nullptr;
             if (path) {
                 json_error_t error; //  TODO: output error
@@ -343,13 +399,18 @@ namespace collections {
     class json_serializer {
 
         using object_cref = std::reference_wrapper<const object_base>;
-        struct object_cref_cmp {
-            bool operator()(const object_cref& l, const object_cref& r) {
-                return &l.get() < &r.get();
+        struct object_cref_hash {
+            size_t operator()(const object_cref& obj) const {
+                return std::hash<const object_base*>()(&obj.get());
+            }
+        };
+        struct object_cref_equal {
+            bool operator()(const object_cref& l, const object_cref& r) const {
+                return &l.get() == &r.get();
             }
         };
 
-        typedef std::set<object_cref, object_cref_cmp> collection_set;
+        typedef std::unordered_set<object_cref, object_cref_hash, object_cref_equal> collection_set;
         typedef std::vector<std::pair<object_cref, json_ref> > objects_to_fill;
 
         const object_base& _root;
@@ -358,8 +419,12 @@ namespace collections {
 
         typedef ca::key_variant key_variant;
         // contained-object to <container-owner, key> relation
-        typedef std::map<object_cref, std::pair<object_cref, key_variant>, object_cref_cmp> key_info_map;
+        typedef std::unordered_map<object_cref, std::pair<object_cref, key_variant>, object_cref_hash, object_cref_equal> key_info_map;
         key_info_map _keyInfo;
+        // already computed "__reference|..." paths. An object's path never changes once it's known,
+        // as the first <container-owner, key> pair is the only one that gets recorded
+        typedef std::unordered_map<object_cref, std::string, object_cref_hash, object_cref_equal> path_cache;
+        path_cache _paths;
 
         explicit json_serializer(const object_base& root) : _root(root) {}
 
@@ -523,8 +588,7 @@ namespace collections {
             number_to_string_buffer_size = 20,
         };
 
-        std::string path_to_object(const object_base& obj) const {
-
+        const std::string& path_to_object(const object_base& obj) {
 
             struct path_appender : boost::static_visitor<> {
                 std::string& p;
@@ -549,31 +613,43 @@ namespace collections {
                 }
             };
 
-            std::deque<std::reference_wrapper<const key_variant>> keys;
+            auto found = _paths.find(std::cref(obj));
+            if (found != _paths.end()) {
+                return found->second;
+            }
+
+            // walk up until the root or an object with known path is met
+            std::vector<key_info_map::const_pointer> chain;
+            const std::string* base = nullptr;
             auto child = std::cref(obj);
 
             while (&child.get() != &_root) {
 
                 auto itr = _keyInfo.find(child);
-
-                if (itr != _keyInfo.end()) {
-                    auto& pair = itr->second;
-                    child = pair.first;
-                    keys.push_front(pair.second);
+                if (itr == _keyInfo.end()) {
+                    break;
                 }
-                else {
+
+                chain.push_back(&*itr);
+                child = itr->second.first;
+
+                auto known = _paths.find(child);
+                if (known != _paths.end()) {
+                    base = &known->second;
                     break;
                 }
             }
 
-            std::string path{ reference_serialization::prefix };
+            std::string path{ base ? *base : std::string(reference_serialization::prefix) };
             path_appender pa = { path };
 
-            for (auto& key_var : keys) {
-                boost::apply_visitor(pa, key_var.get());
+            // and then descend, memoizing the path of every container along the way
+            for (auto itr = chain.rbegin(); itr != chain.rend(); ++itr) {
+                boost::apply_visitor(pa, (*itr)->second.second);
+                _paths.emplace((*itr)->first, path);
             }
 
-            return path;
+            return _paths.emplace(std::cref(obj), std::move(path)).first->second;
         }
 
     };
@@ -202,6 +202,7 @@ namespace lua { namespace api {
     cexport void JArray_setValue(array* obj, index key, const JCValue* val) {
         array_functions::doReadOp(obj, key, [=](index idx) {
             JCValue_fillItem(HACK_get_tcontext(*obj), val, obj->u_container()[idx]);
+            obj->u_changed(item(idx));
         });
         //std::cout << "value assigned: " << JCValue_toString(val) << std::endl;
     }
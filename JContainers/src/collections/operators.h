@@ -3,6 +3,9 @@
 #include "collections/collections.h"
 
 #include <thread>
+#include <cmath>
+#include <map>
+#include <limits>
 #include "meta.h"
 #include "util/istring.h"
 
@@ -11,15 +14,39 @@ namespace collections {
     namespace operators
     {
         using istring = util::istring;
-        typedef void (*operator_func)(const item& val, item& state);
+
+        // Accumulated while an operator visits the items. Simple operators keep the result in @value,
+        // others accumulate numbers and produce the @value in their finish function
+        struct operator_state {
+            item value;
+            // the container got visited: it's an array or a map with .key or .value selector.
+            // The finish function isn't called otherwise, so the result is no value
+            bool visited = false;
+            int64_t int_acc = 0;
+            double flt_acc = 0;
+            bool has_float = false;
+            uint32_t numbers = 0;
+            uint32_t items = 0;
+            std::map<int32_t, int32_t> histogram;
+        };
+
+        typedef void (*operator_func)(const item& val, operator_state& state);
+        // optional. turns accumulated state into the @state.value
+        typedef void (*finish_func)(operator_state& state, object_context& context);
+        // optional. fast path for plain array values
+        typedef void (*bulk_func)(const std::vector<item>& values, operator_state& state);
 
         struct coll_operator {
             operator_func func;
             const char *func_name;
             const char *description;
+            finish_func finish;
+            bulk_func bulk;
 
-            static coll_operator make(operator_func _func, const char *_func_name, const char *_description) {
-                coll_operator op = {_func, _func_name, _description};
+            static coll_operator make(operator_func _func, const char *_func_name, const char *_description,
+                finish_func _finish = nullptr, bulk_func _bulk = nullptr)
+            {
+                coll_operator op = {_func, _func_name, _description, _finish, _bulk};
                 return op;
             }
         };
@@ -29,6 +56,9 @@ namespace collections {
 #define COLLECTION_OPERATOR(func, descr) \
     static ::meta<coll_operator> g_collection_operator_##func(coll_operator::make(func, #func, descr));
 
+#define COLLECTION_OPERATOR_EX(func, finish, bulk, descr) \
+    static ::meta<coll_operator> g_collection_operator_##func(coll_operator::make(func, #func, descr, finish, bulk));
+
         template<class Key>
         static coll_operator* get_operator(const Key& key) {
             auto& omap = operators();
@@ -51,8 +81,9 @@ namespace collections {
             return op_map;
         }
 
-        void maxNum(const item& val, item& state) {
+        void maxNum(const item& val, operator_state& st) {
             if (val.isNumber()) {
+                auto& state = st.value;
                 state = state.isNull() ? val : item(
                     (std::max)(val.fltValue(), state.fltValue())
                     );
@@ -60,8 +91,9 @@ namespace collections {
         }
         COLLECTION_OPERATOR(maxNum, "returns maximum number (int or float) in collection");
 
-        void minNum(const item& val, item& state) {
+        void minNum(const item& val, operator_state& st) {
             if (val.isNumber()) {
+                auto& state = st.value;
                 state = state.isNull() ? val : item(
                     (std::min)(val.fltValue(), state.fltValue())
                     );
@@ -69,8 +101,9 @@ namespace collections {
         }
         COLLECTION_OPERATOR(minNum, "returns minimum number (int or float) in collection");
 
-        void maxFlt(const item& val, item& state) {
+        void maxFlt(const item& val, operator_state& st) {
             if (val.is_type<item::Real>()) {
+                auto& state = st.value;
                 state = state.isNull() ? val : item(
                     (std::max)(val.fltValue(), state.fltValue())
                     );
@@ -78,8 +111,9 @@ namespace collections {
         }
         COLLECTION_OPERATOR(maxFlt, "returns maximum float number in collection");
 
-        void minFlt(const item& val, item& state) {
+        void minFlt(const item& val, operator_state& st) {
             if (val.is_type<item::Real>()) {
+                auto& state = st.value;
                 state = state.isNull() ? val : item(
                     (std::min)(val.fltValue(), state.fltValue())
                     );
@@ -87,8 +121,9 @@ namespace collections {
         }
         COLLECTION_OPERATOR(minFlt, "returns minimum float number collection");
 
-        void maxInt(const item& val, item& state) {
+        void maxInt(const item& val, operator_state& st) {
             if (val.is_type<SInt32>()) {
+                auto& state = st.value;
                 state = state.isNull() ? val : item(
                     (std::max)(val.intValue(), state.intValue())
                     );
@@ -96,8 +131,9 @@ namespace collections {
         }
         COLLECTION_OPERATOR(maxInt, "returns maximum int number in collection");
 
-        void minInt(const item& val, item& state) {
+        void minInt(const item& val, operator_state& st) {
             if (val.is_type<SInt32>()) {
+                auto& state = st.value;
                 state = state.isNull() ? val : item(
                     (std::min)(val.intValue(), state.intValue())
                     );
@@ -105,8 +141,141 @@ namespace collections {
         }
         COLLECTION_OPERATOR(minInt, "returns minimum int number in collection");
 
+        // Numeric accumulation. Floats and ints are summed separately, so that sum of ints stays exact
+
+        inline bool fits_int(double value) {
+            return value >= (std::numeric_limits<SInt32>::min)() && value <= (std::numeric_limits<SInt32>::max)();
+        }
+
+        inline void accumulate_number(const item& val, operator_state& st) {
+            if (auto i = val.get<SInt32>()) {
+                st.int_acc += *i;
+                ++st.numbers;
+            }
+            else if (auto f = val.get<item::Real>()) {
+                st.flt_acc += *f;
+                st.has_float = true;
+                ++st.numbers;
+            }
+        }
+
+        // Typed fast path: a single tight loop over the variant storage, no per-item calls and no item rebuilding.
+        // Homogeneous int or float arrays take the first branch for every item
+        inline void accumulate_numbers(const std::vector<item>& values, operator_state& st) {
+            int64_t intAcc = 0;
+            double fltAcc = 0;
+            uint32_t ints = 0, floats = 0;
+
+            for (auto& itm : values) {
+                auto& var = itm.var();
+                if (auto i = boost::get<SInt32>(&var)) {
+                    intAcc += *i;
+                    ++ints;
+                }
+                else if (auto f = boost::get<item::Real>(&var)) {
+                    fltAcc += *f;
+                    ++floats;
+                }
+            }
+
+            st.int_acc += intAcc;
+            st.flt_acc += fltAcc;
+            st.has_float = st.has_float || floats > 0;
+            st.numbers += ints + floats;
+        }
+
+        inline void sum(const item& val, operator_state& st) {
+            accumulate_number(val, st);
+        }
+        inline void sum_finish(operator_state& st, object_context&) {
+            if (st.numbers > 0) {
+                double total = (double)st.int_acc + st.flt_acc;
+                st.value = !st.has_float && fits_int(total) ? item((SInt32)st.int_acc) : item(total);
+            }
+        }
+        COLLECTION_OPERATOR_EX(sum, sum_finish, accumulate_numbers, "returns sum of numbers (int or float) in collection. The sum is float if there is at least one float number or if it does not fit int");
+
+        inline void avg(const item& val, operator_state& st) {
+            accumulate_number(val, st);
+        }
+        inline void avg_finish(operator_state& st, object_context&) {
+            if (st.numbers > 0) {
+                st.value = item(((double)st.int_acc + st.flt_acc) / st.numbers);
+            }
+        }
+        COLLECTION_OPERATOR_EX(avg, avg_finish, accumulate_numbers, "returns average (float) of numbers in collection");
+
+        inline void count(const item& val, operator_state& st) {
+            ++st.items;
+        }
+        inline void count_finish(operator_state& st, object_context&) {
+            st.value = item((SInt32)st.items);
+        }
+        inline void count_bulk(const std::vector<item>& values, operator_state& st) {
+            st.items += values.size();
+        }
+        COLLECTION_OPERATOR_EX(count, count_finish, count_bulk, "returns count of items in collection");
+
+        inline void product(const item& val, operator_state& st) {
+            if (st.numbers == 0) {
+                st.flt_acc = 1.0;
+            }
+            if (val.isNumber()) {
+                st.flt_acc *= val.fltValue();
+                st.has_float = st.has_float || val.is_type<item::Real>();
+                ++st.numbers;
+            }
+        }
+        inline void product_bulk(const std::vector<item>& values, operator_state& st) {
+            double acc = st.numbers == 0 ? 1.0 : st.flt_acc;
+            uint32_t numbers = 0;
+            bool hasFloat = false;
+
+            for (auto& itm : values) {
+                auto& var = itm.var();
+                if (auto i = boost::get<SInt32>(&var)) {
+                    acc *= *i;
+                    ++numbers;
+                }
+                else if (auto f = boost::get<item::Real>(&var)) {
+                    acc *= *f;
+                    hasFloat = true;
+                    ++numbers;
+                }
+            }
+
+            st.flt_acc = acc;
+            st.numbers += numbers;
+            st.has_float = st.has_float || hasFloat;
+        }
+        inline void product_finish(operator_state& st, object_context&) {
+            if (st.numbers > 0) {
+                st.value = !st.has_float && fits_int(st.flt_acc) ? item((SInt32)st.flt_acc) : item(st.flt_acc);
+            }
+        }
+        COLLECTION_OPERATOR_EX(product, product_finish, product_bulk, "returns product of numbers in collection. The product is float if there is at least one float number or if it does not fit int");
+
+        inline void histogram(const item& val, operator_state& st) {
+            double number = val.isNumber() ? std::floor(val.fltValue()) : 0;
+            if (val.isNumber() && fits_int(number)) {
+                ++st.histogram[(int32_t)number];
+            }
+        }
+        inline void histogram_finish(operator_state& st, object_context& context) {
+            if (st.histogram.empty()) {
+                return;
+            }
+
+            auto& result = integer_map::object(context);
+            for (auto& pair : st.histogram) {
+                result.u_set(pair.first, item(pair.second));
+            }
+            st.value = item(result);
+        }
+        COLLECTION_OPERATOR_EX(histogram, histogram_finish, nullptr, "returns JIntMap of {number: count} pairs, no value if there are no numbers. Floats are rounded down");
 
 #undef COLLECTION_OPERATOR
+#undef COLLECTION_OPERATOR_EX
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <boost/functional/hash.hpp>
+#include <boost/optional.hpp>
+
+#include "util/cstring.h"
+#include "util/spinlock.h"
+#include "forms/form_id.h"
+#include "collections/collections.h"
+
+namespace collections {
+
+    class tes_context;
+
+    namespace operators {
+        struct coll_operator;
+        struct operator_state;
+    }
+
+    namespace path_resolving {
+
+        struct compiled_path;
+
+        // Single pre-parsed path element: .key, [index], [__formData|plugin|0xID] or @operator
+        struct path_token {
+            enum kind_t : uint8_t {
+                map_key,
+                index_key,      // array index or JIntMap key
+                form_key,
+                operator_call,  // always the last token, the rest of the path is in @tail
+            };
+
+            kind_t kind;
+            int32_t index = 0;
+            forms::FormId form = forms::FormId::Zero;
+            std::string key;
+
+            const operators::coll_operator *op = nullptr;
+            // applied to each array element
+            std::shared_ptr<const compiled_path> tail;
+            // applied to each map key or value: the rest of the path after '.key' or '.value'
+            std::shared_ptr<const compiled_path> map_tail;
+            bool has_map_selector = false;
+            bool visits_keys = false;
+        };
+
+        struct compiled_path {
+            std::vector<path_token> tokens;
+            // false if parsing stopped at malformed element. Resolving such path walks the tokens and fails,
+            // just as the step-by-step parsing did
+            bool complete = true;
+        };
+
+        std::shared_ptr<const compiled_path> compile_path(const util::cstring& path);
+
+        // Bounded LRU cache of compiled paths, keyed by path string. Lookups do not allocate.
+        // The cache is split into shards by path hash, each with its own lock, LRU list and a share of
+        // the capacity: concurrent resolves contend only if their paths land in the same shard
+        class compiled_path_cache {
+
+            typedef std::pair<std::string, std::shared_ptr<const compiled_path>> entry;
+            typedef std::list<entry> lru_list;
+
+            struct shard {
+                util::spinlock lock;
+                lru_list lru; // most recently used first
+                // keys point into strings owned by lru nodes
+                std::unordered_map<util::cstring, lru_list::iterator, util::cstring_hash, util::cstring_equal> entries;
+                uint64_t hits = 0;
+                uint64_t misses = 0;
+            };
+
+            std::vector<std::unique_ptr<shard>> _shards;
+            size_t _shard_capacity;
+
+            shard& shard_of(const util::cstring& path) {
+                return *_shards[util::cstring_hash()(path) % _shards.size()];
+            }
+
+            template<class F>
+            uint64_t sum(F&& field) {
+                uint64_t result = 0;
+                for (auto& sh : _shards) {
+                    util::spinlock::guard g(sh->lock);
+                    result += field(*sh);
+                }
+                return result;
+            }
+
+        public:
+
+            enum { kDefaultCapacity = 2048, kDefaultShardCount = 16 };
+
+            explicit compiled_path_cache(size_t capacity = kDefaultCapacity, size_t shardCount = kDefaultShardCount)
+                : _shard_capacity((std::max)(capacity / (std::max)(shardCount, size_t(1)), size_t(1)))
+            {
+                _shards.resize((std::max)(shardCount, size_t(1)));
+                for (auto& sh : _shards) {
+                    sh.reset(new shard());
+                }
+            }
+
+            std::shared_ptr<const compiled_path> get(const util::cstring& path) {
+                shard& sh = shard_of(path);
+                {
+                    util::spinlock::guard g(sh.lock);
+                    auto itr = sh.entries.find(path);
+                    if (itr != sh.entries.end()) {
+                        ++sh.hits;
+                        sh.lru.splice(sh.lru.begin(), sh.lru, itr->second);
+                        return itr->second->second;
+                    }
+                    ++sh.misses;
+                }
+
+                auto compiled = compile_path(path);
+
+                util::spinlock::guard g(sh.lock);
+                if (sh.entries.find(path) == sh.entries.end()) {
+                    if (sh.lru.size() >= _shard_capacity && !sh.lru.empty()) {
+                        auto& oldKey = sh.lru.back().first;
+                        sh.entries.erase(boost::make_iterator_range(oldKey.data(), oldKey.data() + oldKey.size()));
+                        sh.lru.pop_back();
+                    }
+
+                    sh.lru.push_front(entry{ std::string(path.begin(), path.end()), compiled });
+                    auto& key = sh.lru.front().first;
+                    sh.entries.emplace(boost::make_iterator_range(key.data(), key.data() + key.size()), sh.lru.begin());
+                }
+
+                return compiled;
+            }
+
+            size_t size() {
+                return (size_t)sum([](const shard& sh) { return (uint64_t)sh.lru.size(); });
+            }
+
+            uint64_t hits() {
+                return sum([](const shard& sh) { return sh.hits; });
+            }
+
+            uint64_t misses() {
+                return sum([](const shard& sh) { return sh.misses; });
+            }
+        };
+
+        // the cache, shared by all path_resolving::resolve calls
+        compiled_path_cache& path_cache();
+
+        // Executes compiled path. Items are accessed under the lock of their container,
+        // the same way step-by-step resolving did.
+        // Only the final call of the visitor is a template, the walk along the path is not
+        class path_executor {
+            tes_context& _context;
+            bool _createMissingKeys;
+
+            // where the path has led: the value produced by an operator, the @key in the @container,
+            // the @container itself if the path has no keys, or nowhere if the @container is null
+            struct destination {
+                object_base *container = nullptr;
+                const path_token *key = nullptr;
+                boost::optional<item> operator_value;
+            };
+
+            // value of the key in the container. Creates missing map keys if requested
+            item* lookup(object_base& container, const path_token& token) const;
+
+            void apply_operator(object_base& collection, const path_token& token, operators::operator_state& state) const;
+
+            destination walk(object_base& collection, const compiled_path& path,
+                std::vector<object_stack_ref> *reached, size_t first) const;
+
+        public:
+
+            path_executor(tes_context& context, bool createMissingKeys)
+                : _context(context), _createMissingKeys(createMissingKeys) {}
+
+            // @reached - if not null, receives the containers met on the way: reached[i] is the container
+            // the first i tokens lead to. Execution may start with @first > 0 if reached[0, first) was filled
+            // by a path sharing the same first tokens
+            template<class F>
+            void execute(object_base& collection, const compiled_path& path, F& func,
+                std::vector<object_stack_ref> *reached = nullptr, size_t first = 0) const
+            {
+                destination dest = walk(collection, path, reached, first);
+                if (dest.operator_value) {
+                    func(dest.operator_value.get_ptr());
+                    return;
+                }
+                if (!dest.container) {
+                    func(nullptr);
+                    return;
+                }
+
+                object_lock lock(dest.container);
+                if (dest.key) {
+                    func(lookup(*dest.container, *dest.key));
+                }
+                else {
+                    item root(dest.container);
+                    func(&root);
+                }
+            }
+        };
+    }
+}
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/variant.hpp>
+
+#include "util/cstring.h"
+#include "util/spinlock.h"
+#include "collections/collections.h"
+
+namespace collections {
+
+    // Immutable, context-independent snapshot of a container graph.
+    // Used to instantiate objectFromPrototype results without parsing the JSON prototype again
+    class prototype_template {
+    public:
+
+        struct object_index { uint32_t index; };
+        typedef boost::variant<boost::blank, SInt32, item::Real, std::string, FormId, object_index> value;
+
+    private:
+
+        struct node {
+            CollectionType type;
+            std::vector<value> values;
+            // only one of the key lists is used, depending on the type. array has no keys
+            std::vector<std::string> string_keys;
+            std::vector<FormId> form_keys;
+            std::vector<int32_t> int_keys;
+        };
+
+        std::vector<node> _nodes;
+        size_t _byte_size = sizeof(prototype_template);
+
+    public:
+
+        size_t byte_size() const { return _byte_size; }
+
+        // takes snapshot of the graph reachable from the @root. nodes[0] is the root
+        static std::shared_ptr<const prototype_template> make(const object_base& root) {
+            auto tmpl = std::make_shared<prototype_template>();
+            tmpl->_snapshot(root);
+            return tmpl;
+        }
+
+        template<class Context>
+        object_base& instantiate(Context& context) const {
+            std::vector<object_base*> objects;
+            objects.reserve(_nodes.size());
+
+            for (auto& n : _nodes) {
+                switch (n.type) {
+                case array::TypeId: objects.push_back(&array::object(context)); break;
+                case map::TypeId: objects.push_back(&map::object(context)); break;
+                case form_map::TypeId: objects.push_back(&form_map::object(context)); break;
+                default: objects.push_back(&integer_map::object(context)); break;
+                }
+            }
+
+            struct item_maker : boost::static_visitor<item> {
+                Context& context;
+                const std::vector<object_base*>& objects;
+
+                item_maker(Context& c, const std::vector<object_base*>& o) : context(c), objects(o) {}
+
+                item operator()(const boost::blank&) const { return item(); }
+                item operator()(const SInt32& v) const { return item(v); }
+                item operator()(const item::Real& v) const { return item(v); }
+                item operator()(const std::string& v) const { return item(v); }
+                item operator()(const FormId& v) const { return item(make_weak_form_id(v, context)); }
+                item operator()(const object_index& v) const { return item(objects[v.index]); }
+            };
+
+            struct filler {
+                const node& n;
+                const item_maker& maker;
+
+                // keys were taken in container order, so each insertion goes to the end
+                void operator () (array& cnt) {
+                    cnt.u_container().reserve(n.values.size());
+                    for (auto& v : n.values) {
+                        cnt.u_container().push_back(v.apply_visitor(maker));
+                    }
+                }
+                void operator () (map& cnt) {
+                    for (size_t i = 0; i < n.values.size(); ++i) {
+                        cnt.u_container().emplace_hint(cnt.u_container().end(), n.string_keys[i], n.values[i].apply_visitor(maker));
+                    }
+                }
+                void operator () (form_map& cnt) {
+                    for (size_t i = 0; i < n.values.size(); ++i) {
+                        auto itr = cnt.u_container().emplace_hint(cnt.u_container().end(),
+                            make_weak_form_id(n.form_keys[i], maker.context), n.values[i].apply_visitor(maker));
+                        if (itr->first) {
+                            u_record_form_key(cnt, itr->first.get_raw());
+                        }
+                    }
+                }
+                void operator () (integer_map& cnt) {
+                    for (size_t i = 0; i < n.values.size(); ++i) {
+                        cnt.u_container().emplace_hint(cnt.u_container().end(), n.int_keys[i], n.values[i].apply_visitor(maker));
+                    }
+                }
+            };
+
+            item_maker maker(context, objects);
+            for (size_t i = 0; i < _nodes.size(); ++i) {
+                object_lock lock(objects[i]);
+                perform_on_object(*objects[i], filler{ _nodes[i], maker });
+            }
+
+            return *objects.front();
+        }
+
+    private:
+
+        void _snapshot(const object_base& root) {
+            std::unordered_map<const object_base*, uint32_t> indexes;
+            std::vector<const object_base*> toVisit;
+
+            auto index_of = [&](const object_base& obj) -> uint32_t {
+                auto result = indexes.emplace(&obj, static_cast<uint32_t>(toVisit.size()));
+                if (result.second) {
+                    toVisit.push_back(&obj);
+                }
+                return result.first->second;
+            };
+
+            struct value_maker : boost::static_visitor<value> {
+                std::function<uint32_t(const object_base&)> index_of;
+
+                value operator()(const boost::blank&) const { return boost::blank(); }
+                value operator()(const SInt32& v) const { return v; }
+                value operator()(const item::Real& v) const { return v; }
+                value operator()(const std::string& v) const { return v; }
+                value operator()(const form_ref& v) const { return v.get(); }
+                value operator()(const internal_object_ref& v) const {
+                    if (auto obj = v.get()) {
+                        return object_index{ index_of(*obj) };
+                    }
+                    return boost::blank();
+                }
+            };
+
+            struct collector {
+                node& n;
+                const value_maker& maker;
+                size_t& bytes;
+
+                void add(const item& itm) {
+                    n.values.push_back(itm.var().apply_visitor(maker));
+                    if (auto str = boost::get<std::string>(&n.values.back())) {
+                        bytes += str->size();
+                    }
+                }
+
+                void operator () (const array& cnt) {
+                    for (auto& itm : cnt.u_container()) {
+                        add(itm);
+                    }
+                }
+                void operator () (const map& cnt) {
+                    for (auto& pair : cnt.u_container()) {
+                        n.string_keys.push_back(pair.first);
+                        bytes += sizeof(std::string) + pair.first.size();
+                        add(pair.second);
+                    }
+                }
+                void operator () (const form_map& cnt) {
+                    for (auto& pair : cnt.u_container()) {
+                        n.form_keys.push_back(pair.first.get());
+                        bytes += sizeof(FormId);
+                        add(pair.second);
+                    }
+                }
+                void operator () (const integer_map& cnt) {
+                    for (auto& pair : cnt.u_container()) {
+                        n.int_keys.push_back(pair.first);
+                        bytes += sizeof(int32_t);
+                        add(pair.second);
+                    }
+                }
+            };
+
+            value_maker maker;
+            maker.index_of = index_of;
+
+            index_of(root);
+            for (size_t i = 0; i < toVisit.size(); ++i) {
+                const object_base& obj = *toVisit[i];
+
+                _nodes.emplace_back();
+                _nodes.back().type = obj.type();
+
+                object_lock lock(obj);
+                perform_on_object(obj, collector{ _nodes.back(), maker, _byte_size });
+                _byte_size += sizeof(node) + _nodes.back().values.size() * sizeof(value);
+            }
+        }
+    };
+
+    // Bounded LRU cache of parsed objectFromPrototype templates, keyed by prototype string. Lookups do not allocate.
+    // Prototypes are JSON, so the keys are case-sensitive
+    class prototype_cache {
+
+        typedef std::shared_ptr<const prototype_template> template_ref;
+        typedef std::pair<std::string, template_ref> entry;
+        typedef std::list<entry> lru_list;
+
+        mutable util::spinlock _lock;
+        lru_list _lru;  // most recently used first
+        // keys point into strings owned by _lru nodes
+        std::unordered_map<util::cstring, lru_list::iterator, util::cstring_hash, util::cstring_equal> _entries;
+        size_t _bytes = 0;
+        size_t _byte_limit;
+        uint64_t _hits = 0;
+        uint64_t _misses = 0;
+
+        static size_t entry_size(const entry& e) {
+            return e.first.size() + e.second->byte_size();
+        }
+
+        static util::cstring key_of(const entry& e) {
+            return util::cstring(e.first.data(), e.first.data() + e.first.size());
+        }
+
+    public:
+
+        enum { kDefaultByteLimit = 4 * 1024 * 1024 };
+
+        struct stats {
+            uint64_t hits;
+            uint64_t misses;
+            size_t templates;
+            size_t bytes;
+        };
+
+        explicit prototype_cache(size_t byteLimit = kDefaultByteLimit) : _byte_limit(byteLimit) {}
+
+        // counts a hit or a miss
+        template_ref find(const char *prototype) {
+            auto key = util::make_cstring(prototype);
+            util::spinlock::guard g(_lock);
+
+            auto itr = _entries.find(key);
+            if (itr == _entries.end()) {
+                ++_misses;
+                return nullptr;
+            }
+
+            ++_hits;
+            _lru.splice(_lru.begin(), _lru, itr->second);
+            return itr->second->second;
+        }
+
+        void insert(const char *prototype, template_ref tmpl) {
+            if (!prototype || !tmpl) {
+                return;
+            }
+
+            entry e{ prototype, std::move(tmpl) };
+            auto size = entry_size(e);
+            if (size > _byte_limit) {
+                return;
+            }
+
+            util::spinlock::guard g(_lock);
+
+            if (_entries.count(key_of(e))) {
+                return;
+            }
+
+            while (!_lru.empty() && _bytes + size > _byte_limit) {
+                _bytes -= entry_size(_lru.back());
+                _entries.erase(key_of(_lru.back()));
+                _lru.pop_back();
+            }
+
+            _lru.push_front(std::move(e));
+            _entries.emplace(key_of(_lru.front()), _lru.begin());
+            _bytes += size;
+        }
+
+        void clear() {
+            util::spinlock::guard g(_lock);
+            _entries.clear();
+            _lru.clear();
+            _bytes = 0;
+        }
+
+        stats get_stats() const {
+            util::spinlock::guard g(_lock);
+            return{ _hits, _misses, _entries.size(), _bytes };
+        }
+    };
+
+}
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "forms/form_handling.h"
+#include "collections/collections.h"
+#include "collections/access.h"
+
+namespace collections {
+
+    // Queries over container values: filter, sort, group and project by a path resolved in each value.
+    // Values are copied out of the container under its lock and resolved after the lock is released,
+    // so the paths may lead anywhere, including back into the container itself
+    namespace query {
+
+        enum class comparison {
+            equal,
+            not_equal,
+            less,
+            less_equal,
+            greater,
+            greater_equal,
+        };
+
+        inline boost::optional<comparison> parse_comparison(const char *op) {
+            if (!op) {
+                return boost::none;
+            }
+
+            const std::pair<const char *, comparison> ops[] = {
+                { "==", comparison::equal }, { "=", comparison::equal }, { "!=", comparison::not_equal },
+                { "<", comparison::less }, { "<=", comparison::less_equal },
+                { ">", comparison::greater }, { ">=", comparison::greater_equal },
+            };
+
+            for (auto& pair : ops) {
+                if (strcmp(op, pair.first) == 0) {
+                    return pair.second;
+                }
+            }
+            return boost::none;
+        }
+
+        // none if the values can't be compared: numbers are comparable with numbers, strings (case-insensitive)
+        // with strings, forms with forms
+        inline boost::optional<int> compare_values(const item& left, const item& right) {
+            if (left.isNumber() && right.isNumber()) {
+                double l = left.fltValue(), r = right.fltValue();
+                if (left.is_type<SInt32>() && right.is_type<SInt32>()) {
+                    l = left.intValue(); r = right.intValue();
+                }
+                return l < r ? -1 : (r < l ? 1 : 0);
+            }
+
+            auto lstr = left.get<std::string>(), rstr = right.get<std::string>();
+            if (lstr && rstr) {
+                int result = _stricmp(lstr->c_str(), rstr->c_str());
+                return result < 0 ? -1 : (result > 0 ? 1 : 0);
+            }
+
+            auto lform = left.get<form_ref>(), rform = right.get<form_ref>();
+            if (lform && rform) {
+                auto l = lform->get(), r = rform->get();
+                return l < r ? -1 : (r < l ? 1 : 0);
+            }
+
+            return boost::none;
+        }
+
+        inline bool matches(const item& value, comparison op, const item& operand) {
+            auto result = compare_values(value, operand);
+            if (!result) {
+                return false;
+            }
+
+            switch (op) {
+            case comparison::equal: return *result == 0;
+            case comparison::not_equal: return *result != 0;
+            case comparison::less: return *result < 0;
+            case comparison::less_equal: return *result <= 0;
+            case comparison::greater: return *result > 0;
+            case comparison::greater_equal: return *result >= 0;
+            default: return false;
+            }
+        }
+
+        // the values of any container. Map keys are not included
+        inline std::vector<item> values_of(const object_base& container) {
+            struct helper {
+                std::vector<item>& values;
+
+                void operator () (const array& cnt) {
+                    values = cnt.u_container();
+                }
+                template<class T> void operator () (const T& cnt) {
+                    values.reserve(cnt.u_container().size());
+                    for (auto& pair : cnt.u_container()) {
+                        values.push_back(pair.second);
+                    }
+                }
+            };
+
+            std::vector<item> values;
+            object_lock lock(container);
+            perform_on_object(container, helper{ values });
+            return values;
+        }
+
+        // value at the @path in the @value. Empty path selects the value itself
+        inline item resolve_value(tes_context& context, item& value, const char *path) {
+            item result;
+            path_resolving::resolve(context, value, path, [&](item *itm) {
+                if (itm) {
+                    result = *itm;
+                }
+            });
+            return result;
+        }
+
+        // comma-separated paths, leading and trailing spaces are ignored: ".level, .name"
+        inline std::vector<std::string> split_paths(const char *paths) {
+            std::vector<std::string> result;
+            if (!paths) {
+                return result;
+            }
+
+            const char *begin = paths;
+            while (true) {
+                const char *end = begin + strcspn(begin, ",");
+
+                const char *first = begin, *last = end;
+                while (first < last && isspace((unsigned char)*first)) { ++first; }
+                while (last > first && isspace((unsigned char)*(last - 1))) { --last; }
+                result.emplace_back(first, last);
+
+                if (!*end) {
+                    break;
+                }
+                begin = end + 1;
+            }
+
+            return result;
+        }
+
+        // new array of the values whose @path value matches the predicate
+        inline array& filter(tes_context& context, const object_base& source, const char *path, comparison op, const item& operand) {
+            auto values = values_of(source);
+
+            std::vector<item> selected;
+            for (auto& value : values) {
+                if (matches(resolve_value(context, value, path), op, operand)) {
+                    selected.push_back(std::move(value));
+                }
+            }
+
+            auto& result = array::object(context);
+            result.u_container() = std::move(selected);
+            return result;
+        }
+
+        // new array of the values at the @path. Missing values are None
+        inline array& project(tes_context& context, const object_base& source, const char *path) {
+            auto values = values_of(source);
+
+            std::vector<item> projected;
+            projected.reserve(values.size());
+            for (auto& value : values) {
+                projected.push_back(resolve_value(context, value, path));
+            }
+
+            auto& result = array::object(context);
+            result.u_container() = std::move(projected);
+            return result;
+        }
+
+        // strict weak order of the sort keys: None, numbers by value with NaN last, then the other types
+        // in the item type order - forms by id, containers by identity, strings case-insensitive
+        inline bool sort_key_less(const item& l, const item& r) {
+            if (l.isNumber() && r.isNumber()) {
+                auto value = [](const item& v) -> double {
+                    auto i = v.get<SInt32>();
+                    return i ? *i : *v.get<item::Real>();
+                };
+                double lv = value(l), rv = value(r);
+                bool lnan = std::isnan(lv), rnan = std::isnan(rv);
+                return (lnan || rnan) ? (!lnan && rnan) : lv < rv;
+            }
+            if (l.isNumber() != r.isNumber() && !l.isNull() && !r.isNull()) {
+                return l.isNumber();
+            }
+            return l < r;
+        }
+
+        // true if the values are the very same: same types, the same container objects, bitwise equal numbers
+        // and exactly equal strings. Unlike item equality it holds for NaN and notices a change of letter case
+        inline bool same_values(const std::vector<item>& left, const std::vector<item>& right) {
+            if (left.size() != right.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < left.size(); ++i) {
+                const item& l = left[i], &r = right[i];
+                if (l.type() != r.type()) {
+                    return false;
+                }
+                if (auto lf = l.get<item::Real>()) {
+                    if (memcmp(lf, r.get<item::Real>(), sizeof(*lf)) != 0) {
+                        return false;
+                    }
+                }
+                else if (auto ls = l.get<std::string>()) {
+                    if (*ls != *r.get<std::string>()) {
+                        return false;
+                    }
+                }
+                else if (!(l == r)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Stable sort by values at the @paths. The second path breaks ties of the first one and so on.
+        // Each path is resolved once per item; the keys are ordered by sort_key_less, missing values go first.
+        // The keys get resolved without the array lock (the items may reference the array itself), so the order
+        // is applied only if the array still holds the same values, otherwise the sort starts over.
+        // Returns false and leaves the array as is if it kept changing for kMaxSortAttempts attempts
+        static const int kMaxSortAttempts = 4;
+
+        inline bool sort_by(tes_context& context, array& target, const char *paths, bool descending = false) {
+            auto keyPaths = split_paths(paths);
+
+            for (int attempt = 0; attempt < kMaxSortAttempts; ++attempt) {
+                auto values = values_of(target);
+
+                std::vector<std::vector<item>> keys(values.size());
+                for (size_t i = 0; i < values.size(); ++i) {
+                    keys[i].reserve(keyPaths.size());
+                    for (auto& path : keyPaths) {
+                        keys[i].push_back(resolve_value(context, values[i], path.c_str()));
+                    }
+                }
+
+                std::vector<size_t> order(values.size());
+                std::iota(order.begin(), order.end(), 0);
+                std::stable_sort(order.begin(), order.end(), [&](size_t l, size_t r) {
+                    for (size_t k = 0; k < keyPaths.size(); ++k) {
+                        const item& lkey = keys[l][k];
+                        const item& rkey = keys[r][k];
+                        if (descending ? sort_key_less(rkey, lkey) : sort_key_less(lkey, rkey)) {
+                            return true;
+                        }
+                        if (descending ? sort_key_less(lkey, rkey) : sort_key_less(rkey, lkey)) {
+                            return false;
+                        }
+                    }
+                    return false;
+                });
+
+                std::vector<item> sorted;
+                sorted.reserve(values.size());
+                for (size_t idx : order) {
+                    sorted.push_back(values[idx]);
+                }
+
+                object_lock lock(target);
+                if (!same_values(static_cast<const array&>(target).u_container(), values)) {
+                    continue;
+                }
+                target.u_container() = std::move(sorted);
+                target.u_changed();
+                return true;
+            }
+
+            return false;
+        }
+
+        // group key of a value: strings as is, numbers and forms in their text form. None for other values
+        inline boost::optional<std::string> group_key(const item& value) {
+            if (auto str = value.get<std::string>()) {
+                return *str;
+            }
+            if (auto val = value.get<SInt32>()) {
+                return std::to_string(*val);
+            }
+            if (auto val = value.get<item::Real>()) {
+                char buffer[32] = { '\0' };
+                sprintf_s(buffer, "%g", *val);
+                return std::string(buffer);
+            }
+            if (auto val = value.get<form_ref>()) {
+                return forms::to_string(val->get());
+            }
+            return boost::none;
+        }
+
+        // new JMap of {key: array of values with that key at the @path}. Values without a key are skipped
+        inline map& group_by(tes_context& context, const object_base& source, const char *path) {
+            auto values = values_of(source);
+
+            std::vector<std::pair<std::string, item>> grouped;
+            grouped.reserve(values.size());
+            for (auto& value : values) {
+                if (auto key = group_key(resolve_value(context, value, path))) {
+                    grouped.emplace_back(std::move(*key), std::move(value));
+                }
+            }
+
+            auto& result = map::object(context);
+            object_lock lock(result);
+            for (auto& pair : grouped) {
+                item *group = result.u_get(pair.first);
+                if (!group) {
+                    group = result.u_set(pair.first, item(array::object(context)));
+                }
+                group->object()->as<array>()->u_push(std::move(pair.second));
+            }
+
+            return result;
+        }
+    }
+}
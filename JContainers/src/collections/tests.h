@@ -216,6 +216,223 @@ namespace collections { namespace {
         EXPECT_FALSE(ca::assign(m, ".h.f.t", 1));
     }
 
+    TEST(path_resolving, compile_path)
+    {
+        using namespace path_resolving;
+
+        auto compiled = compile_path(util::make_cstring(".a[1][__formData|A|0x14].b@maxNum.value.c"));
+        EXPECT_TRUE(compiled->complete);
+        EXPECT_TRUE(compiled->tokens.size() == 5);
+
+        auto& t = compiled->tokens;
+        EXPECT_TRUE(t[0].kind == path_token::map_key && t[0].key == "a");
+        EXPECT_TRUE(t[1].kind == path_token::index_key && t[1].index == 1);
+        EXPECT_TRUE(t[2].kind == path_token::form_key && t[2].form == util::to_enum<FormId>(0x41000014));
+        EXPECT_TRUE(t[3].kind == path_token::map_key && t[3].key == "b");
+        EXPECT_TRUE(t[4].kind == path_token::operator_call && t[4].op != nullptr);
+        EXPECT_TRUE(t[4].has_map_selector && !t[4].visits_keys);
+        EXPECT_TRUE(t[4].map_tail->tokens.size() == 1 && t[4].map_tail->tokens[0].key == "c");
+        EXPECT_TRUE(t[4].tail->tokens.size() == 2);
+
+        EXPECT_TRUE(compile_path(util::make_cstring("[0x10]"))->tokens[0].index == 16);
+
+        auto broken = compile_path(util::make_cstring(".a.b[x]"));
+        EXPECT_FALSE(broken->complete);
+        EXPECT_TRUE(broken->tokens.size() == 2);
+
+        EXPECT_FALSE(compile_path(util::make_cstring(".a@unknownOperator"))->complete);
+        EXPECT_FALSE(compile_path(util::make_cstring(".a[1"))->complete);
+    }
+
+    TEST(path_resolving, compiled_path_cache)
+    {
+        using namespace path_resolving;
+
+        compiled_path_cache cache(2, 1);
+        auto a = cache.get(util::make_cstring(".a"));
+        EXPECT_TRUE(cache.get(util::make_cstring(".a")) == a);
+        EXPECT_TRUE(cache.hits() == 1 && cache.misses() == 1);
+
+        cache.get(util::make_cstring(".b"));
+        cache.get(util::make_cstring(".c")); // evicts least recently used '.a'
+        EXPECT_TRUE(cache.size() == 2);
+        EXPECT_TRUE(cache.get(util::make_cstring(".a")) != a);
+
+        // each shard keeps its share of the capacity
+        compiled_path_cache sharded(64, 4);
+        for (int i = 0; i < 1000; ++i) {
+            sharded.get(util::make_cstring(("." + std::to_string(i)).c_str()));
+        }
+        EXPECT_TRUE(sharded.size() <= 64);
+        EXPECT_TRUE(sharded.misses() == 1000);
+        auto b = sharded.get(util::make_cstring(".999"));
+        EXPECT_TRUE(sharded.get(util::make_cstring(".999")) == b);
+    }
+
+    JC_TEST(path_resolving, perft)
+    {
+        auto& root = map::object(context);
+        ca::assign_creative(root, ".player.stats.health", 100);
+        auto& arr = array::object(context);
+        for (int i = 0; i < 100; ++i) {
+            arr.u_push(item{ i });
+        }
+        root.u_set("numbers", arr);
+
+        SInt32 sum = 0;
+        util::do_with_timing("path_resolving: 1M solveInt-like calls", [&]() {
+            for (int i = 0; i < 1000000; ++i) {
+                sum += path_resolving::_resolve<SInt32>(context, &root, ".player.stats.health");
+            }
+        });
+        EXPECT_TRUE(sum == 100 * 1000000);
+
+        util::do_with_timing("path_resolving: 100k @maxNum calls", [&]() {
+            for (int i = 0; i < 100000; ++i) {
+                EXPECT_TRUE(path_resolving::_resolve<SInt32>(context, &root, ".numbers@maxNum") == 99);
+            }
+        });
+    }
+
+    JC_TEST(path_resolving, resolve_many)
+    {
+        auto& root = map::object(context);
+        ca::assign_creative(root, ".a.b.c", 1);
+        ca::assign_creative(root, ".a.b.d", 2);
+        ca::assign_creative(root, ".a.e", 3);
+        auto& numbers = array::object(context);
+        numbers.u_push(item{ 5 });
+        numbers.u_push(item{ 7 });
+        root.u_set("numbers", numbers);
+
+        std::vector<const char *> paths = {
+            ".a.b.d", ".a.e", ".missing.x", ".a.b.c", ".a.b", "", ".a.b.c", ".numbers@maxNum", ".numbers[1]", ".a.b.c.x", nullptr, ".a[",
+        };
+        std::vector<item> results(paths.size());
+        std::vector<int> visits(paths.size());
+
+        path_resolving::resolve_many(context, &root, paths, [&](size_t idx, item *itm) {
+            ++visits[idx];
+            if (itm) {
+                results[idx] = *itm;
+            }
+        });
+
+        // each path is resolved exactly the way single resolve does it
+        for (size_t i = 0; i < paths.size(); ++i) {
+            item expected;
+            int expectedVisits = 0;
+            path_resolving::resolve(context, &root, paths[i], [&](item *itm) {
+                ++expectedVisits;
+                if (itm) {
+                    expected = *itm;
+                }
+            });
+            EXPECT_TRUE(results[i] == expected);
+            EXPECT_TRUE(visits[i] == expectedVisits);
+        }
+
+        EXPECT_TRUE(results[0] == 2 && results[1] == 3 && results[3] == 1 && results[7] == 7 && results[8] == 7);
+        EXPECT_TRUE(results[2].isNull() && results[9].isNull() && results[11].isNull());
+    }
+
+    // 20 paths of the same record: one call per path vs single batch call
+    JC_TEST(path_resolving, resolve_many_perft)
+    {
+        auto& root = map::object(context);
+        std::vector<std::string> pathStrings;
+        for (int i = 0; i < 20; ++i) {
+            pathStrings.push_back(".player.stats.value" + std::to_string(i));
+            ca::assign_creative(root, pathStrings.back().c_str(), i);
+        }
+        std::vector<const char *> paths;
+        for (auto& p : pathStrings) {
+            paths.push_back(p.c_str());
+        }
+
+        SInt32 sum = 0;
+        util::do_with_timing("path_resolving: 100k x 20 single resolve calls", [&]() {
+            for (int i = 0; i < 100000; ++i) {
+                for (auto path : paths) {
+                    sum += path_resolving::_resolve<SInt32>(context, &root, path);
+                }
+            }
+        });
+
+        util::do_with_timing("path_resolving: 100k resolve_many calls with 20 paths", [&]() {
+            for (int i = 0; i < 100000; ++i) {
+                path_resolving::resolve_many(context, &root, paths, [&](size_t, item *itm) {
+                    sum -= itm ? itm->intValue() : 0;
+                });
+            }
+        });
+
+        EXPECT_TRUE(sum == 0);
+    }
+
+    namespace {
+#   ifdef _DEBUG
+        // counts heap allocations made by the debug CRT
+        struct allocation_counter {
+            static long& count() { static long c = 0; return c; }
+
+            static int hook(int allocType, void *, size_t, int, long, const unsigned char *, int) {
+                if (allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC) {
+                    ++count();
+                }
+                return TRUE;
+            }
+
+            _CRT_ALLOC_HOOK _previous;
+            allocation_counter() { count() = 0; _previous = _CrtSetAllocHook(&hook); }
+            ~allocation_counter() { _CrtSetAllocHook(_previous); }
+        };
+#   endif
+    }
+
+    // @-operators over a 100k-element array: latency and heap allocation count (debug builds only)
+    JC_TEST(path_resolving, operators_perft)
+    {
+        auto& root = map::object(context);
+        auto& numbers = array::object(context);
+        auto& records = array::object(context);
+        root.u_set("numbers", numbers);
+        root.u_set("records", records);
+
+        for (int i = 0; i < 100000; ++i) {
+            numbers.u_push(item{ i });
+            // strings and forms made copying the container especially costly
+            numbers.u_push(item{ "some string which does not fit small buffer" });
+            numbers.u_push(item{ make_weak_form_id(util::to_enum<FormId>(0x41000000 + i), context) });
+        }
+        for (int i = 0; i < 1000; ++i) {
+            auto& rec = map::object(context);
+            rec.u_set("value", i);
+            records.u_push(rec);
+        }
+
+        auto measure = [&](const char *name, const char *path, SInt32 expected) {
+#       ifdef _DEBUG
+            allocation_counter counter;
+#       endif
+            util::do_with_timing(name, [&]() {
+                for (int i = 0; i < 10; ++i) {
+                    EXPECT_TRUE(path_resolving::_resolve<SInt32>(context, &root, path) == expected);
+                }
+            });
+#       ifdef _DEBUG
+            JC_log("%s: %ld allocations", name, allocation_counter::count());
+#       endif
+        };
+
+        measure("10 x @maxInt over 300k items", ".numbers@maxInt", 99999);
+        measure("10 x @maxInt.value over 1k maps", ".records@maxInt.value", 999);
+        // typed loop over the array storage, no per-item operator calls
+        measure("10 x @count over 300k items", ".numbers@count", 300000);
+        measure("10 x @avg over 300k items", ".numbers@avg", 49999);
+        measure("10 x @sum.value over 1k maps", ".records@sum.value", 499500);
+    }
+
     JC_TEST(json_deserializer, test)
     {
         EXPECT_NIL(json_deserializer::object_from_file(context, ""));
@@ -225,6 +442,66 @@ namespace collections { namespace {
         EXPECT_NIL(json_deserializer::object_from_json_data(context, nullptr));
     }
 
+    // mapped and buffered readers must produce the same JSON for any file
+    TEST(json_deserializer, mapped_file)
+    {
+        namespace fs = boost::filesystem;
+
+        EXPECT_NIL(json_deserializer::json_from_mapped_file(nullptr));
+        bool isMapped = true;
+        EXPECT_NIL(json_deserializer::json_from_mapped_file("", &isMapped));
+        EXPECT_FALSE(isMapped);
+
+        fs::directory_iterator end;
+        for (fs::directory_iterator itr(util::relative_to_dll_path("test_data/json_loading_test")); itr != end; ++itr) {
+            if (fs::is_regular_file(*itr) && fs::file_size(*itr) > 0) {
+                auto path = itr->path().generic_string();
+                auto mapped = json_deserializer::json_from_mapped_file(path.c_str(), &isMapped);
+                auto buffered = json_deserializer::json_from_buffered_file(path.c_str());
+                EXPECT_TRUE(isMapped);
+                EXPECT_NOT_NIL(mapped);
+                EXPECT_TRUE(json_equal(mapped.get(), buffered.get()) == 1);
+            }
+        }
+    }
+
+    // compares mapped vs buffered file loading for files of different sizes. The OS file cache stays warm
+    // after the first pass, so only the first iteration of each size approximates a cold read
+    TEST(json_deserializer, DISABLED_mapped_file_perft)
+    {
+        namespace fs = boost::filesystem;
+
+        const size_t sizes[] = { 1 << 10, 64 << 10, 1 << 20, 10 << 20, 200 << 20 };
+        const auto tmp = fs::temp_directory_path() / "jc_mapped_file_perft.json";
+
+        for (auto approxSize : sizes) {
+            {
+                auto root = make_unique_ptr(json_array(), json_decref);
+                auto proto = make_unique_ptr(json_pack("{s:i, s:f, s:s, s:[i,i,i]}",
+                    "int", 12345, "flt", 1.5, "str", "some string value", "arr", 1, 2, 3), json_decref);
+                size_t protoSize = strlen(make_unique_ptr(json_dumps(proto.get(), 0), free).get());
+                for (size_t i = 0, count = approxSize / protoSize + 1; i < count; ++i) {
+                    json_array_append(root.get(), proto.get());
+                }
+                json_dump_file(root.get(), tmp.generic_string().c_str(), 0);
+            }
+
+            char name[128];
+            for (int pass = 0; pass < 2; ++pass) {
+                sprintf(name, "mapped, %u bytes, pass %d", (uint32_t)fs::file_size(tmp), pass);
+                util::do_with_timing(name, [&]() {
+                    EXPECT_NOT_NIL(json_deserializer::json_from_mapped_file(tmp.generic_string().c_str()));
+                });
+                sprintf(name, "buffered, %u bytes, pass %d", (uint32_t)fs::file_size(tmp), pass);
+                util::do_with_timing(name, [&]() {
+                    EXPECT_NOT_NIL(json_deserializer::json_from_buffered_file(tmp.generic_string().c_str()));
+                });
+            }
+        }
+
+        fs::remove(tmp);
+    }
+
     // load json file into tes_context -> serialize into json again -> compare with original json
     // also compares original json with json, loaded from serialized tex_context (do_comparison2 function)
     struct json_loading_test_ {
@@ -301,6 +578,89 @@ namespace collections { namespace {
         json_loading_test_::test();
     }
 
+    // json file -> containers -> binary -> containers -> json, must match the original json
+    TEST(binary_serialization, json_test_data_roundtrip)
+    {
+        namespace fs = boost::filesystem;
+
+        fs::directory_iterator end;
+        bool atLeastOneTested = false;
+
+        for (fs::directory_iterator itr(util::relative_to_dll_path("test_data/json_loading_test")); itr != end; ++itr) {
+            if (!fs::is_regular_file(*itr)) {
+                continue;
+            }
+
+            auto file_path = itr->path().generic_string();
+            tes_context_standalone ctx;
+
+            auto root = json_deserializer::object_from_file(ctx, file_path.c_str());
+            EXPECT_NOT_NIL(root);
+            if (!root) {
+                continue;
+            }
+
+            std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+            EXPECT_TRUE(binary_serializer::write(*root, stream));
+
+            auto restored = binary_deserializer::read(ctx, stream);
+            EXPECT_NOT_NIL(restored);
+
+            auto originJson = json_deserializer::json_from_file(file_path.c_str());
+            auto restoredJson = json_serializer::create_json_value(*restored);
+            EXPECT_TRUE(json_equal(originJson.get(), restoredJson.get()) == 1);
+
+            atLeastOneTested = true;
+        }
+
+        EXPECT_TRUE(atLeastOneTested);
+    }
+
+    JC_TEST(binary_serialization, shared_and_cyclic_references)
+    {
+        auto& root = map::object(context);
+        auto& shared = array::object(context);
+        shared.u_push(item{ 1.5f });
+        shared.u_push(item{ "text" });
+        // plugin 'A' of the fake skse api
+        shared.u_push(item{ make_weak_form_id(util::to_enum<FormId>(0x41000014), context) });
+
+        auto& imap = integer_map::object(context);
+        imap.u_set(-5, shared);
+        root.u_set("a", shared);
+        root.u_set("b", imap);
+        root.u_set("self", root);
+
+        std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+        EXPECT_TRUE(binary_serializer::write(root, stream));
+
+        auto& restored = binary_deserializer::read(context, stream)->as_link<map>();
+        EXPECT_TRUE(restored.u_get("self")->object() == &restored);
+
+        auto& restoredShared = restored.u_get("a")->object()->as_link<array>();
+        EXPECT_TRUE(restored.u_get("b")->object()->as_link<integer_map>().u_get(-5)->object() == &restoredShared);
+        EXPECT_TRUE(restoredShared.u_container()[0] == 1.5f);
+        EXPECT_TRUE(restoredShared.u_container()[1] == "text");
+        EXPECT_TRUE(restoredShared.u_container()[2].formId() == util::to_enum<FormId>(0x41000014));
+    }
+
+    JC_TEST(binary_serialization, malformed_input)
+    {
+        std::stringstream empty;
+        EXPECT_NIL(binary_deserializer::read(context, empty));
+
+        std::stringstream garbage("JCBF\x01\x05");
+        EXPECT_NIL(binary_deserializer::read(context, garbage));
+
+        // a map with a key of 4GB length
+        const char hugeKey[] = "JCBF\x01\x05\x01\x00\x01\xff\xff\xff\xff\x0f";
+        std::stringstream truncated(std::string(hugeKey, sizeof hugeKey - 1));
+        EXPECT_NIL(binary_deserializer::read(context, truncated));
+
+        EXPECT_NIL(binary_deserializer::read_file(context, nullptr));
+        EXPECT_NIL(binary_deserializer::read_file(context, ""));
+    }
+
     JC_TEST(json_serializer, no_infinite_recursion)
     {
         {
@@ -320,6 +680,138 @@ namespace collections { namespace {
         }
     }
 
+    // N form-db-like entries referencing K shared subobjects: each repeated reference is written as a path string
+    JC_TEST(json_serializer, shared_subobjects_perft)
+    {
+        const int32_t entriesCount = 20000, sharedCount = 100;
+
+        auto& root = map::object(context);
+        auto& shared = array::object(context);
+        root.u_set("shared", shared);
+        for (int32_t i = 0; i < sharedCount; ++i) {
+            auto& sub = map::object(context);
+            sub.u_set("id", i);
+            shared.u_push(sub);
+        }
+
+        auto& entries = integer_map::object(context);
+        root.u_set("entries", entries);
+        for (int32_t i = 0; i < entriesCount; ++i) {
+            auto& entry = map::object(context);
+            entry.u_set("a", shared.u_container()[i % sharedCount]);
+            entry.u_set("b", shared.u_container()[(i * 7) % sharedCount]);
+            entries.u_set(i, entry);
+        }
+
+        auto json = make_unique_ptr((json_t*)nullptr, json_decref);
+        util::do_with_timing("json_serializer shared subobjects", [&]() {
+            json = json_serializer::create_json_value(root);
+        });
+        EXPECT_NOT_NIL(json);
+
+        auto& restored = json_deserializer::object_from_json(context, json.get())->as_link<map>();
+        auto& restoredShared = restored.u_get("shared")->object()->as_link<array>();
+        auto& restoredEntries = restored.u_get("entries")->object()->as_link<integer_map>();
+        for (int32_t i = 0; i < entriesCount; i += 997) {
+            auto& entry = restoredEntries.u_get(i)->object()->as_link<map>();
+            EXPECT_TRUE(entry.u_get("a")->object() == restoredShared.u_container()[i % sharedCount].object());
+            EXPECT_TRUE(entry.u_get("b")->object() == restoredShared.u_container()[(i * 7) % sharedCount].object());
+        }
+    }
+
+    // every exported/imported form costs a mod name/index lookup, every read form - a form lookup
+    JC_TEST(json_serializer, forms_perft)
+    {
+        const uint32_t formsCount = 100000;
+
+        auto& forms = array::object(context);
+        for (uint32_t i = 0; i < formsCount; ++i) {
+            auto id = util::to_enum<FormId>((('A' + i % 26) << 24) | (i + 1));
+            forms.u_push(item{ make_weak_form_id(id, context) });
+        }
+
+        auto json = make_unique_ptr((json_t*)nullptr, json_decref);
+        util::do_with_timing("json_serializer 100k forms export", [&]() {
+            json = json_serializer::create_json_value(forms);
+        });
+        EXPECT_NOT_NIL(json);
+
+        object_base *restored = nullptr;
+        util::do_with_timing("json_deserializer 100k forms import", [&]() {
+            restored = json_deserializer::object_from_json(context, json.get());
+        });
+        auto& restoredForms = restored->as_link<array>();
+        EXPECT_TRUE(restoredForms.u_container().size() == formsCount);
+        for (uint32_t i = 0; i < formsCount; i += 997) {
+            EXPECT_TRUE(restoredForms.u_container()[i].formId() == forms.u_container()[i].formId());
+        }
+
+        uint32_t resolved = 0;
+        util::do_with_timing("item::form 10 x 100k calls", [&]() {
+            for (int pass = 0; pass < 10; ++pass) {
+                for (auto& itm : forms.u_container()) {
+                    resolved += itm.form() != nullptr;
+                }
+            }
+        });
+        EXPECT_TRUE(resolved == formsCount * 10);
+    }
+
+    JC_TEST(prototype_cache, instantiation_matches_parsing)
+    {
+        const char *prototype = STR({
+            "int": 1, "flt": 2.5, "str": "text", "form": "__formData|A|0x14",
+            "arr": [1, "2", null, {}],
+            "fmap": { "__metaInfo": { "typeName": "JFormMap" }, "__formData|A|0x14": 10 },
+            "imap": { "__metaInfo": { "typeName": "JIntMap" }, "5": "five", "-1": "minus one" },
+            "ref": "__reference|.arr"
+        });
+
+        auto parsed = json_deserializer::object_from_json_data(context, prototype);
+        EXPECT_NOT_NIL(parsed);
+
+        auto tmpl = prototype_template::make(*parsed);
+        auto& instance = tmpl->instantiate(context);
+        EXPECT_TRUE(&instance != parsed);
+
+        auto origJson = json_serializer::create_json_value(*parsed);
+        auto instanceJson = json_serializer::create_json_value(instance);
+        EXPECT_TRUE(json_equal(origJson.get(), instanceJson.get()) == 1);
+
+        // shared subobjects stay shared, but aren't shared with the original
+        auto& m = instance.as_link<map>();
+        EXPECT_TRUE(m.u_get("arr")->object() == m.u_get("ref")->object());
+        EXPECT_TRUE(m.u_get("arr")->object() != parsed->as_link<map>().u_get("arr")->object());
+    }
+
+    JC_TEST(prototype_cache, hits_and_eviction)
+    {
+        auto& obj = map::object(context);
+        obj.u_set("key", item{ "value" });
+        auto tmpl = prototype_template::make(obj);
+
+        prototype_cache cache(tmpl->byte_size() * 2 + 64);
+        EXPECT_NIL(cache.find("a"));
+
+        cache.insert("a", tmpl);
+        EXPECT_TRUE(cache.find("a") == tmpl);
+        EXPECT_TRUE(cache.get_stats().hits == 1);
+        EXPECT_TRUE(cache.get_stats().misses == 1);
+        // prototypes are case-sensitive JSON
+        EXPECT_NIL(cache.find("A"));
+
+        // exceeds the byte bound, least recently used 'a' is evicted
+        cache.insert("b", tmpl);
+        cache.insert("c", tmpl);
+        EXPECT_NIL(cache.find("a"));
+        EXPECT_TRUE(cache.find("c") == tmpl);
+        EXPECT_TRUE(cache.get_stats().bytes <= tmpl->byte_size() * 2 + 64);
+
+        cache.clear();
+        EXPECT_NIL(cache.find("c"));
+        EXPECT_TRUE(cache.get_stats().templates == 0);
+    }
+
     JC_TEST(json_handling, old_json_still_supported)
     {
         object_base* root = json_deserializer::object_from_json_data(context, STR(
@@ -499,6 +991,33 @@ namespace collections { namespace {
 
 namespace collections { namespace {
 
+    JC_TEST(map, version_changes_on_mutations_only)
+    {
+        map &cnt = map::object(context);
+        cnt.u_set("a", 1);
+        auto version = cnt.version();
+
+        // reads and lookups of existing keys do not count
+        EXPECT_TRUE(cnt.u_get("a") != nullptr);
+        EXPECT_NIL(cnt.u_get("b"));
+        cnt.u_get_or_create("a");
+        static_cast<const map&>(cnt).u_container();
+        EXPECT_TRUE(cnt.version() == version);
+
+        cnt.u_set("a", 2);
+        EXPECT_TRUE(cnt.version() != version);
+        version = cnt.version();
+
+        cnt.u_get_or_create("b");
+        EXPECT_TRUE(cnt.version() != version);
+        version = cnt.version();
+
+        EXPECT_FALSE(cnt.u_erase("c"));
+        EXPECT_TRUE(cnt.version() == version);
+        EXPECT_TRUE(cnt.u_erase("b"));
+        EXPECT_TRUE(cnt.version() != version);
+    }
+
     JC_TEST(map, key_case_insensitivity)
     {
         map &cnt = map::object(context);
@@ -509,6 +1028,60 @@ namespace collections { namespace {
         EXPECT_TRUE(*cnt.u_get("acdc") == name);
     }
 
+    JC_TEST(form_map, expired_keys_get_purged)
+    {
+        form_map &cnt = form_map::object(context);
+        auto& purger = context.expired_form_keys;
+
+        auto key_of = [&](uint32_t i) { return make_weak_form_id(util::to_enum<FormId>(0xff000000 + i), context); };
+        auto delete_forms = [&](uint32_t first, uint32_t last) {
+            for (uint32_t i = first; i <= last; ++i) {
+                context._form_watcher.on_form_deleted(forms::form_id_to_handle(key_of(i).get()));
+            }
+            context._form_watcher.apply_pending_deletions();
+            purger.run_pending_pass();
+        };
+
+        for (uint32_t i = 1; i <= 100; ++i) {
+            cnt.u_set(key_of(i), (SInt32)i);
+        }
+
+        delete_forms(1, 50);
+        EXPECT_TRUE(cnt.s_count() == 50);
+        EXPECT_TRUE(purger.stats().reclaimed == 50);
+        EXPECT_TRUE(purger.stats().containers == 1);
+        EXPECT_TRUE(cnt.u_get(key_of(51)) != nullptr);
+
+        // the current behavior: expired keys stay until the next load
+        purger.set_enabled(false);
+        for (uint32_t i = 101; i <= 110; ++i) {
+            cnt.u_set(key_of(i), (SInt32)i);
+        }
+        delete_forms(91, 110);
+        EXPECT_TRUE(cnt.s_count() == 60);
+        EXPECT_TRUE(purger.stats().reclaimed == 50);
+    }
+
+    JC_TEST(form_map, form_key_index_gets_pruned)
+    {
+        form_map &cnt = form_map::object(context);
+        auto& purger = context.expired_form_keys;
+        auto key_of = [&](uint32_t i) { return make_weak_form_id(util::to_enum<FormId>(0xff000000 + i), context); };
+
+        for (uint32_t i = 1; i <= 10; ++i) {
+            cnt.set(key_of(i), (SInt32)i);
+        }
+        EXPECT_TRUE(purger.indexed_count() == 10);
+
+        cnt.erase(key_of(1));
+        purger.prune_index();
+        EXPECT_TRUE(purger.indexed_count() == 9);
+
+        cnt.s_clear();
+        purger.prune_index();
+        EXPECT_TRUE(purger.indexed_count() == 0);
+    }
+
     JC_TEST(tes_context, root)
     {
         auto& db = context.root();
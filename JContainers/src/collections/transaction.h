@@ -0,0 +1,174 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "util/spinlock.h"
+#include "collections/collections.h"
+
+namespace collections {
+
+    // Container mutations recorded to be applied at once. The operations on the same container get applied
+    // under a single lock acquisition, in the order they were recorded.
+    // The transaction retains the containers and values until it's committed or destroyed
+    class transaction {
+    public:
+
+        enum kind_t : uint8_t {
+            set_key,    // JMap key
+            remove_key, // JMap key
+            append,     // JArray item
+        };
+
+        struct operation {
+            internal_object_ref target;
+            kind_t kind;
+            std::string key;
+            item value;
+        };
+
+    private:
+
+        std::vector<operation> _operations;
+
+        static bool u_apply(object_base& target, operation& op) {
+            switch (op.kind) {
+            case set_key:
+                if (auto cnt = target.as<map>()) {
+                    cnt->u_set(op.key, std::move(op.value));
+                    return true;
+                }
+                return false;
+            case remove_key:
+                if (auto cnt = target.as<map>()) {
+                    return cnt->u_erase(op.key);
+                }
+                return false;
+            case append:
+                if (auto cnt = target.as<array>()) {
+                    cnt->u_push(std::move(op.value));
+                    return true;
+                }
+                return false;
+            default:
+                return false;
+            }
+        }
+
+    public:
+
+        void set(object_base& target, const char *key, item&& value) {
+            if (key) {
+                _operations.push_back(operation{ &target, set_key, key, std::move(value) });
+            }
+        }
+
+        void remove(object_base& target, const char *key) {
+            if (key) {
+                _operations.push_back(operation{ &target, remove_key, key, item() });
+            }
+        }
+
+        void push(object_base& target, item&& value) {
+            _operations.push_back(operation{ &target, append, std::string(), std::move(value) });
+        }
+
+        size_t size() const {
+            return _operations.size();
+        }
+
+        // applies the operations and returns the number of the applied ones. Operations that don't match
+        // the container type (e.g. append to JMap) or remove missing keys aren't counted
+        size_t commit() {
+            // operation indexes grouped by target, groups are ordered by the first operation
+            std::unordered_map<object_base*, size_t> groupOf;
+            std::vector<std::vector<size_t>> groups;
+            for (size_t i = 0; i < _operations.size(); ++i) {
+                auto inserted = groupOf.emplace(_operations[i].target.get(), groups.size());
+                if (inserted.second) {
+                    groups.emplace_back();
+                }
+                groups[inserted.first->second].push_back(i);
+            }
+
+            size_t applied = 0;
+            for (auto& group : groups) {
+                object_base& target = *_operations[group.front()].target;
+                object_lock lock(target);
+                for (size_t idx : group) {
+                    applied += u_apply(target, _operations[idx]) ? 1 : 0;
+                }
+            }
+
+            _operations.clear();
+            return applied;
+        }
+    };
+
+    // Per-context set of the transactions being built, identified by number. Transactions aren't saved
+    class transactions {
+
+        util::spinlock _lock;
+        std::map<int32_t, std::shared_ptr<transaction>> _pending;
+        int32_t _last_id = 0;
+
+    public:
+
+        // not committed transactions retain containers, so their number is limited
+        enum { kMaxPending = 1024 };
+
+        // returns 0 if there are too many pending transactions
+        int32_t create() {
+            util::spinlock::guard g(_lock);
+            if (_pending.size() >= kMaxPending) {
+                return 0;
+            }
+
+            if (++_last_id <= 0) {
+                _last_id = 1;
+            }
+            _pending[_last_id] = std::make_shared<transaction>();
+            return _last_id;
+        }
+
+        // calls @func with the transaction, false if there is no such transaction
+        template<class F>
+        bool record(int32_t id, F&& func) {
+            util::spinlock::guard g(_lock);
+            auto itr = _pending.find(id);
+            if (itr == _pending.end()) {
+                return false;
+            }
+            func(*itr->second);
+            return true;
+        }
+
+        // removes the transaction from the set
+        std::shared_ptr<transaction> take(int32_t id) {
+            util::spinlock::guard g(_lock);
+            auto itr = _pending.find(id);
+            if (itr == _pending.end()) {
+                return nullptr;
+            }
+            auto result = std::move(itr->second);
+            _pending.erase(itr);
+            return result;
+        }
+
+        size_t size() {
+            util::spinlock::guard g(_lock);
+            return _pending.size();
+        }
+
+        void clear() {
+            decltype(_pending) pending;
+            {
+                util::spinlock::guard g(_lock);
+                pending.swap(_pending);
+            }
+        }
+    };
+}
@@ -19,6 +19,7 @@
 #include "iarchive_with_blob.h"
 
 #include "object/object_context.h"
+#include "object/background_worker.h"
 #include "domains/domain_master.h"
 
 
@@ -78,6 +79,7 @@ namespace domain_master {
 
         auto u_print_stats(master& self) -> void {
             self.get_form_observer().u_print_status();
+            collections::print_background_worker_stats();
 
             //invoke_for_all(self, [](context& d) {
                 JC_log("Default domain");
@@ -238,10 +240,8 @@ namespace domain_master {
 
             activity_stopper s{ self };
             {
-                // we can also cleanup objects here
-                {
-                    self.get_form_observer().u_remove_expired_forms();
-                }
+                // deleted forms aren't saved
+                self.get_form_observer().apply_pending_deletions();
 
                 header::write_to_stream(stream);
                 boost::archive::binary_oarchive arch{ stream };
@@ -1,18 +1,17 @@
 #pragma once
 
-//#include <hash_map>
-#include <concurrent_unordered_map.h>
-//#include <memory>
 #include <atomic>
+#include <mutex>
 #include <tuple>
+#include <vector>
 #include <assert.h>
-#include "boost/shared_ptr.hpp"
-#include "boost/smart_ptr/weak_ptr.hpp"
+#include "boost/lockfree/queue.hpp"
 #include "boost/serialization/split_member.hpp"
 #include "boost/serialization/version.hpp"
 #include "boost/noncopyable.hpp"
 #include "boost/core/explicit_operator_bool.hpp"
 
+#include "intrusive_ptr.hpp"
 #include "util/spinlock.h"
 #include "util/stl_ext.h"
 
@@ -26,30 +25,126 @@ namespace forms {
     class form_observer;
     class form_entry;
 
-    using form_entry_ref = boost::shared_ptr < form_entry > ;
+    struct form_entry_lifetime_policy {
+        static void retain(form_entry * p);
+        static void release(form_entry * p);
+    };
+
+    // a single pointer, the entry counts its references itself
+    using form_entry_ref = boost::intrusive_ptr_jc < form_entry, form_entry_lifetime_policy > ;
+
+    // form deletion events. Updated while batches get applied
+    struct form_deletion_stats {
+        std::atomic<uint64_t> events{ 0 };
+        // events which deleted watched forms
+        std::atomic<uint64_t> hits{ 0 };
+        std::atomic<uint64_t> batches{ 0 };
+        std::atomic<uint64_t> total_batch_us{ 0 };
+        std::atomic<uint64_t> max_batch_us{ 0 };
+    };
+
+    class form_observer : public boost::noncopyable {
+    public:
+
+        // Receives the ids of the deleted watched forms, once per deletion batch. Gets called by the thread
+        // which applies the batch, possibly under a container lock, so it shouldn't lock containers itself
+        class deletion_listener {
+        public:
+            virtual ~deletion_listener() {}
+            virtual void on_forms_deleted(const std::vector<FormId>& formIds) = 0;
+        };
 
-    class form_observer {
     private:
-        using weak_entry = boost::weak_ptr<form_entry>;
-        using watched_forms_t = concurrency::concurrent_unordered_map < FormId, weak_entry >;
 
-        watched_forms_t _watched_forms;
+        // Open-addressing hash table (linear probing) of the watched entries. Holds no references:
+        // an entry leaves the table once its last form_ref is gone or once its form gets deleted,
+        // so there are no expired entries to sweep
+        class shard {
+        public:
+            util::spinlock lock;
+
+            form_entry* u_find(FormId id) const;
+            // replaces an entry with the same id, returns the replaced one
+            form_entry* u_insert(form_entry& entry);
+            bool u_erase(const form_entry& entry);
+            void u_clear();
+
+            size_t u_count() const { return _count; }
+
+            template<class F> void u_for_each(F&& func) const {
+                for (const auto& slot : _slots) {
+                    if (slot.entry) {
+                        func(*slot.entry);
+                    }
+                }
+            }
+
+        private:
+            struct slot {
+                FormId id;
+                form_entry *entry;
+            };
+
+            std::vector<slot> _slots; // power of two or zero sized
+            size_t _count = 0;
+
+            size_t home_of(FormId id) const;
+            void u_grow();
+        };
+
+        // forms are sharded by the lowest bits of their ids
+        enum { kShardBits = 6, kShardCount = 1 << kShardBits };
+        shard _shards[kShardCount];
+
+        shard& shard_for(FormId id) { return _shards[util::to_integral(id) & (kShardCount - 1)]; }
+
+        friend struct form_entry_lifetime_policy;
+        void release_last_reference(form_entry& entry);
+        void u_attach(form_entry& entry);
+
+        // Deletion events arrive from the game's form destruction path, in bursts during cell unloads.
+        // They get queued and applied in batches - on the background worker,
+        // or earlier, by the first access to a watched form
+        boost::lockfree::queue<FormId> _deleted_forms{ 1024 };
+        // not less than the number of queued events
+        std::atomic<uint32_t> _deleted_forms_count = 0;
+        std::atomic<bool> _batch_scheduled = false;
+        std::mutex _batch_mutex;
+        std::vector<FormId> _batch;
+        // the watched ones of the batch
+        std::vector<FormId> _batch_hits;
+        form_deletion_stats _deletion_stats;
+        // guarded by the _batch_mutex, so that a removed listener is never called again
+        std::vector<deletion_listener*> _deletion_listeners;
+
+        void apply_deletion_batch();
 
     public:
 
         form_observer() = default;
+        ~form_observer() { u_clearState(); }
 
-        void on_form_deleted(FormHandle fId);
+        // queues the event. Returns true if a batch has to be scheduled - the event is the first one since the last batch
+        bool on_form_deleted(FormHandle fId);
         form_entry_ref watch_form(FormId fId);
 
+        // applies queued deletion events, if any
+        void apply_pending_deletions() {
+            if (_deleted_forms_count.load(std::memory_order_acquire) != 0) {
+                apply_deletion_batch();
+            }
+        }
+
+        const form_deletion_stats& deletion_stats() const { return _deletion_stats; }
+
+        void add_deletion_listener(deletion_listener& listener);
+        void remove_deletion_listener(deletion_listener& listener);
+
         // Not threadsafe part of API:
 
-        void u_clearState() {
-            _watched_forms.clear();
-        }
+        void u_clearState();
 
-        size_t u_forms_count() const { return _watched_forms.size(); }
-        void u_remove_expired_forms();
+        size_t u_forms_count() const;
         void u_print_status() const;
 
         /////////////////////////
@@ -93,6 +188,8 @@ namespace forms {
 
         FormId get() const;
         FormId get_raw() const;
+        // the form, resolved once per watched form. Null if expired
+        TESForm* form() const;
 
         bool operator!() const BOOST_NOEXCEPT { return is_expired(); }
         BOOST_EXPLICIT_OPERATOR_BOOL_NOEXCEPT();
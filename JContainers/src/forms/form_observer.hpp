@@ -2,28 +2,34 @@
 
 #include <assert.h>
 #include <inttypes.h>
+#include <algorithm>
 #include <map>
 #include <tuple>
 #include <mutex>
 
-#include <boost/smart_ptr/make_shared_object.hpp>
 #include <boost/range.hpp>
 
 #include "boost/serialization/version.hpp"
 #include "boost/serialization/split_member.hpp"
-#include <boost/serialization/shared_ptr.hpp>
-#include <boost/serialization/weak_ptr.hpp>
+#include "boost/serialization/tracking.hpp"
 #include <boost/serialization/hash_map.hpp>
 
+#include "intrusive_ptr_serialization.hpp"
+
 #include "skse/skse.h"
 #include "util/stl_ext.h"
 #include "util/util.h"
+#include "reflection/profiling.h"
 
 #include "forms/form_handling.h"
 #include "forms/form_observer.h"
 
 BOOST_CLASS_VERSION(forms::form_ref, 2);
 
+// form entry references are archived exactly like boost::shared_ptr<form_entry>, which was used before
+BOOST_CLASS_VERSION(forms::form_entry_ref, 1);
+BOOST_CLASS_TRACKING(forms::form_entry_ref, boost::serialization::track_never);
+
 namespace forms {
 
     namespace fh = forms;
@@ -40,6 +46,15 @@ namespace forms {
         // remember whether a form handle was retained or not
         // to not release it if the handle wasn't be previously retained (for ex. handle's object was not loaded)
         bool _is_handle_retained = false;
+        // resolved form, looked up once - the lookup goes through the game's global form table
+        mutable std::atomic<TESForm*> _form = nullptr;
+
+        std::atomic<int32_t> _refs = 0;
+        // the observer watching the entry. Null once the form is deleted or the entry isn't watched
+        std::atomic<form_observer*> _observer = nullptr;
+
+        friend class form_observer;
+        friend struct form_entry_lifetime_policy;
 
     public:
 
@@ -54,14 +69,14 @@ namespace forms {
         static form_entry_ref make(FormId handle) {
             //log("form_entry retains %X", handle);
 
-            return boost::make_shared<form_entry>(
+            return form_entry_ref{ new form_entry(
                 handle,
                 false,
-                skse::try_retain_handle(handle));
+                skse::try_retain_handle(handle)) };
         }
 
         static form_entry_ref make_expired(FormId handle) {
-            return boost::make_shared<form_entry>(handle, true, false);
+            return form_entry_ref{ new form_entry(handle, true, false) };
         }
 
         ~form_entry() {
@@ -73,12 +88,40 @@ namespace forms {
 
         FormId id() const { return _handle; }
 
+        // applies the deletion events queued by the observer watching the entry
+        void sync_deleted() const {
+            if (form_observer *observer = _observer.load(std::memory_order_acquire)) {
+                observer->apply_pending_deletions();
+            }
+        }
+
+        int32_t u_refs() const { return _refs._My_val; }
+
         bool is_deleted() const {
             return _deleted.load(std::memory_order_acquire);
         }
 
         void set_deleted() {
             _deleted.store(true, std::memory_order_release);
+            _form.store(nullptr, std::memory_order_release);
+        }
+
+        // Null if the form was deleted or can't be resolved yet. Unresolved forms are not cached
+        TESForm* form() const {
+            if (is_deleted()) {
+                return nullptr;
+            }
+
+            TESForm *form = _form.load(std::memory_order_acquire);
+            if (!form) {
+                form = skse::lookup_form(_handle);
+                if (form) {
+                    _form.store(form, std::memory_order_release);
+                }
+            }
+
+            // the form might have been deleted meanwhile
+            return is_deleted() ? nullptr : form;
         }
 
         bool u_is_deleted() const {
@@ -113,15 +156,165 @@ namespace forms {
         }
     };
 
-    void form_observer::u_remove_expired_forms() {
-        auto hashmap_eraser = [](watched_forms_t& cnt, const watched_forms_t::const_iterator& itr) {
-            return cnt.unsafe_erase(itr);
-        };
+    void form_entry_lifetime_policy::retain(form_entry * p) {
+        p->_refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // The last reference of a watched entry is dropped under its shard lock:
+    // until then the observer may hand the entry out again
+    void form_entry_lifetime_policy::release(form_entry * p) {
+        int32_t refs = p->_refs.load(std::memory_order_relaxed);
+        while (refs > 1) {
+            if (p->_refs.compare_exchange_weak(refs, refs - 1, std::memory_order_release, std::memory_order_relaxed)) {
+                return;
+            }
+        }
+
+        if (form_observer *observer = p->_observer.load(std::memory_order_acquire)) {
+            observer->release_last_reference(*p);
+        }
+        else if (p->_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete p;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    size_t form_observer::shard::home_of(FormId id) const {
+        // The lowest bits of the ids are equal within a shard, multiplication mixes in the rest
+        uint32_t hash = util::to_integral(id) * 0x9E3779B1u;
+        return (hash ^ (hash >> 16)) & (_slots.size() - 1);
+    }
+
+    form_entry* form_observer::shard::u_find(FormId id) const {
+        if (_slots.empty()) {
+            return nullptr;
+        }
+
+        const size_t mask = _slots.size() - 1;
+        for (size_t i = home_of(id); _slots[i].entry; i = (i + 1) & mask) {
+            if (_slots[i].id == id) {
+                return _slots[i].entry;
+            }
+        }
+        return nullptr;
+    }
+
+    form_entry* form_observer::shard::u_insert(form_entry& entry) {
+        // keeps the load factor below 3/4
+        if ((_count + 1) * 4 > _slots.size() * 3) {
+            u_grow();
+        }
+
+        const size_t mask = _slots.size() - 1;
+        size_t i = home_of(entry.id());
+        for (; _slots[i].entry; i = (i + 1) & mask) {
+            if (_slots[i].id == entry.id()) {
+                form_entry *replaced = _slots[i].entry;
+                _slots[i].entry = &entry;
+                return replaced;
+            }
+        }
+
+        _slots[i] = slot{ entry.id(), &entry };
+        ++_count;
+        return nullptr;
+    }
+
+    bool form_observer::shard::u_erase(const form_entry& entry) {
+        if (_slots.empty()) {
+            return false;
+        }
+
+        const size_t mask = _slots.size() - 1;
+        size_t hole = home_of(entry.id());
+        for (; _slots[hole].entry != &entry; hole = (hole + 1) & mask) {
+            if (!_slots[hole].entry) {
+                return false;
+            }
+        }
+
+        // backward shift deletion: no tombstones, probe chains stay short.
+        // An entry can fill the hole unless its home slot lies between the hole and the entry
+        for (size_t i = (hole + 1) & mask; _slots[i].entry; i = (i + 1) & mask) {
+            size_t home = home_of(_slots[i].id);
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                _slots[hole] = _slots[i];
+                hole = i;
+            }
+        }
+
+        _slots[hole] = slot{ FormId::Zero, nullptr };
+        --_count;
+        return true;
+    }
+
+    void form_observer::shard::u_grow() {
+        std::vector<slot> old(std::max<size_t>(_slots.size() * 2, 16), slot{ FormId::Zero, nullptr });
+        old.swap(_slots);
+        _count = 0;
+
+        for (auto& s : old) {
+            if (s.entry) {
+                u_insert(*s.entry);
+            }
+        }
+    }
+
+    void form_observer::shard::u_clear() {
+        _slots.clear();
+        _count = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    void form_observer::release_last_reference(form_entry& entry) {
+        shard& sh = shard_for(entry.id());
+        bool last = false;
+        {
+            std::lock_guard<util::spinlock> guard{ sh.lock };
+            last = entry._refs.fetch_sub(1, std::memory_order_acq_rel) == 1;
+            if (last && entry._observer.load(std::memory_order_relaxed) == this) {
+                sh.u_erase(entry);
+            }
+        }
+
+        if (last) {
+            // releases the form handle, not under the lock
+            delete &entry;
+        }
+    }
 
-        util::tree_erase_if(_watched_forms, [](const watched_forms_t::value_type& pair) {
-            return pair.second.expired();
-        },
-            hashmap_eraser);
+    void form_observer::u_attach(form_entry& entry) {
+        shard& sh = shard_for(entry.id());
+        std::lock_guard<util::spinlock> guard{ sh.lock };
+
+        form_entry *replaced = sh.u_insert(entry);
+        if (replaced && replaced != &entry) {
+            replaced->_observer.store(nullptr, std::memory_order_release);
+        }
+        entry._observer.store(this, std::memory_order_release);
+    }
+
+    void form_observer::u_clearState() {
+        FormId discarded;
+        while (_deleted_forms.pop(discarded)) {}
+        _deleted_forms_count.store(0, std::memory_order_release);
+
+        for (auto& sh : _shards) {
+            sh.u_for_each([](form_entry& entry) {
+                entry._observer.store(nullptr, std::memory_order_release);
+            });
+            sh.u_clear();
+        }
+    }
+
+    size_t form_observer::u_forms_count() const {
+        size_t count = 0;
+        for (auto& sh : _shards) {
+            count += sh.u_count();
+        }
+        return count;
     }
 
     void form_observer::u_print_status() const
@@ -129,40 +322,38 @@ namespace forms {
         uint32_t count_of_one_user = 0;
         uint32_t dyn_form_count = 0;
 
-        for (auto& pair : _watched_forms) {
-            if (!pair.second.expired()) {
-                log("%" PRIX32 " : %u", pair.first, pair.second.use_count());
-                if (pair.second.use_count() == 1) {
+        for (auto& sh : _shards) {
+            sh.u_for_each([&](const form_entry& entry) {
+                log("%" PRIX32 " : %u", entry.id(), entry.u_refs());
+                if (entry.u_refs() == 1) {
                     ++count_of_one_user;
                 }
-                if (!fh::is_static(pair.first)) {
+                if (!fh::is_static(entry.id())) {
                     ++dyn_form_count;
                 }
-            }
+            });
         }
 
-        log("total %u", _watched_forms.size());
+        log("total %u", u_forms_count());
         log("count_of_one_user %u", count_of_one_user);
         log("dyn_form_count %u", dyn_form_count);
 
-    }
-
-    namespace {
+        JC_log("form deletion events: %llu received, %llu hit watched forms; %llu batches, %llu us total, %llu us max",
+            _deletion_stats.events.load(), _deletion_stats.hits.load(), _deletion_stats.batches.load(),
+            _deletion_stats.total_batch_us.load(), _deletion_stats.max_batch_us.load());
 
-        static boost::detail::spinlock & spinlock_for(FormId formId) {
-            using spinlock_pool = boost::detail::spinlock_pool < 'DyFW' > ;
-            return spinlock_pool::spinlock_for(reinterpret_cast<void*>(formId));
-        }
     }
 
-    void form_observer::on_form_deleted(FormHandle handle)
+    bool form_observer::on_form_deleted(FormHandle handle)
     {
         // already failed, there are plenty of any kind of objects that are deleted every moment, even during initial splash screen
         //jc_assert_msg(form_handling::is_static((FormId)handle) == false,
             //"If failed, then there is static form destruction event too? fId %" PRIX64, handle);
 
+        _deletion_stats.events.fetch_add(1, std::memory_order_relaxed);
+
         if (!fh::is_form_handle(handle)) {
-            return;
+            return false;
         }
 
         // to test whether static form gets ever destroyed or not
@@ -170,69 +361,134 @@ namespace forms {
 
         ///log("on_form_deleted: %" PRIX64, handle);
 
-        auto formId = fh::form_handle_to_id(handle);
-        {
-            // Since it's impossible that two threads will delete the same form simultaneosly
-            // we can skip some thread safe stuff
-            auto itr = _watched_forms.find(formId);
-            if (itr != _watched_forms.end()) {
+        // counted first, so that the count is never less than the number of the queued events
+        _deleted_forms_count.fetch_add(1, std::memory_order_acq_rel);
+        _deleted_forms.push(fh::form_handle_to_id(handle));
 
-                auto watched = itr->second.lock();
+        return !_batch_scheduled.exchange(true, std::memory_order_acq_rel);
+    }
+
+    void form_observer::apply_deletion_batch()
+    {
+        std::lock_guard<std::mutex> batchGuard{ _batch_mutex };
+        // further events will schedule the next batch
+        _batch_scheduled.store(false, std::memory_order_release);
+
+        const int64_t started = reflection::profiling::timestamp();
+
+        _batch.clear();
+        _batch_hits.clear();
+        FormId formId;
+        while (_deleted_forms.pop(formId)) {
+            _batch.push_back(formId);
+        }
+
+        if (_batch.empty()) {
+            return;
+        }
+        _deleted_forms_count.fetch_sub((uint32_t)_batch.size(), std::memory_order_acq_rel);
+
+        // grouped by shard, so that each shard gets locked once per batch, then ordered by id
+        auto shard_index = [](FormId id) { return util::to_integral(id) & (kShardCount - 1); };
+        std::sort(_batch.begin(), _batch.end(), [&](FormId left, FormId right) {
+            return std::make_tuple(shard_index(left), left) < std::make_tuple(shard_index(right), right);
+        });
 
-                if (watched) {
+        uint64_t hits = 0;
+        for (size_t i = 0; i < _batch.size();) {
+            shard& sh = shard_for(_batch[i]);
+            std::lock_guard<util::spinlock> guard{ sh.lock };
+
+            for (; i < _batch.size() && &shard_for(_batch[i]) == &sh; ++i) {
+                // a watched entry is referenced while it's in the table
+                if (form_entry *watched = sh.u_find(_batch[i])) {
                     watched->set_deleted();
-                    {
-                        // the only unsafe piece of code here
-                        std::lock_guard<boost::detail::spinlock> guard{ spinlock_for(formId) };
-                        itr->second.reset();
-                    }
-                    log("flagged form-entry %" PRIX32 " as deleted", formId);
+                    sh.u_erase(*watched);
+                    watched->_observer.store(nullptr, std::memory_order_release);
+                    _batch_hits.push_back(_batch[i]);
+                    ++hits;
+
+                    log("flagged form-entry %" PRIX32 " as deleted", _batch[i]);
                 }
             }
         }
-    }
 
-    template<class Archive, class Collection, class ElementSaver>
-    void save_collection(Archive& archive, const Collection& collection, ElementSaver&& saver) {
-        uint32_t count = collection.size();
-        archive << count;
-        for (const auto& pair : collection) {
-            saver(archive, pair);
+        if (!_batch_hits.empty()) {
+            for (auto listener : _deletion_listeners) {
+                listener->on_forms_deleted(_batch_hits);
+            }
         }
-    }
-    template<class Archive, class Collection, class ElementLoader>
-    void load_collection(Archive& archive, Collection& collection, ElementLoader&& loader) {
-        uint32_t count = 0;
-        archive >> count;
 
-        while (count > 0) {
-            --count;
-            loader(archive, collection);
+        const uint64_t us = reflection::profiling::ticks_to_us(reflection::profiling::timestamp() - started);
+        _deletion_stats.hits.fetch_add(hits, std::memory_order_relaxed);
+        _deletion_stats.batches.fetch_add(1, std::memory_order_relaxed);
+        _deletion_stats.total_batch_us.fetch_add(us, std::memory_order_relaxed);
+        if (us > _deletion_stats.max_batch_us.load(std::memory_order_relaxed)) {
+            _deletion_stats.max_batch_us.store(us, std::memory_order_relaxed);
         }
     }
 
+    void form_observer::add_deletion_listener(deletion_listener& listener) {
+        std::lock_guard<std::mutex> batchGuard{ _batch_mutex };
+        _deletion_listeners.push_back(&listener);
+    }
+
+    void form_observer::remove_deletion_listener(deletion_listener& listener) {
+        std::lock_guard<std::mutex> batchGuard{ _batch_mutex };
+        _deletion_listeners.erase(
+            std::remove(_deletion_listeners.begin(), _deletion_listeners.end(), &listener),
+            _deletion_listeners.end());
+    }
+
+    // keeps the loaded entries alive until the archive is done: a tracked entry gets handed out
+    // each time it's referenced in the archive, even if its previous references are already gone
+    struct loaded_form_entries {
+        std::vector<form_entry_ref> entries;
+
+        static void * id() {
+            static char tag = 0;
+            return &tag;
+        }
+    };
+
+    // pre v3.3 observers were saved as std::hash_map<FormId, boost::weak_ptr<form_entry>>,
+    // the weak pointer being written as a shared one
+    struct legacy_weak_form_entry {
+        form_entry_ref entry;
+
+        template<class Archive> void serialize(Archive & ar, const unsigned int version) {
+            ar & entry;
+        }
+    };
+
     template<>
     void form_observer::load(boost::archive::binary_iarchive & ar, const unsigned int version) {
 
         switch (version) {
-        case 3:
-            load_collection(ar, _watched_forms, [&ar](boost::archive::binary_iarchive& ar, decltype(_watched_forms)& collection) {
+        case 3: {
+            uint32_t count = 0;
+            ar >> count;
+
+            while (count > 0) {
+                --count;
+
                 form_entry_ref entry;
                 ar >> entry;
 
                 if (entry && !entry->is_deleted()) {
-                    collection[entry->id()] = std::move(entry);
+                    u_attach(*entry);
                 }
-            });
+            }
+        }
             break;
         case 2:{
-            std::hash_map<FormId, boost::weak_ptr<form_entry> > oldCnt;
+            std::hash_map<FormId, legacy_weak_form_entry> oldCnt;
             ar >> oldCnt;
 
             for (auto& pair : oldCnt) {
-                form_entry_ref entry = pair.second.lock();
+                const form_entry_ref& entry = pair.second.entry;
                 if (entry && !entry->is_deleted()) {
-                    _watched_forms[entry->id()] = std::move(entry);
+                    u_attach(*entry);
                 }
             }
         }
@@ -246,10 +502,15 @@ namespace forms {
     template<>
     void form_observer::save(boost::archive::binary_oarchive & ar, const unsigned int version) const {
 
-        save_collection(ar, _watched_forms, [&ar](boost::archive::binary_oarchive& ar, const decltype(_watched_forms)::value_type& pair) {
-            auto entry = pair.second.lock();
-            ar << entry;
-        });
+        uint32_t count = u_forms_count();
+        ar << count;
+
+        for (auto& sh : _shards) {
+            sh.u_for_each([&ar](form_entry& entry) {
+                form_entry_ref ref{ entry };
+                ar << ref;
+            });
+        }
     }
 
     form_entry_ref form_observer::watch_form(FormId fId)
@@ -258,36 +519,26 @@ namespace forms {
             return nullptr;
         }
 
-        {
-
-            auto itr = _watched_forms.find(fId);
+        // an entry of a form which is queued as deleted must not be handed out
+        apply_pending_deletions();
 
-            std::lock_guard<boost::detail::spinlock> guard{ spinlock_for(fId) };
+        shard& sh = shard_for(fId);
+        std::lock_guard<util::spinlock> guard{ sh.lock };
 
-            if (itr != _watched_forms.end()) {
-                auto watched = itr->second.lock();
-                if (!watched || watched->is_deleted()) {
-                    // form-entry and real form has been deleted (recently)
-                    // watch the form again, create entry, assuming that a new form with such ID exists
+        // deleted forms and unreferenced entries leave the table, the found entry is alive
+        if (form_entry *watched = sh.u_find(fId)) {
+            log("queried form-entry %" PRIX32, fId);
+            return form_entry_ref{ watched };
+        }
 
-                    // this code assumes that @watch_form tries to watch real existing form
-                    // rather than the one from JSON
-                    itr->second = watched = form_entry::make(fId);
+        // this code assumes that @watch_form tries to watch real existing form
+        // rather than the one from JSON
+        form_entry_ref entry = form_entry::make(fId);
+        sh.u_insert(*entry);
+        entry->_observer.store(this, std::memory_order_release);
 
-                    log("queried, re-created form-entry %" PRIX32, fId);
-                }
-                else {
-                    log("queried form-entry %" PRIX32, fId);
-                }
-                return watched;
-            }
-            else {
-                auto entry_ref = form_entry::make(fId);
-                std::pair<watched_forms_t::iterator, bool> pair = _watched_forms.insert(watched_forms_t::value_type{ fId, entry_ref });
-                log("queried, created new form-entry %" PRIX32, fId);
-                return pair.first->second.lock();
-            }
-        }
+        log("queried, created new form-entry %" PRIX32, fId);
+        return entry;
     }
 
     struct lock_or_fail {
@@ -328,7 +579,11 @@ namespace forms {
     //////////////////
 
     bool form_ref::is_not_expired() const {
-        return _watched_form && !_watched_form->is_deleted();
+        if (!_watched_form) {
+            return false;
+        }
+        _watched_form->sync_deleted();
+        return !_watched_form->is_deleted();
     }
 
     FormId form_ref::get() const {
@@ -339,6 +594,15 @@ namespace forms {
         return _watched_form ? _watched_form->id() : FormId::Zero;
     }
 
+    TESForm* form_ref::form() const {
+        if (!_watched_form) {
+            return nullptr;
+        }
+        // the form might be queued as deleted, the pointer would be dangling
+        _watched_form->sync_deleted();
+        return _watched_form->form();
+    }
+
     template<class Archive>
     void form_ref::save(Archive & ar, const unsigned int version) const
     {
@@ -420,6 +684,17 @@ namespace forms {
                 }
 
             });
+
+            std::vector<form_ref> refs;
+            for (int i = 1; i <= 1000; ++i) {
+                refs.emplace_back(util::to_enum<FormId>(i), watcher);
+            }
+
+            util::do_with_timing("form_ref copies", [&](){
+                for (int i = 0; i < 1000; ++i) {
+                    std::vector<form_ref> copy = refs;
+                }
+            });
         }
 
 
@@ -449,8 +724,8 @@ namespace forms {
             }
         }
 
-/*
-        TEST(form_observer, u_remove_expired_forms){
+        // entries leave the observer as soon as they're deleted or unreferenced
+        TEST(form_observer, entries_leave_table){
             form_observer watcher;
 
             const auto fid = util::to_enum<FormId>(0xff000014);
@@ -458,13 +733,79 @@ namespace forms {
             auto entry = watcher.watch_form(fid);
             EXPECT_TRUE(watcher.u_forms_count() == 1);
             EXPECT_NOT_NIL(entry.get());
+            EXPECT_TRUE(watcher.watch_form(fid) == entry);
 
-            watcher.on_form_deleted(fh::form_id_to_handle(fid));
-            watcher.u_remove_expired_forms();
+            EXPECT_TRUE(watcher.on_form_deleted(fh::form_id_to_handle(fid)));
+            // queued, not applied yet
+            EXPECT_FALSE(entry->is_deleted());
+            watcher.apply_pending_deletions();
 
             EXPECT_TRUE(watcher.u_forms_count() == 0);
             EXPECT_TRUE(entry->is_deleted());
-        }*/
+
+            {
+                form_ref ref{ fid, watcher };
+                EXPECT_TRUE(ref.is_not_expired());
+                EXPECT_TRUE(watcher.u_forms_count() == 1);
+            }
+            EXPECT_TRUE(watcher.u_forms_count() == 0);
+        }
+
+        // deletion events come in bursts, mostly of the forms nobody watches
+        TEST(form_observer, batched_deletions){
+            form_observer watcher;
+            std::vector<form_ref> refs;
+
+            for (uint32_t i = 1; i <= 10000; ++i) {
+                refs.emplace_back(util::to_enum<FormId>(0xff000000 + i * 10), watcher);
+            }
+
+            uint32_t scheduled = 0;
+            util::do_with_timing("form_observer: 100k deletion events queued", [&](){
+                for (uint32_t i = 1; i <= 100000; ++i) {
+                    scheduled += watcher.on_form_deleted(fh::form_id_to_handle(util::to_enum<FormId>(0xff000000 + i)));
+                }
+            });
+            EXPECT_TRUE(scheduled == 1);
+
+            util::do_with_timing("form_observer: 100k deletion events applied", [&](){
+                watcher.apply_pending_deletions();
+            });
+
+            EXPECT_TRUE(watcher.u_forms_count() == 0);
+            EXPECT_TRUE(watcher.deletion_stats().events == 100000);
+            EXPECT_TRUE(watcher.deletion_stats().hits == 10000);
+            EXPECT_TRUE(watcher.deletion_stats().batches == 1);
+            EXPECT_TRUE(std::all_of(refs.begin(), refs.end(), [](const form_ref& ref) { return ref.is_expired(); }));
+
+            // a queued deletion gets applied before the form is accessed
+            form_ref ref{ util::to_enum<FormId>(0xff000001), watcher };
+            watcher.on_form_deleted(fh::form_id_to_handle(ref.get()));
+            EXPECT_TRUE(ref.is_expired());
+            EXPECT_NIL(ref.form());
+        }
+
+        TEST(form_observer, many_forms){
+            form_observer watcher;
+            std::vector<form_ref> refs;
+
+            for (uint32_t i = 1; i <= 10000; ++i) {
+                refs.emplace_back(util::to_enum<FormId>(i * 3), watcher);
+            }
+            EXPECT_TRUE(watcher.u_forms_count() == 10000);
+
+            // drop every other form, the remaining ones must still be found
+            for (uint32_t i = 0; i < refs.size(); i += 2) {
+                refs[i] = form_ref();
+            }
+            EXPECT_TRUE(watcher.u_forms_count() == 5000);
+
+            for (uint32_t i = 1; i < refs.size(); i += 2) {
+                watcher.on_form_deleted(fh::form_id_to_handle(util::to_enum<FormId>((i + 1) * 3)));
+                EXPECT_TRUE(refs[i].is_expired());
+            }
+            EXPECT_TRUE(watcher.u_forms_count() == 0);
+        }
 
         // lookup with a non-expired form-ref ID 0x14 to a list containing expired form-ref (0x14) should fail
         TEST(forms, bug_1)
@@ -582,6 +923,39 @@ namespace forms {
             expectExpired(id);
             expectExpired(id2);
         }
+
+        TEST(forms, cached_form_pointer){
+            const auto fid = util::to_enum<FormId>(0xff000015);
+
+            form_observer watcher;
+            form_ref id{ fid, watcher };
+            form_ref id2{ fid, watcher };
+
+            EXPECT_NOT_NIL(id.form());
+            EXPECT_TRUE(id.form() == id2.form());
+            EXPECT_NIL(form_ref().form());
+
+            watcher.on_form_deleted(fh::form_id_to_handle(fid));
+
+            EXPECT_NIL(id.form());
+            EXPECT_NIL(id2.form());
+        }
     }
 
 }
+
+namespace boost {
+namespace serialization {
+
+    template<class Archive>
+    void load(Archive & ar, forms::form_entry_ref & v, const unsigned int version) {
+        forms::form_entry* value = nullptr;
+        ar >> BOOST_SERIALIZATION_NVP(value);
+        v = forms::form_entry_ref(value);
+
+        if (value) {
+            ar.template get_helper<forms::loaded_form_entries>(forms::loaded_form_entries::id()).entries.push_back(v);
+        }
+    }
+}
+}
@@ -1,8 +1,15 @@
 #include "jc_interface.h"
 
+#include <memory>
+#include <string>
+
+#include "gtest.h"
 #include "util/istring.h"
+#include "util/stl_ext.h"
 #include "reflection/reflection.h"
 #include "domains/domain_master.h"
+#include "collections/access.h"
+#include "collections/path_compiler.h"
 
 namespace jc { namespace {
 
@@ -26,6 +33,322 @@ namespace jc { namespace {
         }
     };
 
+    //////////////////////////////////////////////////////////////////////////
+
+    namespace objects {
+
+        using namespace collections;
+
+        // domain_interface hands out the contexts
+        tes_context& context_of(void *domain) {
+            return *static_cast<tes_context*>(domain);
+        }
+
+        object_stack_ref object_of(void *domain, int32_t object) {
+            return domain ? context_of(domain).getObjectRef((Handle)object) : object_stack_ref();
+        }
+
+        // false if the value can't be stored
+        bool to_item(tes_context& context, const value& val, item& itm) {
+            switch (val.type) {
+            case value_none:
+                itm = item();
+                return true;
+            case value_integer:
+                itm = item(val.int_value);
+                return true;
+            case value_real:
+                itm = item(val.float_value);
+                return true;
+            case value_form:
+                itm = val.form_id ? item(make_weak_form_id(util::to_enum<FormId>(val.form_id), context)) : item();
+                return true;
+            case value_object: {
+                object_base *obj = context.getObject((Handle)val.object);
+                itm = item(obj);
+                return obj != nullptr || val.object == 0;
+            }
+            case value_string:
+                itm = item(val.string_value);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        // called under the container lock, a string value points into the item
+        void u_to_value(const item& itm, value& result) {
+            result = value::of_none();
+            result.type = itm.type();
+
+            switch (itm.type()) {
+            case item_type::integer:
+                result.int_value = itm.intValue();
+                break;
+            case item_type::real:
+                result.float_value = itm.fltValue();
+                break;
+            case item_type::form:
+                result.form_id = util::to_integral(itm.formId());
+                break;
+            case item_type::object:
+                result.object = (int32_t)itm.object()->uid();
+                break;
+            case item_type::string:
+                result.string_value = itm.strValue();
+                break;
+            default:
+                break;
+            }
+        }
+
+        void u_to_value(const item& itm, value& result, char *buffer, uint32_t bufferSize) {
+            u_to_value(itm, result);
+            if (result.type == value_string) {
+                if (buffer && bufferSize > 0) {
+                    strncpy_s(buffer, bufferSize, result.string_value ? result.string_value : "", _TRUNCATE);
+                    result.string_value = buffer;
+                }
+                else {
+                    result.string_value = nullptr;
+                }
+            }
+        }
+
+        struct key_lookup {
+            tes_context& context;
+            const value& key;
+
+            item* operator()(array& cnt) const {
+                return key.type == value_integer ? cnt.u_get(key.int_value) : nullptr;
+            }
+            item* operator()(integer_map& cnt) const {
+                return key.type == value_integer ? cnt.u_get(key.int_value) : nullptr;
+            }
+            item* operator()(map& cnt) const {
+                return key.type == value_string && key.string_value ? cnt.u_get(key.string_value) : nullptr;
+            }
+            item* operator()(form_map& cnt) const {
+                return key.type == value_form
+                    ? cnt.u_get(make_lightweight_form_ref(util::to_enum<FormId>(key.form_id), context))
+                    : nullptr;
+            }
+        };
+
+        struct key_assign {
+            tes_context& context;
+            const value& key;
+            item& itm;
+
+            item* operator()(array& cnt) const {
+                return key.type == value_integer ? cnt.u_set(key.int_value, std::move(itm)) : nullptr;
+            }
+            item* operator()(integer_map& cnt) const {
+                return key.type == value_integer ? cnt.u_set(key.int_value, std::move(itm)) : nullptr;
+            }
+            item* operator()(map& cnt) const {
+                return key.type == value_string && key.string_value ? cnt.u_set(key.string_value, std::move(itm)) : nullptr;
+            }
+            item* operator()(form_map& cnt) const {
+                return key.type == value_form && key.form_id
+                    ? cnt.u_set(make_weak_form_id(util::to_enum<FormId>(key.form_id), context), std::move(itm))
+                    : nullptr;
+            }
+        };
+
+        bool u_assign(tes_context& context, object_base& obj, const value& key, const value& val) {
+            item itm;
+            return to_item(context, val, itm)
+                && perform_on_object_and_return<item*>(obj, key_assign{ context, key, itm }) != nullptr;
+        }
+
+        struct visit_all {
+            bool(*visitor)(void *, const value *, const value *);
+            void *user_data;
+            uint32_t visited;
+
+            bool visit(const value& key, const item& itm) {
+                value val;
+                u_to_value(itm, val);
+                ++visited;
+                return visitor(user_data, &key, &val);
+            }
+
+            void operator()(array& cnt) {
+                int32_t index = 0;
+                for (auto& itm : cnt.u_container()) {
+                    if (!visit(value::of_int(index++), itm)) {
+                        return;
+                    }
+                }
+            }
+            void operator()(const integer_map& cnt) {
+                for (auto& pair : cnt.u_container()) {
+                    if (!visit(value::of_int(pair.first), pair.second)) {
+                        return;
+                    }
+                }
+            }
+            void operator()(const map& cnt) {
+                for (auto& pair : cnt.u_container()) {
+                    if (!visit(value::of_string(pair.first.c_str()), pair.second)) {
+                        return;
+                    }
+                }
+            }
+            void operator()(const form_map& cnt) {
+                for (auto& pair : cnt.u_container()) {
+                    if (!visit(value::of_form(util::to_integral(pair.first.get())), pair.second)) {
+                        return;
+                    }
+                }
+            }
+        };
+
+        // compiled for reading, the setter parses the text
+        struct precompiled_path {
+            std::string text;
+            std::shared_ptr<const path_resolving::compiled_path> compiled;
+        };
+
+        const object_interface obj = {
+            object_interface::version,
+
+            // is_valid
+            [](void *domain, int32_t object) -> bool {
+                return object_of(domain, object).get() != nullptr;
+            },
+            // create
+            [](void *domain, int32_t objectType) -> int32_t {
+                if (!domain) {
+                    return 0;
+                }
+
+                tes_context& context = context_of(domain);
+                object_base *created = nullptr;
+                switch (objectType) {
+                case array::TypeId: created = &array::object(context); break;
+                case map::TypeId: created = &map::object(context); break;
+                case form_map::TypeId: created = &form_map::object(context); break;
+                case integer_map::TypeId: created = &integer_map::object(context); break;
+                default: break;
+                }
+                return created ? (int32_t)created->uid() : 0;
+            },
+            // retain
+            [](void *domain, int32_t object) {
+                if (auto ref = object_of(domain, object)) {
+                    ref->tes_retain();
+                }
+            },
+            // release
+            [](void *domain, int32_t object) {
+                if (auto ref = object_of(domain, object)) {
+                    ref->tes_release();
+                }
+            },
+            // count
+            [](void *domain, int32_t object) -> int32_t {
+                auto ref = object_of(domain, object);
+                return ref ? ref->s_count() : 0;
+            },
+
+            // get
+            [](void *domain, int32_t object, const value *key, value *result, char *buffer, uint32_t bufferSize) -> bool {
+                auto ref = object_of(domain, object);
+                if (!ref || !key || !result) {
+                    return false;
+                }
+
+                object_lock g(ref);
+                auto itm = perform_on_object_and_return<item*>(*ref, key_lookup{ context_of(domain), *key });
+                if (itm) {
+                    u_to_value(*itm, *result, buffer, bufferSize);
+                }
+                return itm != nullptr;
+            },
+            // set
+            [](void *domain, int32_t object, const value *key, const value *val) -> bool {
+                auto ref = object_of(domain, object);
+                if (!ref || !key || !val) {
+                    return false;
+                }
+
+                object_lock g(ref);
+                return u_assign(context_of(domain), *ref, *key, *val);
+            },
+
+            // compile_path
+            [](const char *path) -> const void * {
+                if (!path) {
+                    return nullptr;
+                }
+                return new precompiled_path{ path, path_resolving::compile_path(util::make_cstring_safe(path, 1024)) };
+            },
+            // free_path
+            [](const void *path) {
+                delete static_cast<const precompiled_path *>(path);
+            },
+            // solve
+            [](void *domain, int32_t object, const void *path, value *result, char *buffer, uint32_t bufferSize) -> bool {
+                auto ref = object_of(domain, object);
+                if (!ref || !path || !result) {
+                    return false;
+                }
+
+                bool found = false;
+                path_resolving::resolve(context_of(domain), ref.get(), *static_cast<const precompiled_path *>(path)->compiled,
+                    [&](item *itm) {
+                        if (itm) {
+                            u_to_value(*itm, *result, buffer, bufferSize);
+                            found = true;
+                        }
+                    });
+                return found;
+            },
+            // solve_setter
+            [](void *domain, int32_t object, const void *path, const value *val, bool createMissingKeys) -> bool {
+                auto ref = object_of(domain, object);
+                item itm;
+                if (!ref || !path || !val || !to_item(context_of(domain), *val, itm)) {
+                    return false;
+                }
+
+                return ca::assign(*ref, static_cast<const precompiled_path *>(path)->text.c_str(), std::move(itm),
+                    createMissingKeys ? ca::creative : ca::constant);
+            },
+
+            // for_each
+            [](void *domain, int32_t object, bool(*visitor)(void *, const value *, const value *), void *userData) -> uint32_t {
+                auto ref = object_of(domain, object);
+                if (!ref || !visitor) {
+                    return 0;
+                }
+
+                visit_all visit{ visitor, userData, 0 };
+                object_lock g(ref);
+                perform_on_object(*ref, visit);
+                return visit.visited;
+            },
+            // set_many
+            [](void *domain, int32_t object, const value *keys, const value *values, uint32_t count) -> uint32_t {
+                auto ref = object_of(domain, object);
+                if (!ref || !keys || !values) {
+                    return 0;
+                }
+
+                tes_context& context = context_of(domain);
+                uint32_t assigned = 0;
+                object_lock g(ref);
+                for (uint32_t i = 0; i < count; ++i) {
+                    assigned += u_assign(context, *ref, keys[i], values[i]) ? 1 : 0;
+                }
+                return assigned;
+            },
+        };
+    }
+
+    //////////////////////////////////////////////////////////////////////////
 
     const void * query_interface(uint32_t id) {
         switch (id) {
@@ -33,6 +356,8 @@ namespace jc { namespace {
             return &refl;
         case domain_interface::type_id:
             return &dom;
+        case object_interface::type_id:
+            return &objects::obj;
         }
         return nullptr;
     }
@@ -43,4 +368,60 @@ namespace jc { namespace {
         root_interface::version,
         query_interface,
     };
+
+    namespace {
+
+        TEST(object_interface, access)
+        {
+            collections::tes_context_standalone context;
+            void *domain = &context;
+
+            auto api = root.query_interface<object_interface>();
+            EXPECT_TRUE(api != nullptr);
+
+            int32_t obj = api->create(domain, collections::map::TypeId);
+            EXPECT_TRUE(api->is_valid(domain, obj));
+
+            int32_t arr = api->create(domain, collections::array::TypeId);
+            value key = value::of_string("arr");
+            value val = value::of_object(arr);
+            EXPECT_TRUE(api->set(domain, obj, &key, &val));
+            EXPECT_FALSE(api->set(domain, arr, &key, &val));
+
+            value keys[] = { value::of_string("i"), value::of_string("s"), value::of_string("f") };
+            value values[] = { value::of_int(10), value::of_string("text"), value::of_float(1.5f) };
+            EXPECT_TRUE(api->set_many(domain, obj, keys, values, 3) == 3);
+            EXPECT_TRUE(api->count(domain, obj) == 4);
+
+            value result;
+            char buffer[3];
+            EXPECT_TRUE(api->get(domain, obj, &keys[1], &result, buffer, sizeof buffer));
+            EXPECT_TRUE(result.type == value_string && strcmp(result.string_value, "te") == 0);
+
+            key = value::of_string("missing");
+            EXPECT_FALSE(api->get(domain, obj, &key, &result, nullptr, 0));
+
+            auto path = api->compile_path(".arr");
+            EXPECT_TRUE(api->solve(domain, obj, path, &result, nullptr, 0));
+            EXPECT_TRUE(result.type == value_object && result.object == arr);
+            api->free_path(path);
+
+            path = api->compile_path(".new.key");
+            val = value::of_int(5);
+            EXPECT_FALSE(api->solve_setter(domain, obj, path, &val, false));
+            EXPECT_TRUE(api->solve_setter(domain, obj, path, &val, true));
+            EXPECT_TRUE(api->solve(domain, obj, path, &result, nullptr, 0) && result.int_value == 5);
+            api->free_path(path);
+
+            int32_t sum = 0;
+            auto visited = api->for_each(domain, obj, [](void *data, const value *, const value *val) {
+                if (val->type == value_integer) {
+                    *static_cast<int32_t*>(data) += val->int_value;
+                }
+                return true;
+            }, &sum);
+            EXPECT_TRUE(visited == 5);
+            EXPECT_TRUE(sum == 10);
+        }
+    }
 }
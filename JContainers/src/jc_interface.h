@@ -21,7 +21,7 @@ namespace jc {
         template<class Intrfc>
         const Intrfc * query_interface() const {
             auto intr = (const Intrfc *)_query_interface(Intrfc::type_id);
-            return intr->current_version == Intrfc::version ? intr : nullptr;
+            return intr && intr->current_version == Intrfc::version ? intr : nullptr;
         }
 
         static const root_interface * from_void(void * root) {
@@ -55,4 +55,90 @@ namespace jc {
         void * (*get_domain_with_name)(const char *domain_name);
 
     };
+
+    // value types, same as JValue.solvedValueType returns
+    enum value_type {
+        value_no_value = 0,
+        value_none,
+        value_integer,
+        value_real,
+        value_form,
+        value_object,
+        value_string,
+    };
+
+    // A value or a key of a container
+    struct value {
+        int32_t type;
+
+        union {
+            int32_t int_value;
+            float float_value;
+            uint32_t form_id;
+            int32_t object; // object identifier
+        };
+
+        // Received strings point either into the caller's buffer or, in for_each visitor, into the container
+        const char *string_value;
+
+        static value of_none() { value v = { value_none }; return v; }
+        static value of_int(int32_t i) { value v = of_none(); v.type = value_integer; v.int_value = i; return v; }
+        static value of_float(float f) { value v = of_none(); v.type = value_real; v.float_value = f; return v; }
+        static value of_form(uint32_t id) { value v = of_none(); v.type = value_form; v.form_id = id; return v; }
+        static value of_object(int32_t obj) { value v = of_none(); v.type = value_object; v.object = obj; return v; }
+        static value of_string(const char *str) { value v = of_none(); v.type = value_string; v.string_value = str; return v; }
+    };
+
+    // Direct typed access to the objects, without Papyrus-shaped calls and function lookups.
+    // The @domain is the one obtained through domain_interface, the @object is an object identifier - same as
+    // Papyrus scripts see. A key is a value: a string for JMap, an integer for JIntMap and JArray (an index,
+    // negative index counts from the end), a form for JFormMap.
+    // All the functions are thread-safe
+    struct object_interface {
+
+        enum {
+            type_id = 3,
+            version = 1,
+        };
+
+        uint32_t current_version;
+
+        // Object lifetime:
+
+        // true if the @object exists
+        bool (*is_valid)(void *domain, int32_t object);
+        // creates an empty container of JValue.objectType type (JArray - 1, JMap - 2, JFormMap - 3, JIntMap - 4).
+        // Same as the Papyrus object creation, the container gets destroyed unless retained or referenced
+        int32_t (*create)(void *domain, int32_t object_type);
+        // same as JValue.retain and JValue.release
+        void (*retain)(void *domain, int32_t object);
+        void (*release)(void *domain, int32_t object);
+        int32_t (*count)(void *domain, int32_t object);
+
+        // Access by key. A string value gets copied into the @buffer of @buffer_size bytes, truncated if needed
+
+        // false if there is no such key
+        bool (*get)(void *domain, int32_t object, const value *key, value *result, char *buffer, uint32_t buffer_size);
+        // a map gets the key inserted, an array index has to exist. False if failed to assign
+        bool (*set)(void *domain, int32_t object, const value *key, const value *val);
+
+        // Access by path (see JValue.solve* functions). The path gets parsed once, by compile_path.
+        // Compiled paths are not bound to a domain and should be released with free_path
+
+        const void * (*compile_path)(const char *path);
+        void (*free_path)(const void *path);
+        // false if there is no value at the path
+        bool (*solve)(void *domain, int32_t object, const void *path, value *result, char *buffer, uint32_t buffer_size);
+        bool (*solve_setter)(void *domain, int32_t object, const void *path, const value *val, bool create_missing_keys);
+
+        // Bulk operations. Each one locks the container once:
+
+        // calls the @visitor with each key and value of the container until the visitor returns false.
+        // The visitor gets called under the container lock, so it must not call JContainers.
+        // Returns the number of visited values
+        uint32_t (*for_each)(void *domain, int32_t object,
+            bool (*visitor)(void *user_data, const value *key, const value *val), void *user_data);
+        // assigns values[i] to keys[i], same as set does. Returns the number of assigned values
+        uint32_t (*set_many)(void *domain, int32_t object, const value *keys, const value *values, uint32_t count);
+    };
 }
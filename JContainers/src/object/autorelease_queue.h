@@ -3,50 +3,39 @@
 #include <atomic>
 #include <deque>
 #include <boost\serialization\version.hpp>
-#include <boost\asio\io_service.hpp>
-#include <boost\asio\deadline_timer.hpp>
-#include "common\IThread.h"
 #include "util\util.h"
 #include "util\singleton.h"
+#include "background_worker.h"
+#include "task_scheduler.h"
 
 namespace collections {
 
-
     namespace detail {
 
-#   define WINE_SUPPORT 1
-
-        struct background_worker {
-            boost::asio::io_service _io;
-            boost::asio::io_service::work _work;
-#   if WINE_SUPPORT
-            IThread _thread;
-#   else
-            std::thread _thread;
-#   endif
-
-            background_worker() : _io(), _work(_io) {
-#   if WINE_SUPPORT
-                using io_ptr_type = decltype(_io);
-                _thread.Start([](void *io_ptr) { reinterpret_cast<io_ptr_type*>(io_ptr)->run(); }, &_io);
-#   else
-                _thread = std::thread([&]() { _io.run(); });
-#   endif
-            }
+        // JCData/Settings.json may set the number of background workers: { "backgroundWorkers": 2 }.
+        // Absent or zero means the default one
+        size_t configured_worker_count() {
+            auto path = util::relative_to_dll_path(JC_DATA_FILES "Settings.json");
+            json_error_t error;
+            json_t *settings = json_load_file(path.generic_string().c_str(), 0, &error);
+            json_int_t count = settings ? json_integer_value(json_object_get(settings, "backgroundWorkers")) : 0;
+            json_decref(settings);
+            return count > 0 ? (size_t)count : task_scheduler::default_worker_count();
+        }
 
-            ~background_worker() {
-#   if WINE_SUPPORT
-                _thread.Stop();
-                WaitForSingleObject(_thread.GetHandle(), INFINITE);
-#   else
-                if (_thread.joinable()) {
-                    _thread.join();
-                }
-#   endif
-            }
-        };
+        util::singleton<task_scheduler> g_background_scheduler{ [](){ return new task_scheduler(configured_worker_count()); } };
+    }
 
-        util::singleton<background_worker> g_background_worker{ [](){ return new background_worker(); } };
+    task_scheduler& background_scheduler() {
+        return detail::g_background_scheduler.get();
+    }
+
+    void post_to_background_worker(std::function<void()> task) {
+        background_scheduler().post(std::move(task));
+    }
+
+    void print_background_worker_stats() {
+        background_scheduler().print_stats();
     }
 
 
@@ -78,9 +67,15 @@ namespace collections {
         time_point _tickCounter;
         spinlock _queue_mutex;
         
-        boost::asio::deadline_timer _timer;
-        std::mutex _timer_mutex;
-        bool _timer_stopped = true;
+        // shared with the scheduled tick, which may fire after the aqueue is stopped or gone
+        struct timer_state {
+            std::mutex lock;
+            // null while stopped
+            autorelease_queue *owner = nullptr;
+            // a tick scheduled before the last stop doesn't run and doesn't reschedule
+            uint32_t generation = 0;
+        };
+        std::shared_ptr<timer_state> _timer = std::make_shared<timer_state>();
         // reusable array for temp objects
         std::vector<queue_object_ref> _toRelease;
 
@@ -148,7 +143,6 @@ namespace collections {
             : _registry(registry)
             , _queue()
             , _tickCounter(0)
-            , _timer(detail::g_background_worker.get()._io)
         {
             start();
             //jc_debug("aqueue created")
@@ -189,21 +183,20 @@ namespace collections {
 
         // starts asynchronouos aqueue run, asynchronouosly releases objects when their time comes, starts timers, 
         void start() {
-            std::lock_guard<std::mutex> g(_timer_mutex);
-            if (_timer_stopped) {
-                _timer_stopped = false;
-                u_startTimer();
+            std::lock_guard<std::mutex> g(_timer->lock);
+            if (!_timer->owner) {
+                _timer->owner = this;
+                schedule_tick(_timer, _timer->generation);
             }
         }
 
         // stops async. processes launched by @start function,
         void stop() {
-            // with _timer_mutex locked it will wait for @tick function execution completion
+            // with the timer lock held it will wait for @tick function execution completion
             // the point is to execute @stop after @tick (so @tick will not auto-restart the timer)
-            std::lock_guard<std::mutex> g(_timer_mutex);
-            _timer_stopped = true;
-            auto callbacks_cancelled = _timer.cancel();
-            jc_assert(callbacks_cancelled <= 1);
+            std::lock_guard<std::mutex> g(_timer->lock);
+            _timer->owner = nullptr;
+            ++_timer->generation;
         }
 
         void u_nullify() {
@@ -260,22 +253,14 @@ namespace collections {
 
     private:
 
-        void u_startTimer() {
-
-            boost::system::error_code code;
-            _timer.expires_from_now(boost::posix_time::seconds(tick_duration), code);
-            assert(!code);
-
-            _timer.async_wait([this](const boost::system::error_code& error) {
-                if (error) {// !e means error or cancel, or unsuccessful completion
-                    return;
+        // ticks run on the scheduler's high priority lane, so bulk background jobs can't delay them
+        static void schedule_tick(const std::shared_ptr<timer_state>& state, uint32_t generation) {
+            background_scheduler().post_after(std::chrono::seconds(tick_duration), [state, generation]() {
+                std::lock_guard<std::mutex> g(state->lock);
+                if (state->owner && state->generation == generation) {
+                    state->owner->tick();
+                    schedule_tick(state, generation);
                 }
-
-                std::lock_guard<std::mutex> g(this->_timer_mutex);
-                if (!this->_timer_stopped) { 
-                    this->tick();
-                    this->u_startTimer();
-				}
             });
         }
 
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "object/background_worker.h"
+
+namespace collections {
+
+    // Runs a context's tasks on the background worker, one at a time and in posting order. Tasks get postponed
+    // while the context's activity is stopped (loading, saving) and dropped once the context is closed,
+    // so that no task outlives it. pause() and close() wait for the running task to complete.
+    // The gate is a serial queue: a single drain job runs the queued tasks one after another, so a context
+    // occupies at most one worker and the other workers never wait for its tasks
+    class background_tasks {
+
+        struct state {
+            std::mutex lock;
+            // signalled once the running task completes
+            std::condition_variable idle;
+            bool closed = false;
+            int paused = 0;
+            // a task is running: on the drain job or in run_now
+            bool executing = false;
+            // the drain job is posted or running
+            bool draining = false;
+            // posted tasks waiting for their turn, postponed ones included
+            std::deque<std::function<void()>> queue;
+        };
+
+        std::shared_ptr<state> _state = std::make_shared<state>();
+
+    public:
+
+        background_tasks() = default;
+        background_tasks(const background_tasks&) = delete;
+        background_tasks& operator = (const background_tasks&) = delete;
+
+        ~background_tasks() {
+            close();
+        }
+
+        void post(std::function<void()> task) {
+            enqueue(_state, std::move(task));
+        }
+
+        // The @prepare part runs on the worker outside of the gate, so it must not touch the context
+        // (file I/O, JSON parsing). The task it returns gets queued as the posted ones do
+        void post_prepared(std::function<std::function<void()>()> prepare) {
+            auto st = _state;
+            post_to_background_worker([st, prepare]() {
+                {
+                    std::lock_guard<std::mutex> g(st->lock);
+                    if (st->closed) {
+                        return;
+                    }
+                }
+                enqueue(st, prepare());
+            });
+        }
+
+        // runs the @task right now, once the running task (if any) completes. Postponed if paused
+        void run_now(const std::function<void()>& task) {
+            {
+                std::unique_lock<std::mutex> g(_state->lock);
+                _state->idle.wait(g, [this]() { return !_state->executing; });
+                if (_state->closed || !task) {
+                    return;
+                }
+                if (_state->paused > 0) {
+                    _state->queue.push_back(task);
+                    return;
+                }
+                _state->executing = true;
+            }
+
+            task();
+            finish_task(_state);
+        }
+
+        void pause() {
+            std::unique_lock<std::mutex> g(_state->lock);
+            ++_state->paused;
+            _state->idle.wait(g, [this]() { return !_state->executing; });
+        }
+
+        void resume() {
+            bool startDrain = false;
+            {
+                std::lock_guard<std::mutex> g(_state->lock);
+                if (--_state->paused > 0) {
+                    return;
+                }
+                startDrain = u_start_draining(*_state);
+            }
+
+            if (startDrain) {
+                post_drain(_state);
+            }
+        }
+
+        // the tasks, both scheduled and postponed, won't run anymore
+        void close() {
+            std::unique_lock<std::mutex> g(_state->lock);
+            _state->closed = true;
+            _state->queue.clear();
+            _state->idle.wait(g, [this]() { return !_state->executing; });
+        }
+
+    private:
+
+        static void enqueue(const std::shared_ptr<state>& st, std::function<void()> task) {
+            bool startDrain = false;
+            {
+                std::lock_guard<std::mutex> g(st->lock);
+                if (st->closed || !task) {
+                    return;
+                }
+                st->queue.push_back(std::move(task));
+                startDrain = u_start_draining(*st);
+            }
+
+            if (startDrain) {
+                post_drain(st);
+            }
+        }
+
+        // true if the drain job has to be posted. Called under the state lock
+        static bool u_start_draining(state& st) {
+            if (st.draining || st.executing || st.paused > 0 || st.closed || st.queue.empty()) {
+                return false;
+            }
+            st.draining = true;
+            return true;
+        }
+
+        static void post_drain(const std::shared_ptr<state>& st) {
+            post_to_background_worker([st]() { drain(st); });
+        }
+
+        // Runs the queued tasks until the queue is empty or the gate gets paused or closed.
+        // If run_now has taken the turn, the job ends: run_now posts a new one once it's done
+        static void drain(const std::shared_ptr<state>& st) {
+            std::unique_lock<std::mutex> g(st->lock);
+            while (!st->closed && st->paused == 0 && !st->executing && !st->queue.empty()) {
+                auto task = std::move(st->queue.front());
+                st->queue.pop_front();
+                st->executing = true;
+
+                g.unlock();
+                task();
+                g.lock();
+
+                st->executing = false;
+                st->idle.notify_all();
+            }
+            st->draining = false;
+        }
+
+        static void finish_task(const std::shared_ptr<state>& st) {
+            bool startDrain = false;
+            {
+                std::lock_guard<std::mutex> g(st->lock);
+                st->executing = false;
+                st->idle.notify_all();
+                startDrain = u_start_draining(*st);
+            }
+
+            if (startDrain) {
+                post_drain(st);
+            }
+        }
+    };
+}
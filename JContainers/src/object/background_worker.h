@@ -0,0 +1,17 @@
+#pragma once
+
+#include <functional>
+
+namespace collections {
+
+    class task_scheduler;
+
+    // the per-process scheduler running background tasks
+    task_scheduler& background_scheduler();
+
+    // Runs the @task on one of the background workers, as a normal priority task
+    void post_to_background_worker(std::function<void()> task);
+
+    // logs queue depths and task wait times
+    void print_background_worker_stats();
+}
@@ -50,11 +50,16 @@ namespace collections {
 
     public:
         std::atomic<Handle> _id                 = Handle::Null;
+        // unlike the handle never gets reused: tells whether an object found by a handle is the one
+        // the handle was taken from
+        const uint64_t _serial                  = next_serial();
 
         std::atomic_int32_t _refCount           = 0;
         std::atomic_int32_t _tes_refCount       = 0;
         std::atomic_int32_t _stack_refCount     = 0;
         std::atomic_int32_t _aqueue_refCount    = 0;
+        // number of change subscriptions, see change_feed
+        std::atomic_int32_t _watchers           = 0;
         time_point _aqueue_push_time            = 0;
 
         CollectionType                          _type = CollectionType::None;
@@ -65,6 +70,7 @@ namespace collections {
         void release_counter(std::atomic_int32_t& counter);
         bool is_completely_initialized() const { return _context != nullptr; }
         void try_prolong_lifetime();
+        static uint64_t next_serial();
 
     public:
 
@@ -92,6 +98,10 @@ namespace collections {
             return _uid() != Handle::Null;
         }
 
+        bool is_watched() const {
+            return _watchers.load(std::memory_order_relaxed) > 0;
+        }
+
         spinlock& mutex() const { return _mutex; }
 
         template<class T> T* as() {
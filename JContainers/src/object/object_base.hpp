@@ -1,5 +1,12 @@
 namespace collections
 {
+    // zero-initialized before any dynamic initialization, so objects constructed by static initializers are fine
+    static std::atomic<uint64_t> g_last_object_serial;
+
+    uint64_t object_base::next_serial() {
+        return ++g_last_object_serial;
+    }
+
     void object_base::_registerSelf() {
         context().registry->registerNewObject(*this);
     }
@@ -80,6 +87,9 @@ namespace collections
 
     void object_base::_delete_self() {
         // it's still possible that something will attepmt to access this object now?
+        if (is_watched()) {
+            context().on_watched_object_destroyed(*this);
+        }
         context().registry->removeObject(*this);
         delete this;
     }
@@ -90,8 +90,10 @@ namespace collections {
             ~activity_stopper();
         };
 
-        void stop_activity();
-        void start_activity();
+        virtual void stop_activity();
+        virtual void start_activity();
+        // called before a watched object (see object_base::_watchers) gets deleted
+        virtual void on_watched_object_destroyed(object_base& obj) {}
         void u_clearState();
 
     public:
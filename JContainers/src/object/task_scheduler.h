@@ -0,0 +1,336 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "common\IThread.h"
+#include "util\util.h"
+#include "reflection/profiling.h"
+
+namespace collections {
+
+#   define WINE_SUPPORT 1
+
+    struct task_scheduler_metrics {
+
+        enum { kPriorityCount = 2 };
+
+        // tasks waiting to run, timers not yet due aren't counted
+        std::atomic<int64_t> queued[kPriorityCount];
+        std::atomic<uint64_t> executed[kPriorityCount];
+        // time between the task got queued (its timer got due) and started, microseconds
+        std::atomic<uint64_t> total_wait_us[kPriorityCount];
+        std::atomic<uint64_t> max_wait_us[kPriorityCount];
+        // normal tasks taken from another worker's queue
+        std::atomic<uint64_t> stolen;
+
+        task_scheduler_metrics() {
+            for (int i = 0; i < kPriorityCount; ++i) {
+                queued[i].store(0, std::memory_order_relaxed);
+                executed[i].store(0, std::memory_order_relaxed);
+                total_wait_us[i].store(0, std::memory_order_relaxed);
+                max_wait_us[i].store(0, std::memory_order_relaxed);
+            }
+            stolen.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    // Per-process pool running background tasks: aqueue ticks, deleted forms processing, asynchronous I/O.
+    // Normal tasks get spread between the workers' queues; a worker runs its own tasks in posting order and steals
+    // from the others' queue tails once its own queue is empty. High priority tasks and timers run on a separate lane,
+    // so that aqueue ticks are never stuck behind bulk jobs. Nothing is ordered between the workers: tasks which
+    // must not overlap have to be serialized by their owner (see background_tasks)
+    class task_scheduler {
+    public:
+
+        enum priority_t {
+            normal,
+            high,
+        };
+
+        using clock = std::chrono::steady_clock;
+
+    private:
+
+        struct entry {
+            std::function<void()> task;
+            int64_t queued_at;
+        };
+
+        struct worker {
+            task_scheduler *owner;
+            size_t index;
+            std::mutex lock;
+            std::deque<entry> tasks;
+#   if WINE_SUPPORT
+            IThread thread;
+#   else
+            std::thread thread;
+#   endif
+        };
+
+        struct timer {
+            clock::time_point due;
+            uint64_t seq;
+            std::function<void()> task;
+
+            // makes the priority_queue a min-heap, the timers with the same due time fire in posting order
+            bool operator < (const timer& other) const {
+                return due != other.due ? due > other.due : seq > other.seq;
+            }
+        };
+
+        std::vector<std::unique_ptr<worker>> _workers;
+        std::atomic<size_t> _next_worker{ 0 };
+
+        std::mutex _idle_lock;
+        std::condition_variable _idle;
+
+        // the high priority lane
+        std::mutex _high_lock;
+        std::condition_variable _high_wakeup;
+        std::deque<entry> _high;
+        std::priority_queue<timer> _timers;
+        uint64_t _timer_seq = 0;
+        worker _high_worker;
+
+        std::atomic<bool> _stopping{ false };
+        task_scheduler_metrics _metrics;
+
+    public:
+
+        // default number of normal task workers: hardware concurrency minus the thread the game runs on
+        static size_t default_worker_count() {
+            auto cores = std::thread::hardware_concurrency();
+            return cores > 1 ? cores - 1 : 1;
+        }
+
+        // @workerCount normal task workers, plus one thread for the high priority tasks and timers
+        explicit task_scheduler(size_t workerCount = default_worker_count()) {
+            _high_worker.owner = this;
+            _high_worker.index = 0;
+
+            workerCount = workerCount > 0 ? workerCount : 1;
+            for (size_t i = 0; i < workerCount; ++i) {
+                _workers.emplace_back(new worker());
+                _workers.back()->owner = this;
+                _workers.back()->index = i;
+            }
+
+            start_thread(_high_worker, [](void *w) { auto self = reinterpret_cast<worker*>(w); self->owner->run_high_lane(); });
+            for (auto& w : _workers) {
+                start_thread(*w, [](void *w) { auto self = reinterpret_cast<worker*>(w); self->owner->run_worker(*self); });
+            }
+        }
+
+        // The queued tasks are dropped. Nothing gets locked here, as during the exit the workers may have been
+        // terminated while holding a lock; idle workers notice the stop on their next wakeup
+        ~task_scheduler() {
+            _stopping.store(true, std::memory_order_release);
+            _idle.notify_all();
+            _high_wakeup.notify_all();
+
+            join_thread(_high_worker);
+            for (auto& w : _workers) {
+                join_thread(*w);
+            }
+        }
+
+        task_scheduler(const task_scheduler&) = delete;
+        task_scheduler& operator = (const task_scheduler&) = delete;
+
+        size_t worker_count() const { return _workers.size(); }
+
+        const task_scheduler_metrics& metrics() const { return _metrics; }
+
+        void post(std::function<void()> task, priority_t priority = normal) {
+            if (priority == high) {
+                {
+                    std::lock_guard<std::mutex> g(_high_lock);
+                    _high.push_back(entry{ std::move(task), reflection::profiling::timestamp() });
+                    _metrics.queued[high].fetch_add(1, std::memory_order_relaxed);
+                }
+                _high_wakeup.notify_one();
+                return;
+            }
+
+            worker& w = *_workers[_next_worker.fetch_add(1, std::memory_order_relaxed) % _workers.size()];
+            {
+                std::lock_guard<std::mutex> g(w.lock);
+                w.tasks.push_back(entry{ std::move(task), reflection::profiling::timestamp() });
+                _metrics.queued[normal].fetch_add(1, std::memory_order_relaxed);
+            }
+            {
+                // so that a worker which has just found nothing to do doesn't fall asleep
+                std::lock_guard<std::mutex> g(_idle_lock);
+            }
+            _idle.notify_one();
+        }
+
+        // runs the @task on the high priority lane once the @delay passes
+        template<class Rep, class Period>
+        void post_after(const std::chrono::duration<Rep, Period>& delay, std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> g(_high_lock);
+                _timers.push(timer{ clock::now() + delay, _timer_seq++, std::move(task) });
+            }
+            _high_wakeup.notify_one();
+        }
+
+        void print_stats() const {
+            for (int p = normal; p <= high; ++p) {
+                auto executed = _metrics.executed[p].load();
+                JC_log("background %s tasks: %llu executed, %lld queued, wait avg %llu us, max %llu us",
+                    p == high ? "high priority" : "normal", executed, _metrics.queued[p].load(),
+                    executed ? _metrics.total_wait_us[p].load() / executed : 0ull, _metrics.max_wait_us[p].load());
+            }
+            JC_log("background workers: %u, %llu tasks stolen", (uint32_t)_workers.size(), _metrics.stolen.load());
+        }
+
+    private:
+
+        template<class Proc>
+        static void start_thread(worker& w, Proc proc) {
+#   if WINE_SUPPORT
+            w.thread.Start(proc, &w);
+#   else
+            w.thread = std::thread(proc, &w);
+#   endif
+        }
+
+        static void join_thread(worker& w) {
+#   if WINE_SUPPORT
+            w.thread.Stop();
+            WaitForSingleObject(w.thread.GetHandle(), INFINITE);
+#   else
+            if (w.thread.joinable()) {
+                w.thread.join();
+            }
+#   endif
+        }
+
+        void execute(entry& e, priority_t priority) {
+            uint64_t waited = reflection::profiling::ticks_to_us(reflection::profiling::timestamp() - e.queued_at);
+            _metrics.total_wait_us[priority].fetch_add(waited, std::memory_order_relaxed);
+            uint64_t prevMax = _metrics.max_wait_us[priority].load(std::memory_order_relaxed);
+            while (waited > prevMax && !_metrics.max_wait_us[priority].compare_exchange_weak(prevMax, waited, std::memory_order_relaxed)) {
+            }
+
+            e.task();
+            _metrics.executed[priority].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        bool pop_own(worker& w, entry& e) {
+            std::lock_guard<std::mutex> g(w.lock);
+            if (w.tasks.empty()) {
+                return false;
+            }
+            e = std::move(w.tasks.front());
+            w.tasks.pop_front();
+            _metrics.queued[normal].fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        bool steal(worker& thief, entry& e) {
+            for (size_t i = 1; i < _workers.size(); ++i) {
+                worker& victim = *_workers[(thief.index + i) % _workers.size()];
+                std::lock_guard<std::mutex> g(victim.lock);
+                if (!victim.tasks.empty()) {
+                    e = std::move(victim.tasks.back());
+                    victim.tasks.pop_back();
+                    _metrics.queued[normal].fetch_sub(1, std::memory_order_relaxed);
+                    _metrics.stolen.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void run_worker(worker& w) {
+            while (!_stopping.load(std::memory_order_acquire)) {
+                entry e;
+                if (pop_own(w, e) || steal(w, e)) {
+                    execute(e, normal);
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> l(_idle_lock);
+                // the timeout covers the shutdown, which notifies without locking
+                _idle.wait_for(l, std::chrono::milliseconds(200), [this]() {
+                    return _stopping.load(std::memory_order_acquire) || _metrics.queued[normal].load(std::memory_order_relaxed) > 0;
+                });
+            }
+        }
+
+        void run_high_lane() {
+            std::unique_lock<std::mutex> l(_high_lock);
+            while (!_stopping.load(std::memory_order_acquire)) {
+                auto now = clock::now();
+                while (!_timers.empty() && _timers.top().due <= now) {
+                    _high.push_back(entry{ _timers.top().task, reflection::profiling::timestamp() });
+                    _metrics.queued[high].fetch_add(1, std::memory_order_relaxed);
+                    _timers.pop();
+                }
+
+                if (!_high.empty()) {
+                    entry e = std::move(_high.front());
+                    _high.pop_front();
+                    _metrics.queued[high].fetch_sub(1, std::memory_order_relaxed);
+                    l.unlock();
+                    execute(e, high);
+                    l.lock();
+                    continue;
+                }
+
+                auto until = _timers.empty() ? now + std::chrono::milliseconds(200) : (std::min)(_timers.top().due, now + std::chrono::milliseconds(200));
+                _high_wakeup.wait_until(l, until);
+            }
+        }
+    };
+
+    TEST(task_scheduler, high_priority_tasks_are_not_starved)
+    {
+        task_scheduler scheduler(2);
+
+        std::atomic<bool> released{ false };
+        std::atomic<int> normalDone{ 0 }, highDone{ 0 };
+
+        auto wait_for = [](const std::function<bool()>& condition) {
+            for (int i = 0; i < 500 && !condition(); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return condition();
+        };
+
+        // bulk jobs occupy all the workers
+        for (int i = 0; i < 2; ++i) {
+            scheduler.post([&]() {
+                while (!released) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                ++normalDone;
+            });
+        }
+
+        scheduler.post([&]() { ++highDone; }, task_scheduler::high);
+        scheduler.post_after(std::chrono::milliseconds(50), [&]() { ++highDone; });
+        EXPECT_TRUE(wait_for([&]() { return highDone == 2; }));
+        EXPECT_TRUE(normalDone == 0);
+
+        released = true;
+        for (int i = 0; i < 100; ++i) {
+            scheduler.post([&]() { ++normalDone; });
+        }
+        EXPECT_TRUE(wait_for([&]() { return normalDone == 102; }));
+        EXPECT_TRUE(wait_for([&]() { return scheduler.metrics().executed[task_scheduler::normal] == 102; }));
+        EXPECT_TRUE(scheduler.metrics().queued[task_scheduler::normal] == 0);
+    }
+}
@@ -1,10 +1,13 @@
 #include "reflection/reflection.h"
 
 #include <map>
+#include <set>
+#include <jansson.h>
 #include "gtest.h"
 #include "util/spinlock.h"
 #include "util/singleton.h"
 #include "skse/PapyrusVM.h"
+#include "reflection/profiling.h"
 
 #include "reflection/detail/code_producer.hpp"
 #include "reflection/detail/type_traits.hpp"
@@ -54,6 +57,116 @@ namespace reflection {
         return fInfo;
     }
 
+    namespace profiling {
+
+        bool start(const char *className) {
+            auto enable = [](const class_info& cls) {
+                for (const auto& func : cls.methods) {
+                    if (func.stats) {
+                        func.stats->enabled.store(true, std::memory_order_relaxed);
+                    }
+                }
+            };
+
+            auto& db = class_registry();
+            if (!className || !*className) {
+                foreach_metaInfo_do(db, enable);
+                return true;
+            }
+
+            auto itr = db.find(className);
+            if (itr == db.end()) {
+                return false;
+            }
+            enable(itr->second);
+            return true;
+        }
+
+        void stop() {
+            foreach_metaInfo_do(class_registry(), [](const class_info& cls) {
+                for (const auto& func : cls.methods) {
+                    if (func.stats) {
+                        func.stats->enabled.store(false, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+
+        void reset() {
+            foreach_metaInfo_do(class_registry(), [](const class_info& cls) {
+                for (const auto& func : cls.methods) {
+                    if (func.stats) {
+                        func.stats->reset();
+                    }
+                }
+            });
+        }
+
+        bool dump_to_file(const char *filePath) {
+            if (!filePath) {
+                return false;
+            }
+
+            struct entry {
+                std::string name;
+                const function_stats *stats;
+                uint64_t calls, total_ns;
+            };
+
+            // a function may be registered under several names, it gets reported once
+            std::set<const function_stats*> seen;
+            std::vector<entry> entries;
+            foreach_metaInfo_do(class_registry(), [&](const class_info& cls) {
+                for (const auto& func : cls.methods) {
+                    if (func.stats && seen.insert(func.stats).second) {
+                        auto calls = func.stats->calls.load(std::memory_order_relaxed);
+                        if (calls > 0) {
+                            entries.push_back(entry{ std::string(cls.className().c_str()) + '.' + func.name.c_str(), func.stats,
+                                calls, func.stats->total_ns.load(std::memory_order_relaxed) });
+                        }
+                    }
+                }
+            });
+
+            std::sort(entries.begin(), entries.end(), [](const entry& l, const entry& r) {
+                return l.total_ns > r.total_ns;
+            });
+
+            json_t *root = json_object();
+
+            json_t *bounds = json_array();
+            uint64_t bound = function_stats::kFirstBucketBoundNs;
+            for (size_t i = 0; i < function_stats::kBucketCount - 1; ++i, bound *= 4) {
+                json_array_append_new(bounds, json_integer((json_int_t)bound));
+            }
+            json_object_set_new(root, "histogramUpperBoundsNs", bounds);
+
+            json_t *functions = json_array();
+            for (const auto& e : entries) {
+                json_t *func = json_object();
+                json_object_set_new(func, "name", json_string(e.name.c_str()));
+                json_object_set_new(func, "calls", json_integer((json_int_t)e.calls));
+                // nanoseconds are converted only here, sums of short calls keep their precision
+                json_object_set_new(func, "totalUs", json_real(e.total_ns / 1000.0));
+                json_object_set_new(func, "averageUs", json_real(e.total_ns / 1000.0 / e.calls));
+                json_object_set_new(func, "maxUs", json_real(e.stats->max_ns.load(std::memory_order_relaxed) / 1000.0));
+
+                json_t *histogram = json_array();
+                for (const auto& bucket : e.stats->buckets) {
+                    json_array_append_new(histogram, json_integer((json_int_t)bucket.load(std::memory_order_relaxed)));
+                }
+                json_object_set_new(func, "histogram", histogram);
+
+                json_array_append_new(functions, func);
+            }
+            json_object_set_new(root, "functions", functions);
+
+            bool succeed = json_dump_file(root, filePath, JSON_INDENT(2)) == 0;
+            json_decref(root);
+            return succeed;
+        }
+    }
+
     class_info amalgamate_classes(const std::string& amalgName, const std::map<istring, class_info>& classes) {
         class_info amalgam{ amalgName.c_str() };
 
@@ -102,4 +215,32 @@ namespace reflection {
         EXPECT_TRUE(func->name == "nothing");
         EXPECT_TRUE(func->c_func == &test_class::nothing);
     }
+
+    TEST(reflection, function_stats)
+    {
+        function_stats stats;
+        profiling::call_timer{ stats };
+        EXPECT_TRUE(stats.calls == 0);
+
+        stats.enabled = true;
+        profiling::call_timer{ stats };
+        EXPECT_TRUE(stats.calls == 1);
+
+        stats.record(0);
+        stats.record(300);
+        stats.record(5000000);
+        stats.record(100000000);
+        EXPECT_TRUE(stats.calls == 5);
+        EXPECT_TRUE(stats.max_ns == 100000000);
+        EXPECT_TRUE(stats.buckets[1] >= 1);
+        EXPECT_TRUE(stats.buckets[function_stats::kBucketCount - 1] == 2);
+        // sub-microsecond calls add up instead of being truncated to zero
+        EXPECT_TRUE(stats.total_ns >= 5000000 + 100000000 + 300);
+
+        EXPECT_TRUE(profiling::ticks_to_ns(profiling::frequency()) == 1000000000);
+        EXPECT_TRUE(profiling::ticks_to_ns(profiling::frequency() * 3600 + 1) >= 3600000000000ull);
+
+        stats.reset();
+        EXPECT_TRUE(stats.calls == 0 && stats.max_ns == 0);
+    }
 }
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+namespace reflection {
+
+    // Call statistics of a native function. Calls are recorded only while the function's @enabled flag is set,
+    // otherwise the instrumentation costs a relaxed atomic load per call
+    struct function_stats {
+
+        // bucket 0 counts the calls that took less than kFirstBucketBoundNs nanoseconds,
+        // bucket N - [kFirstBucketBoundNs * 4^(N-1), kFirstBucketBoundNs * 4^N), the last one counts the rest
+        enum { kBucketCount = 8 };
+        enum : uint64_t { kFirstBucketBoundNs = 250 };
+
+        // the times are kept in nanoseconds: a typical call takes well under a microsecond
+        std::atomic<bool> enabled;
+        std::atomic<uint64_t> calls;
+        std::atomic<uint64_t> total_ns;
+        std::atomic<uint64_t> max_ns;
+        std::atomic<uint64_t> buckets[kBucketCount];
+
+        function_stats() {
+            enabled.store(false, std::memory_order_relaxed);
+            reset();
+        }
+
+        void reset() {
+            calls.store(0, std::memory_order_relaxed);
+            total_ns.store(0, std::memory_order_relaxed);
+            max_ns.store(0, std::memory_order_relaxed);
+            for (auto& bucket : buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        static size_t bucket_of(uint64_t ns) {
+            size_t idx = 0;
+            for (uint64_t bound = kFirstBucketBoundNs; idx < kBucketCount - 1 && ns >= bound; bound *= 4) {
+                ++idx;
+            }
+            return idx;
+        }
+
+        void record(uint64_t ns) {
+            calls.fetch_add(1, std::memory_order_relaxed);
+            total_ns.fetch_add(ns, std::memory_order_relaxed);
+            buckets[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+
+            uint64_t prevMax = max_ns.load(std::memory_order_relaxed);
+            while (ns > prevMax && !max_ns.compare_exchange_weak(prevMax, ns, std::memory_order_relaxed)) {
+            }
+        }
+    };
+
+    namespace profiling {
+
+        // performance counter ticks
+        inline int64_t timestamp() {
+            LARGE_INTEGER now;
+            QueryPerformanceCounter(&now);
+            return now.QuadPart;
+        }
+
+        // performance counter ticks per second
+        inline int64_t frequency() {
+            static const int64_t freq = []() {
+                LARGE_INTEGER freq;
+                QueryPerformanceFrequency(&freq);
+                return freq.QuadPart;
+            }();
+            return freq;
+        }
+
+        inline uint64_t ticks_to_us(int64_t ticks) {
+            return (uint64_t)(ticks * 1000000 / frequency());
+        }
+
+        // whole seconds and the remainder get converted separately, so that long intervals don't overflow
+        inline uint64_t ticks_to_ns(int64_t ticks) {
+            const int64_t freq = frequency();
+            return (uint64_t)(ticks / freq * 1000000000 + ticks % freq * 1000000000 / freq);
+        }
+
+        // measures the scope if the function is being profiled
+        class call_timer {
+            function_stats& _stats;
+            int64_t _started;
+
+        public:
+
+            explicit call_timer(function_stats& stats)
+                : _stats(stats)
+                , _started(stats.enabled.load(std::memory_order_relaxed) ? timestamp() : 0)
+            {}
+
+            ~call_timer() {
+                if (_started) {
+                    _stats.record(ticks_to_ns(timestamp() - _started));
+                }
+            }
+
+            call_timer(const call_timer&) = delete;
+            call_timer& operator = (const call_timer&) = delete;
+        };
+
+        // enables the functions of the @className, all the functions if the @className is empty.
+        // Returns false if there is no such class
+        bool start(const char *className);
+        // disables all the functions, keeps the recorded statistics
+        void stop();
+        void reset();
+        // writes the statistics of the called functions, ordered by total time. True on success
+        bool dump_to_file(const char *filePath);
+    }
+}
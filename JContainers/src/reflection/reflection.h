@@ -27,6 +27,8 @@ namespace reflection {
 
     typedef function_parameter (*type_info_func)();
 
+    struct function_stats;
+
     typedef void* tes_api_function;
     typedef void* c_function;
 
@@ -47,6 +49,7 @@ namespace reflection {
         parameter_list_creator param_list_func = nullptr;
         tes_api_function tes_func = nullptr; // the function which gets exported into Papyrus (+1 argument, papyrus args only)
         c_function c_func = nullptr; // original function
+        function_stats *stats = nullptr; // call statistics of the @tes_func
         istring argument_names;
         istring name;
         bool _stateless = true;
@@ -3,6 +3,7 @@
 #include "skse/PapyrusNativeFunctions.h"
 #include "skse/string.h"
 #include "reflection/reflection.h"
+#include "reflection/profiling.h"
 
 class BGSListForm;
 
@@ -59,6 +60,15 @@ namespace reflection { namespace binding {
         using tes_type = void;
     };
 
+    // returned game strings get moved, a copy would cost one more game string table call
+    template<> struct GetConv<skse::string_ref> : IdentityConverter < skse::string_ref > {
+        using IdentityConverter < skse::string_ref >::convert2Tes;
+
+        static skse::string_ref convert2Tes(skse::string_ref&& val) {
+            return std::move(val);
+        }
+    };
+
     template<> struct GetConv<const char*> : StringConverter{};
     template<> struct GetConv<std::string> : StringConverter{};
 
@@ -165,11 +175,18 @@ namespace reflection { namespace binding {
                 return func;
             }
 
+            // the statistics get created on registration, before the function can be called
+            static function_stats& stats() {
+                static function_stats s;
+                return s;
+            }
+
             struct non_void_ret {
                 static convert_to_tes_type<R> tes_func(
                     StaticFunctionTag* tag,
                     convert_to_tes_type<Params> ... params)
                 {
+                    profiling::call_timer timer{ stats() };
                     return GetConv<R>::convert2Tes(
                         func(
                             get_converter<Params>::convert2J(params, tag) ...
@@ -183,6 +200,7 @@ namespace reflection { namespace binding {
                     StaticFunctionTag* tag,
                     convert_to_tes_type<Params> ... params)
                 {
+                    profiling::call_timer timer{ stats() };
                     func(get_converter<Params>::convert2J(params, tag) ...);
                 }
             };
@@ -234,11 +252,18 @@ namespace reflection { namespace binding {
                 return func;
             }
 
+            // the statistics get created on registration, before the function can be called
+            static function_stats& stats() {
+                static function_stats s;
+                return s;
+            }
+
             struct non_void_ret {
                 static convert_to_tes_type<R> tes_func(
                     State& state,
                     convert_to_tes_type<Params> ... params)
                 {
+                    profiling::call_timer timer{ stats() };
                     return GetConv<R>::convert2Tes(
                         func(
                             state,
@@ -253,6 +278,7 @@ namespace reflection { namespace binding {
                     State& state,
                     convert_to_tes_type<Params> ... params)
                 {
+                    profiling::call_timer timer{ stats() };
                     func(state, get_converter<Params>::convert2J(params, state) ...);
                 }
             };
@@ -318,6 +344,7 @@ namespace reflection { namespace binding {
             metaF.name = funcname;
             metaF.tes_func = &Binder::tes_func_holder::tes_func;
             metaF.c_func = static_cast<c_function>(Binder::func_ptr());
+            metaF.stats = &Binder::stats();
             metaF._stateless = Binder::base::is_stateless;
 
             info.addFunction(metaF);
@@ -8,13 +8,20 @@
 #include "skse/skse_version.h"
 #include "skse/GameData.h"
 //#include "skse/PapyrusVM.h"
+#include "skse/PapyrusEvents.h"
 #include "skse/GameForms.h"
 #include "skse/GameData.h"
 #include "skse/InternalSerialization.h"
 #include "skse/PluginAPI.h"
 #include "skse/PapyrusVM.h"
 
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
 #include "util/stl_ext.h"
+#include "util/cstring.h"
+#include "util/spinlock.h"
 #include "gtest.h"
 
 #include "forms/form_handling.h"
@@ -44,8 +51,12 @@ namespace skse {
             virtual void release_handle(FormId handle) = 0;
 
             virtual void console_print(const char * fmt, const va_list& args) = 0;
+
+            virtual void send_mod_event(const char * eventName, const char * strArg, float numArg) = 0;
         };
 
+        EventDispatcher<SKSEModCallbackEvent> * g_mod_event_dispatcher = nullptr;
+
         namespace fake_skse {
 
             enum {
@@ -124,6 +135,8 @@ namespace skse {
                 vprintf_s(fmt, args);
                 printf("\n");*/
             }
+
+            void send_mod_event(const char * eventName, const char * strArg, float numArg) override {}
         };
 
         struct skse_silent_api : skse_api {
@@ -134,6 +147,7 @@ namespace skse {
             bool try_retain_handle(FormId handle) override { return true; }
             void release_handle(FormId handle) override {}
             void console_print(const char * fmt, const va_list& args) override {}
+            void send_mod_event(const char * eventName, const char * strArg, float numArg) override {}
         };
 
         struct skse_real_api : skse_api {
@@ -179,6 +193,13 @@ namespace skse {
                     CALL_MEMBER_FN(mgr, Print)(fmt, args);
                 }
             }
+
+            void send_mod_event(const char * eventName, const char * strArg, float numArg) override {
+                if (g_mod_event_dispatcher) {
+                    SKSEModCallbackEvent evn(eventName, strArg, numArg, nullptr);
+                    g_mod_event_dispatcher->SendEvent(&evn);
+                }
+            }
         };
 
         skse_fake_api g_fake_api;
@@ -186,17 +207,101 @@ namespace skse {
         skse_silent_api g_silent_api;
 
         skse_api* g_current_api = &g_fake_api;
+
+        // The load order doesn't change while the game runs, so mod names and indexes get cached:
+        // both are queried per form during JSON export and import.
+        // Unresolved names and indexes (no such mod, game data isn't loaded yet) aren't cached
+        class mod_table {
+
+            struct entry {
+                std::string name;
+                uint8_t index;
+            };
+
+            // names are owned by the game (or by the fake api)
+            std::atomic<const char*> _names[0x100];
+
+            util::spinlock _lock;
+            // keys point into names owned by entries
+            std::unordered_map<util::cstring, std::unique_ptr<entry>, util::cstring_ihash, util::cstring_iequal> _indexes;
+
+        public:
+
+            mod_table() {
+                clear();
+            }
+
+            const char * name(uint8_t idx) {
+                const char *name = _names[idx].load(std::memory_order_acquire);
+                if (!name) {
+                    name = g_current_api->modname_from_index(idx);
+                    if (name) {
+                        _names[idx].store(name, std::memory_order_release);
+                    }
+                }
+                return name;
+            }
+
+            uint8_t index(const char *name) {
+                if (!name) {
+                    return g_current_api->modindex_from_name(name);
+                }
+
+                {
+                    util::spinlock::guard g(_lock);
+                    auto itr = _indexes.find(util::make_cstring(name));
+                    if (itr != _indexes.end()) {
+                        return itr->second->index;
+                    }
+                }
+
+                uint8_t idx = g_current_api->modindex_from_name(name);
+                if (idx != forms::FormGlobalPrefix) {
+                    auto e = std::unique_ptr<entry>(new entry{ name, idx });
+                    auto key = util::make_cstring(e->name.c_str());
+
+                    util::spinlock::guard g(_lock);
+                    _indexes.emplace(key, std::move(e));
+                }
+                return idx;
+            }
+
+            void clear() {
+                for (auto& name : _names) {
+                    name.store(nullptr, std::memory_order_relaxed);
+                }
+                util::spinlock::guard g(_lock);
+                _indexes.clear();
+            }
+        };
+
+        mod_table g_mod_table;
+
+        TEST(mod_table, caches_resolved_names)
+        {
+            mod_table table;
+            EXPECT_TRUE(strcmp(table.name('C'), "C") == 0);
+            EXPECT_TRUE(table.name('C') == table.name('C'));
+            EXPECT_NIL(table.name('|'));
+
+            EXPECT_TRUE(table.index("Cat.esp") == 'C');
+            EXPECT_TRUE(table.index("cAT.ESP") == 'C');
+            EXPECT_TRUE(table.index("|.esp") == forms::FormGlobalPrefix);
+        }
     }
 
 
     void set_real_api() {
         g_current_api = &g_real_api;
+        g_mod_table.clear();
     }
     void set_fake_api() {
         g_current_api = &g_fake_api;
+        g_mod_table.clear();
     }
     void set_silent_api() {
         g_current_api = &g_silent_api;
+        g_mod_table.clear();
     }
 
     FormId resolve_handle(FormId handle) {
@@ -208,11 +313,11 @@ namespace skse {
     }
 
     const char * modname_from_index(uint8_t idx) {
-        return g_current_api->modname_from_index(idx);
+        return g_mod_table.name(idx);
     }
 
     uint8_t modindex_from_name(const char * name) {
-        return g_current_api->modindex_from_name(name);
+        return g_mod_table.index(name);
     }
 
     void console_print(const char * fmt, const va_list& args) {
@@ -226,6 +331,16 @@ namespace skse {
         va_end(args);
     }
 
+    void send_mod_event(const char * eventName, const char * strArg, float numArg) {
+        if (eventName && *eventName) {
+            g_current_api->send_mod_event(eventName, strArg ? strArg : "", numArg);
+        }
+    }
+
+    void set_mod_event_dispatcher(void * dispatcher) {
+        g_mod_event_dispatcher = reinterpret_cast<EventDispatcher<SKSEModCallbackEvent> *>(dispatcher);
+    }
+
     bool try_retain_handle(FormId handle) {
         return g_current_api->try_retain_handle(handle);
     }
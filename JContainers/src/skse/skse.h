@@ -21,6 +21,11 @@ namespace skse {
     void console_print(const char * fmt, ...);
     void console_print(const char * fmt, const va_list& args);
 
+    // sends SKSE ModEvent, the one scripts receive via RegisterForModEvent. Can be called from any thread
+    void send_mod_event(const char * eventName, const char * strArg, float numArg);
+    // SKSE ModEvent dispatcher, obtained from the messaging interface
+    void set_mod_event_dispatcher(void * dispatcher);
+
     void set_real_api();
     void set_fake_api();
     void set_silent_api();
@@ -18,6 +18,7 @@
 
 #include "collections/context.h"
 #include "forms/form_observer.h"
+#include "object/background_worker.h"
 
 #include "domains/domain_master.h"
 
@@ -163,6 +164,7 @@ namespace {
             auto messaging = (SKSEMessagingInterface *)skse->QueryInterface(kInterface_Messaging);
             if (messaging && messaging->interfaceVersion >= SKSEMessagingInterface::kInterfaceVersion) {
                 g_messaging = messaging;
+                skse::set_mod_event_dispatcher(messaging->GetEventDispatcher(SKSEMessagingInterface::kDispatcher_ModEvent));
             }
 
             skse::set_real_api();
@@ -239,7 +241,10 @@ namespace {
             g_serialization->SetLoadCallback(g_pluginHandle, load);
 
             g_serialization->SetFormDeleteCallback(g_pluginHandle, [](UInt64 handle) {
-                domain_master::master::instance().get_form_observer().on_form_deleted((forms::FormHandle)handle);
+                auto& observer = domain_master::master::instance().get_form_observer();
+                if (observer.on_form_deleted((forms::FormHandle)handle)) {
+                    collections::post_to_background_worker([&observer]() { observer.apply_pending_deletions(); });
+                }
             });
 
             g_papyrus->Register(registerAllFunctions);
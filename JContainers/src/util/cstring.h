@@ -1,6 +1,10 @@
 #pragma once
 
+#include <ctype.h>
+#include <string.h>
+
 #include "boost/range/iterator_range_core.hpp"
+#include "boost/functional/hash.hpp"
 
 namespace util {
 
@@ -14,4 +18,34 @@ namespace util {
         return cstr ? boost::make_iterator_range(cstr, cstr + strnlen_s(cstr, limit)) : boost::make_iterator_range_n("", 0);
     }
 
+    // case-sensitive hashing and comparison, for ex. to key unordered containers by paths or JSON texts
+    struct cstring_hash {
+        size_t operator()(const cstring& str) const {
+            return boost::hash_range(str.begin(), str.end());
+        }
+    };
+
+    struct cstring_equal {
+        bool operator()(const cstring& l, const cstring& r) const {
+            return l.size() == r.size() && memcmp(l.begin(), r.begin(), l.size()) == 0;
+        }
+    };
+
+    // case-insensitive hashing and comparison, for ex. to key unordered containers by names
+    struct cstring_ihash {
+        size_t operator()(const cstring& str) const {
+            size_t seed = 0;
+            for (char c : str) {
+                boost::hash_combine(seed, tolower((unsigned char)c));
+            }
+            return seed;
+        }
+    };
+
+    struct cstring_iequal {
+        bool operator()(const cstring& l, const cstring& r) const {
+            return l.size() == r.size() && _strnicmp(l.begin(), r.begin(), l.size()) == 0;
+        }
+    };
+
 }
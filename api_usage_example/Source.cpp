@@ -1,7 +1,8 @@
 /*
     Primitive example which shows how to use SKSE messaging API and interact with JContainers API
 
-    Plugin obtains some JC functionality and registers a function (sortByName) which sorts an jarray of forms by their names
+    Plugin obtains some JC functionality and registers a function (sortByName) which sorts an jarray of forms by their names.
+    The other function (benchmarkAccess) compares Papyrus-shaped function calls with the typed object interface
 */
 
 
@@ -37,6 +38,10 @@ namespace {
     SInt32(*JArray_size)(void*, SInt32 obj) = nullptr;
     TESForm* (*JArray_getForm)(void*, SInt32 obj, SInt32 idx, TESForm* def) = nullptr;
     void (*JArray_swap)(void*, SInt32 obj, SInt32 idx, SInt32 idx2) = nullptr;
+    SInt32(*JArray_getInt)(void*, SInt32 obj, SInt32 idx, SInt32 def) = nullptr;
+
+    // typed access to JContainers objects
+    const jc::object_interface *objects = nullptr;
 
     template<class T>
     void obtain_func(const jc::reflection_interface *refl, const char *funcName, const char *className, T& func) {
@@ -56,6 +61,10 @@ namespace {
         obtain_func(refl, "count", "JArray", JArray_size);
         obtain_func(refl, "getForm", "JArray", JArray_getForm);
         obtain_func(refl, "swapItems", "JArray", JArray_swap);
+        obtain_func(refl, "getInt", "JArray", JArray_getInt);
+
+        // may be null if installed JContainers doesn't provide (this version of) the interface
+        objects = root->query_interface<jc::object_interface>();
 
         default_domain = root->query_interface<jc::domain_interface>()->get_default_domain();
     }
@@ -82,6 +91,63 @@ namespace {
         }  //Bubble Sorting finished
     }
 
+    double seconds_since(const LARGE_INTEGER& started) {
+        LARGE_INTEGER now, frequency;
+        QueryPerformanceCounter(&now);
+        QueryPerformanceFrequency(&frequency);
+        return double(now.QuadPart - started.QuadPart) / frequency.QuadPart;
+    }
+
+    // Sums the integers of the @obj array in three ways, writes the timings to the log
+    void benchmarkAccess(StaticFunctionTag*, SInt32 obj) {
+
+        if (!objects) {
+            _MESSAGE("object interface is not available");
+            return;
+        }
+
+        enum { kRepeats = 100 };
+        LARGE_INTEGER started;
+
+        // Papyrus-shaped functions, obtained by name
+        SInt32 sum = 0;
+        QueryPerformanceCounter(&started);
+        for (int r = 0; r < kRepeats; ++r) {
+            auto count = JArray_size(default_domain, obj);
+            for (SInt32 i = 0; i < count; ++i) {
+                sum += JArray_getInt(default_domain, obj, i, 0);
+            }
+        }
+        _MESSAGE("reflection: sum %d, %f sec", sum, seconds_since(started));
+
+        // typed access by key
+        sum = 0;
+        QueryPerformanceCounter(&started);
+        for (int r = 0; r < kRepeats; ++r) {
+            auto count = objects->count(default_domain, obj);
+            for (SInt32 i = 0; i < count; ++i) {
+                jc::value key = jc::value::of_int(i), result;
+                if (objects->get(default_domain, obj, &key, &result, nullptr, 0) && result.type == jc::value_integer) {
+                    sum += result.int_value;
+                }
+            }
+        }
+        _MESSAGE("object interface, get: sum %d, %f sec", sum, seconds_since(started));
+
+        // bulk iteration, the array gets locked once
+        sum = 0;
+        QueryPerformanceCounter(&started);
+        for (int r = 0; r < kRepeats; ++r) {
+            objects->for_each(default_domain, obj, [](void *data, const jc::value *, const jc::value *val) {
+                if (val->type == jc::value_integer) {
+                    *static_cast<SInt32*>(data) += val->int_value;
+                }
+                return true;
+            }, &sum);
+        }
+        _MESSAGE("object interface, for_each: sum %d, %f sec", sum, seconds_since(started));
+    }
+
     bool registerAllFunctions(VMClassRegistry *registry) {
 
         auto funcName = "sortByName";
@@ -92,6 +158,9 @@ namespace {
 
         registry->SetFunctionFlags(className, funcName, VMClassRegistry::kFunctionFlag_NoWait);
 
+        registry->RegisterFunction(
+            new NativeFunction1 <StaticFunctionTag, void, SInt32>("benchmarkAccess", className, benchmarkAccess, registry));
+
         _MESSAGE("registering functions");
 
         return true;
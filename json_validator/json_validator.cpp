@@ -7,11 +7,41 @@
 #include <jansson/src/jansson.h>
 #include <stdio.h>
 #include <conio.h>
+#include <windows.h>
 #include <boost/filesystem.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
 int errorCounter = 0;
 int filesTotal = 0;
 
+// Outcome of a single file validation
+struct file_report {
+    std::wstring path;
+    double parse_time_ms = 0;
+    // files which can't be opened are skipped
+    bool opened = false;
+    bool parsed = false;
+    json_error_t syntax_error;
+    std::vector<std::string> errors;    // syntax error first, then JContainers-specific issues
+    std::vector<std::string> notes;
+};
+
+std::string to_utf8(const std::wstring& string) {
+    if (string.empty()) {
+        return std::string();
+    }
+
+    int length = WideCharToMultiByte(CP_UTF8, 0, string.c_str(), (int)string.size(), nullptr, 0, nullptr, nullptr);
+    std::string result(length, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, string.c_str(), (int)string.size(), &result[0], length, nullptr, nullptr);
+    return result;
+}
+
 bool is_likely_utf8_bom(FILE *file) {
     if (fseek(file, 0, SEEK_SET) != 0) {
         return false; // error occured, so unk
@@ -24,41 +54,272 @@ bool is_likely_utf8_bom(FILE *file) {
     return bytes_read == 3 && strcmp(bytes, utf8_BOM) == 0;
 }
 
-void validate_file(const _TCHAR *path) {
+// Checks the constructs JContainers gives special meaning to:
+//  - "__metaInfo" (and legacy "__formData") container type info
+//  - "__formData|plugin|0xID" form strings
+//  - "__reference|path" strings, which must resolve to a container within the same file
+class special_constructs_checker {
+
+    json_t *_root;
+    std::vector<std::string>& _errors;
+    std::string _location;
+
+    static const char * kMetaInfo() { return "__metaInfo"; }
+    static const char * kFormData() { return "__formData"; }
+    static const char * kReference() { return "__reference|"; }
+
+    static bool starts_with(const char *str, const char *prefix) {
+        return strncmp(str, prefix, strlen(prefix)) == 0;
+    }
+
+    void error(const char *fmt, const char *value) {
+        char message[512] = { '\0' };
+        _snprintf_s(message, _TRUNCATE, fmt, value);
+        _errors.push_back((_location.empty() ? std::string("<root>") : _location) + ": " + message);
+    }
+
+public:
+
+    special_constructs_checker(json_t *root, std::vector<std::string>& errors) : _root(root), _errors(errors) {}
+
+    static bool is_valid_form_string(const char *string) {
+        // __formData|plugin|0x...
+        const char *pluginBegin = strchr(string, '|');
+        const char *idBegin = pluginBegin ? strchr(pluginBegin + 1, '|') : nullptr;
+        if (!idBegin || !idBegin[1]) {
+            return false;
+        }
+
+        char *end = nullptr;
+        errno = 0;
+        strtoul(idBegin + 1, &end, 0);
+        return errno == 0 && end && *end == '\0';
+    }
+
+    // mirrors JContainers path syntax: .key, [index], [__formData|plugin|0xID]
+    json_t* resolve(const char *path) const {
+        json_t *current = _root;
+
+        while (current && *path) {
+            if (*path == '.') {
+                const char *end = path + 1 + strcspn(path + 1, ".[");
+                if (end == path + 1 || !json_is_object(current)) {
+                    return nullptr;
+                }
+
+                std::string key(path + 1, end);
+                json_t *next = json_object_get(current, key.c_str());
+                if (!next) { // map keys are case-insensitive
+                    const char *k = nullptr;
+                    json_t *v = nullptr;
+                    json_object_foreach(current, k, v) {
+                        if (_stricmp(k, key.c_str()) == 0) {
+                            next = v;
+                            break;
+                        }
+                    }
+                }
+
+                current = next;
+                path = end;
+            }
+            else if (*path == '[') {
+                const char *end = strchr(path, ']');
+                if (!end || end == path + 1) {
+                    return nullptr;
+                }
+
+                std::string key(path + 1, end);
+                if (json_is_array(current)) {
+                    char *numEnd = nullptr;
+                    long index = strtol(key.c_str(), &numEnd, 0);
+                    current = (*numEnd == '\0' && index >= 0) ? json_array_get(current, (size_t)index) : nullptr;
+                }
+                else if (json_is_object(current)) {
+                    // JFormMap keys are stored as is, JIntMap keys as decimal numbers
+                    json_t *next = json_object_get(current, key.c_str());
+                    if (!next && !starts_with(key.c_str(), kFormData())) {
+                        char *numEnd = nullptr;
+                        long index = strtol(key.c_str(), &numEnd, 0);
+                        if (*numEnd == '\0') {
+                            char decimal[32] = { '\0' };
+                            _snprintf_s(decimal, _TRUNCATE, "%ld", index);
+                            next = json_object_get(current, decimal);
+                        }
+                    }
+                    current = next;
+                }
+                else {
+                    return nullptr;
+                }
+
+                path = end + 1;
+            }
+            else {
+                return nullptr;
+            }
+        }
+
+        return current;
+    }
+
+    void check(json_t *value) {
+        switch (json_typeof(value)) {
+        case JSON_OBJECT: {
+            json_t *metaInfo = json_object_get(value, kMetaInfo());
+            const char *typeName = json_string_value(json_object_get(metaInfo, "typeName"));
+            if (metaInfo) {
+                if (!json_is_object(metaInfo) || !typeName) {
+                    error("%s must be an object with 'typeName' string", kMetaInfo());
+                }
+                else if (strcmp(typeName, "JFormMap") != 0 && strcmp(typeName, "JIntMap") != 0) {
+                    error("unknown container type '%s'", typeName);
+                }
+            }
+
+            json_t *legacy = json_object_get(value, kFormData());
+            if (legacy && !json_is_null(legacy) && !json_is_object(legacy)) {
+                error("legacy %s key must be null or an object", kFormData());
+            }
+
+            bool isFormMap = (legacy && json_is_null(legacy)) || (typeName && strcmp(typeName, "JFormMap") == 0);
+            bool isIntMap = typeName && strcmp(typeName, "JIntMap") == 0;
+
+            const char *key = nullptr;
+            json_t *item = nullptr;
+            auto locationLength = _location.size();
+
+            json_object_foreach(value, key, item) {
+                if (strcmp(key, kMetaInfo()) == 0 || strcmp(key, kFormData()) == 0) {
+                    continue;
+                }
+
+                if (isFormMap) {
+                    if (!starts_with(key, kFormData()) || !is_valid_form_string(key)) {
+                        error("invalid JFormMap key '%s'", key);
+                    }
+                    _location.append("[").append(key).append("]");
+                }
+                else if (isIntMap) {
+                    char *end = nullptr;
+                    strtol(key, &end, 0);
+                    if (!*key || *end != '\0') {
+                        error("invalid JIntMap key '%s'", key);
+                    }
+                    _location.append("[").append(key).append("]");
+                }
+                else {
+                    _location.append(".").append(key);
+                }
+
+                check(item);
+                _location.resize(locationLength);
+            }
+        }
+            break;
+        case JSON_ARRAY: {
+            size_t index = 0;
+            json_t *item = nullptr;
+            auto locationLength = _location.size();
+
+            json_array_foreach(value, index, item) {
+                char indexString[32] = { '\0' };
+                _snprintf_s(indexString, _TRUNCATE, "[%u]", (unsigned)index);
+                _location.append(indexString);
+                check(item);
+                _location.resize(locationLength);
+            }
+        }
+            break;
+        case JSON_STRING: {
+            const char *string = json_string_value(value);
+            if (starts_with(string, kFormData())) {
+                if (!is_valid_form_string(string)) {
+                    error("malformed form string '%s'", string);
+                }
+            }
+            else if (starts_with(string, kReference())) {
+                json_t *target = resolve(string + strlen(kReference()));
+                if (!target) {
+                    error("unresolvable reference '%s'", string);
+                }
+                else if (!json_is_object(target) && !json_is_array(target)) {
+                    error("reference '%s' points to a non-container value", string);
+                }
+            }
+        }
+            break;
+        default:
+            break;
+        }
+    }
+};
+
+file_report validate_file(const _TCHAR *path) {
+
+    file_report report;
+    report.path = path;
 
     FILE *file = nullptr;
     errno_t openError = _wfopen_s(&file, path, L"r");
     if (openError || !file) {
-        return ;
+        return report;
     }
 
+    report.opened = true;
+    json_error_t& error = report.syntax_error;
 
-    json_error_t error;
-
+    namespace chr = std::chrono;
+    auto started = chr::high_resolution_clock::now();
     auto json = json_loadf(file, JSON_REJECT_DUPLICATES, &error);
+    report.parse_time_ms = chr::duration_cast<chr::microseconds>(chr::high_resolution_clock::now() - started).count() / 1000.0;
+
     if (!json) {
-        wprintf(L"validation failed: %s\n", path);
-        printf("line %u column %u\n", error.line, error.column);
-        printf("%s\n", error.text);
-        printf("source: %s\n", error.source);
+        char message[JSON_ERROR_TEXT_LENGTH + 64] = { '\0' };
+        _snprintf_s(message, _TRUNCATE, "line %u column %u: %s", error.line, error.column, error.text);
+        report.errors.push_back(message);
 
         if (is_likely_utf8_bom(file)) {
-            printf("likely incorrect encoding. re-save the file using \"UTF-8 without BOM\" encoding format\n");
+            report.notes.push_back("likely incorrect encoding. re-save the file using \"UTF-8 without BOM\" encoding format");
         }
-
-        printf("\n");
-
-        ++errorCounter;
+    }
+    else {
+        report.parsed = true;
+        special_constructs_checker(json, report.errors).check(json);
     }
 
     json_decref(json);
 
     fclose(file);
 
-    ++filesTotal;
+    return report;
 }
 
-void handle_path(_TCHAR *path) {
+void print_report(const file_report& report) {
+    if (report.errors.empty()) {
+        return;
+    }
+
+    wprintf(L"validation failed: %s\n", report.path.c_str());
+
+    auto errors = report.errors.begin();
+    if (!report.parsed) {
+        auto& error = report.syntax_error;
+        printf("line %u column %u\n", error.line, error.column);
+        printf("%s\n", error.text);
+        printf("source: %s\n", error.source);
+        ++errors;
+    }
+    for (; errors != report.errors.end(); ++errors) {
+        printf("%s\n", errors->c_str());
+    }
+    for (auto& note : report.notes) {
+        printf("%s\n", note.c_str());
+    }
+    printf("\n");
+}
+
+void collect_files(const _TCHAR *path, std::vector<std::wstring>& files) {
     namespace fs = boost::filesystem;
 
     if (!path || !fs::exists( path )) {
@@ -66,7 +327,7 @@ void handle_path(_TCHAR *path) {
     }
 
     if (fs::is_regular_file(path)) {
-        validate_file(path);
+        files.push_back(path);
         return;
     }
 
@@ -78,35 +339,156 @@ void handle_path(_TCHAR *path) {
 
         if ( fs::is_regular_file( *itr ) ) {
 
-            validate_file(itr->path().c_str());
+            files.push_back(itr->path().wstring());
+        }
+    }
+
+}
+
+// Validates the files using @threadCount threads. Reports are stored in the same order as the files
+std::vector<file_report> validate_files(const std::vector<std::wstring>& files, unsigned threadCount) {
+    std::vector<file_report> reports(files.size());
+    std::atomic<size_t> nextFile(0);
+
+    // hashtable seed initialization is not thread safe, do it before any thread creates an object
+    json_object_seed(0);
+
+    auto worker = [&]() {
+        for (size_t idx = nextFile++; idx < files.size(); idx = nextFile++) {
+            reports[idx] = validate_file(files[idx].c_str());
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    return reports;
+}
+
+// Machine-readable summary: totals plus per-file status and parse time
+void write_summary(const std::vector<file_report>& reports, double totalTimeMs, FILE *output) {
+    json_t *summary = json_object();
+    json_t *files = json_array();
+    int failed = 0;
+
+    for (auto& report : reports) {
+        if (!report.opened) {
+            continue;
+        }
+
+        json_t *entry = json_object();
+        json_t *errors = json_array();
+
+        for (auto& error : report.errors) {
+            json_array_append_new(errors, json_string(error.c_str()));
+        }
+        for (auto& note : report.notes) {
+            json_array_append_new(errors, json_string(note.c_str()));
         }
+
+        failed += report.errors.empty() ? 0 : 1;
+
+        json_object_set_new(entry, "path", json_string(to_utf8(report.path).c_str()));
+        json_object_set_new(entry, "valid", json_boolean(report.errors.empty()));
+        json_object_set_new(entry, "parsed", json_boolean(report.parsed));
+        json_object_set_new(entry, "parseTimeMs", json_real(report.parse_time_ms));
+        json_object_set_new(entry, "errors", errors);
+        json_array_append_new(files, entry);
     }
 
+    json_object_set_new(summary, "filesTotal", json_integer(filesTotal));
+    json_object_set_new(summary, "filesFailed", json_integer(failed));
+    json_object_set_new(summary, "totalTimeMs", json_real(totalTimeMs));
+    json_object_set_new(summary, "files", files);
+
+    json_dumpf(summary, output, JSON_INDENT(2) | JSON_PRESERVE_ORDER);
+    fprintf(output, "\n");
+    json_decref(summary);
 }
 
 #define STR(...) #__VA_ARGS__
 
+#define BATCH_USAGE \
+    "batch mode: json_validator --batch [--threads N] [--summary output.json] paths...\n" \
+    "validates files in parallel, does not wait for a key press and writes JSON summary into the output file or stdout"
+
 int _tmain(int argc, _TCHAR* argv[])
 {
-    if (argc > 1) {
-        int i = 1;
-
-        while (i < argc) {
-            _TCHAR *path = argv[i];
+    bool batchMode = false;
+    unsigned threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+    const _TCHAR *summaryPath = nullptr;
+    std::vector<std::wstring> files;
 
-            handle_path(path);
+    for (int i = 1; i < argc; ++i) {
+        const _TCHAR *arg = argv[i];
 
-            ++i;
+        if (wcscmp(arg, L"--batch") == 0) {
+            batchMode = true;
+        }
+        else if (wcscmp(arg, L"--threads") == 0 && i + 1 < argc) {
+            threadCount = (std::max)(1, _wtoi(argv[++i]));
+        }
+        else if (wcscmp(arg, L"--summary") == 0 && i + 1 < argc) {
+            summaryPath = argv[++i];
+        }
+        else {
+            collect_files(arg, files);
         }
+    }
 
-        printf("%u errors found. %u files total\n", errorCounter, filesTotal);
+    if (files.empty() && argc <= 1) {
+        printf(APP_DESCRIPTION"\n");
+        printf(BATCH_USAGE"\n");
     }
     else {
-        printf(APP_DESCRIPTION"\n");
+        namespace chr = std::chrono;
+        auto started = chr::high_resolution_clock::now();
+        auto reports = validate_files(files, batchMode ? threadCount : 1);
+        double totalTimeMs = chr::duration_cast<chr::microseconds>(chr::high_resolution_clock::now() - started).count() / 1000.0;
+
+        for (auto& report : reports) {
+            if (report.opened) {
+                errorCounter += report.errors.empty() ? 0 : 1;
+                ++filesTotal;
+            }
+        }
+
+        if (!batchMode) {
+            for (auto& report : reports) {
+                print_report(report);
+            }
+        }
+        else {
+            FILE *summaryFile = nullptr;
+            if (summaryPath && (_wfopen_s(&summaryFile, summaryPath, L"w") != 0 || !summaryFile)) {
+                wprintf(L"can't open summary file %s\n", summaryPath);
+                summaryFile = nullptr;
+            }
+
+            write_summary(reports, totalTimeMs, summaryFile ? summaryFile : stdout);
+
+            if (summaryFile) {
+                fclose(summaryFile);
+            }
+        }
+
+        // keep stdout clean when the summary is written there
+        FILE *statusOutput = (batchMode && !summaryPath) ? stderr : stdout;
+        fprintf(statusOutput, "%u errors found. %u files total\n", errorCounter, filesTotal);
     }
 
-    printf("press any key to close\n");
-    _getch();
-	return 0;
-}
+    if (!batchMode) {
+        printf("press any key to close\n");
+        _getch();
+    }
 
+    // non-zero exit code lets build scripts fail on invalid files
+    return (batchMode && errorCounter > 0) ? 1 : 0;
+}